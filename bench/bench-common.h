@@ -0,0 +1,159 @@
+/*
+ * bench-common.h
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+#ifndef ALGORITHMS_C_BENCH_COMMON_H_
+#define ALGORITHMS_C_BENCH_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <sys/resource.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TIMER_NAME "rdtsc"
+#else
+#define BENCH_TIMER_NAME "clock_gettime"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * helpers shared by the benchmarks in bench/,
+ * all the numbers are written to stdout as one JSON object per line.
+************************************/
+
+// splitmix64, the generated graphs and queries only depend on the seed
+struct bench_rng
+{
+	uint64_t state;
+};
+static inline uint64_t bench_rng_next(struct bench_rng * rng)
+{
+	uint64_t z = (rng->state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+static inline uint32_t bench_rng_uniform(struct bench_rng * rng, uint32_t upper)	// [0, upper)
+{
+	return (uint32_t)(((bench_rng_next(rng) >> 32) * upper) >> 32);
+}
+static inline double bench_rng_double(struct bench_rng * rng)	// [0, 1)
+{
+	return (bench_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline int64_t bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// TSC ticks on x86, nanoseconds elsewhere
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_lfence();	// do not let rdtsc move ahead of the measured code
+	uint64_t cycles = __rdtsc();
+	_mm_lfence();
+	return cycles;
+#else
+	return (uint64_t)bench_now_ns();
+#endif
+}
+
+static inline long bench_peak_rss_kb(void)
+{
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage)) return -1;
+	return usage.ru_maxrss;
+}
+
+static inline int bench_compare_i64(const void * a, const void * b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+// nearest-rank percentile, samples must be sorted
+static inline int64_t bench_percentile(const int64_t * samples, size_t count, double percent)
+{
+	if(0 == count) return 0;
+	size_t rank = (size_t)(percent / 100.0 * count + 0.5);
+	if(rank > 0) --rank;
+	if(rank >= count) rank = count - 1;
+	return samples[rank];
+}
+
+struct bench_summary
+{
+	double min;
+	double median;
+	double mean;
+	double stddev;
+};
+
+// sorts samples in place
+static inline struct bench_summary bench_summarize(double * samples, size_t count)
+{
+	struct bench_summary summary = { 0 };
+	if(0 == count) return summary;
+	for(size_t i = 1; i < count; ++i) {	// insertion sort, there are only a few trials
+		double value = samples[i];
+		size_t j = i;
+		for(; j > 0 && samples[j - 1] > value; --j) samples[j] = samples[j - 1];
+		samples[j] = value;
+	}
+	
+	double sum = 0;
+	for(size_t i = 0; i < count; ++i) sum += samples[i];
+	summary.min = samples[0];
+	summary.mean = sum / count;
+	summary.median = (count & 1)?samples[count / 2]:(samples[count / 2 - 1] + samples[count / 2]) / 2;
+	
+	double variance = 0;
+	for(size_t i = 0; i < count; ++i) variance += (samples[i] - summary.mean) * (samples[i] - summary.mean);
+	summary.stddev = (count > 1)?sqrt(variance / (count - 1)):0;
+	return summary;
+}
+
+static inline void bench_summary_print_json(FILE * fp, const char * name, const struct bench_summary * summary)
+{
+	fprintf(fp, "\"%s\":{\"min\":%.3f,\"median\":%.3f,\"mean\":%.3f,\"stddev\":%.3f}",
+		name, summary->min, summary->median, summary->mean, summary->stddev);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
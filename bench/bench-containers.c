@@ -0,0 +1,401 @@
+/*
+ * bench-containers.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <getopt.h>
+
+#include "algorithms-c-common.h"
+#include "bench-common.h"
+
+/************************************
+ * bench-containers:
+ *   microbenchmarks of the src/base containers at sizes 10, 100, ..., max_size.
+ *   each (container, op, size) runs warmup trials then timed trials,
+ *   a trial repeats the op until about min_ops elements (min_ops list steps for the sorted list) are processed,
+ *   setup and teardown are not timed.
+ *   one JSON line per (container, op, size): ns/op and cycles/op (min / median / mean / stddev over trials)
+************************************/
+
+struct bench_state
+{
+	size_t size;
+	void ** keys;	// [size], random, for the sorted list
+	
+	struct clib_pointer_array array[1];
+	struct clib_circular_array circular[1];
+	struct clib_stack stack[1];
+	struct clib_queue queue[1];
+	struct clib_slist list[1];
+	struct clib_sorted_list sorted[1];
+};
+
+static volatile uintptr_t s_sink;
+
+#define BENCH_DATA(i) ((void *)(uintptr_t)((i) + 1))
+
+/***************************************
+ * clib_pointer_array
+***************************************/
+static void array_setup(struct bench_state * state)
+{
+	clib_pointer_array_init(state->array, 0);
+}
+static void array_fill(struct bench_state * state)
+{
+	array_setup(state);
+	clib_pointer_array_set_length(state->array, state->size);
+	for(size_t i = 0; i < state->size; ++i) state->array->data_ptrs[i] = BENCH_DATA(i);
+}
+static void array_teardown(struct bench_state * state)
+{
+	clib_pointer_array_cleanup(state->array, NULL);
+}
+static void array_append(struct bench_state * state)
+{
+	struct clib_pointer_array * array = state->array;
+	for(size_t i = 0; i < state->size; ++i) {
+		clib_pointer_array_resize(array, array->length + 1);
+		array->data_ptrs[array->length++] = BENCH_DATA(i);
+	}
+}
+static void array_iterate(struct bench_state * state)
+{
+	uintptr_t sum = 0;
+	for(size_t i = 0; i < state->array->length; ++i) sum += (uintptr_t)state->array->data_ptrs[i];
+	s_sink = sum;
+}
+
+/***************************************
+ * clib_circular_array
+***************************************/
+static void circular_setup(struct bench_state * state)
+{
+	clib_circular_array_init(state->circular, state->size, NULL);
+}
+static void circular_fill(struct bench_state * state)
+{
+	circular_setup(state);
+	for(size_t i = 0; i < state->size; ++i) state->circular->append(state->circular, BENCH_DATA(i));
+}
+static void circular_teardown(struct bench_state * state)
+{
+	clib_circular_array_cleanup(state->circular, NULL);
+}
+static void circular_append(struct bench_state * state)	// wraps around once
+{
+	for(size_t i = 0; i < state->size; ++i) state->circular->append(state->circular, BENCH_DATA(i));
+}
+static void circular_get(struct bench_state * state)
+{
+	uintptr_t sum = 0;
+	for(size_t i = 0; i < state->circular->length; ++i) sum += (uintptr_t)state->circular->get(state->circular, i);
+	s_sink = sum;
+}
+
+/***************************************
+ * clib_stack
+***************************************/
+static void stack_setup(struct bench_state * state)
+{
+	memset(state->stack, 0, sizeof(state->stack));
+	clib_stack_init(state->stack, 0);
+}
+static void stack_fill(struct bench_state * state)
+{
+	stack_setup(state);
+	for(size_t i = 0; i < state->size; ++i) state->stack->push(state->stack, BENCH_DATA(i));
+}
+static void stack_teardown(struct bench_state * state)
+{
+	clib_stack_clear(state->stack, NULL);
+}
+static void stack_push(struct bench_state * state)
+{
+	for(size_t i = 0; i < state->size; ++i) state->stack->push(state->stack, BENCH_DATA(i));
+}
+static void stack_pop(struct bench_state * state)
+{
+	uintptr_t sum = 0;
+	void * data = NULL;
+	while(0 == state->stack->pop(state->stack, &data)) sum += (uintptr_t)data;
+	s_sink = sum;
+}
+
+/***************************************
+ * clib_queue
+***************************************/
+static void queue_setup(struct bench_state * state)
+{
+	clib_queue_init(state->queue);
+}
+static void queue_fill(struct bench_state * state)
+{
+	queue_setup(state);
+	for(size_t i = 0; i < state->size; ++i) state->queue->enter(state->queue, BENCH_DATA(i));
+}
+static void queue_teardown(struct bench_state * state)
+{
+	clib_queue_clear(state->queue, NULL);
+}
+static void queue_enter(struct bench_state * state)
+{
+	for(size_t i = 0; i < state->size; ++i) state->queue->enter(state->queue, BENCH_DATA(i));
+}
+static void queue_leave(struct bench_state * state)
+{
+	uintptr_t sum = 0;
+	void * data = NULL;
+	while((data = state->queue->leave(state->queue))) sum += (uintptr_t)data;
+	s_sink = sum;
+}
+
+/***************************************
+ * clib_slist
+***************************************/
+static void slist_setup(struct bench_state * state)
+{
+	memset(state->list, 0, sizeof(state->list));
+}
+static void slist_fill(struct bench_state * state)
+{
+	slist_setup(state);
+	for(size_t i = 0; i < state->size; ++i) clib_slist_push(state->list, BENCH_DATA(i));
+}
+static void slist_teardown(struct bench_state * state)
+{
+	clib_slist_clear(state->list, NULL);
+}
+static void slist_push(struct bench_state * state)
+{
+	for(size_t i = 0; i < state->size; ++i) clib_slist_push(state->list, BENCH_DATA(i));
+}
+static void slist_iterate(struct bench_state * state)
+{
+	uintptr_t sum = 0;
+	clib_list_iterator_t iter;
+	memset(&iter, 0, sizeof(iter));
+	while(clib_slist_iter_next(state->list, &iter)) sum += (uintptr_t)clib_list_iterator_get_data(iter);
+	s_sink = sum;
+}
+static void slist_reverse(struct bench_state * state)
+{
+	clib_slist_reverse(state->list);
+}
+
+/***************************************
+ * clib_sorted_list
+***************************************/
+static void sorted_setup(struct bench_state * state)
+{
+	clib_sorted_list_init(state->sorted, NULL, NULL);
+}
+static void sorted_fill(struct bench_state * state)
+{
+	sorted_setup(state);
+	for(size_t i = 0; i < state->size; ++i) state->sorted->add(state->sorted, state->keys[i]);
+}
+static void sorted_teardown(struct bench_state * state)
+{
+	clib_sorted_list_clear(state->sorted);
+}
+static void sorted_add(struct bench_state * state)
+{
+	for(size_t i = 0; i < state->size; ++i) state->sorted->add(state->sorted, state->keys[i]);
+}
+static void sorted_find(struct bench_state * state)
+{
+	uintptr_t found = 0;
+	clib_list_iterator_t iter;
+	for(size_t i = 0; i < state->size; ++i) {
+		found += (1 == state->sorted->find(state->sorted, state->keys[(i * 7) % state->size], &iter, NULL));
+	}
+	assert(found == state->size);
+	s_sink = found;
+}
+
+struct bench_case
+{
+	const char * container;
+	const char * op;
+	int quadratic;	// O(size) per op, limited to max_quadratic_size
+	void (* setup)(struct bench_state * state);
+	void (* run)(struct bench_state * state);	// timed, processes state->size elements
+	void (* teardown)(struct bench_state * state);
+};
+
+static const struct bench_case s_cases[] = {
+	{ "pointer_array", "append", 0, array_setup, array_append, array_teardown },
+	{ "pointer_array", "iterate", 0, array_fill, array_iterate, array_teardown },
+	{ "circular_array", "append", 0, circular_fill, circular_append, circular_teardown },
+	{ "circular_array", "get", 0, circular_fill, circular_get, circular_teardown },
+	{ "stack", "push", 0, stack_setup, stack_push, stack_teardown },
+	{ "stack", "pop", 0, stack_fill, stack_pop, stack_teardown },
+	{ "queue", "enter", 0, queue_setup, queue_enter, queue_teardown },
+	{ "queue", "leave", 0, queue_fill, queue_leave, queue_teardown },
+	{ "slist", "push", 0, slist_setup, slist_push, slist_teardown },
+	{ "slist", "iterate", 0, slist_fill, slist_iterate, slist_teardown },
+	{ "slist", "reverse", 0, slist_fill, slist_reverse, slist_teardown },
+	{ "sorted_list", "add", 1, sorted_setup, sorted_add, sorted_teardown },
+	{ "sorted_list", "find", 1, sorted_fill, sorted_find, sorted_teardown },
+};
+
+struct bench_options
+{
+	size_t min_size;
+	size_t max_size;
+	size_t max_quadratic_size;
+	size_t min_ops;	// elements per trial
+	int warmup;
+	int trials;
+	const char * filter;	// container name, NULL: all
+};
+
+static void run_case(const struct bench_case * bench, struct bench_state * state, const struct bench_options * options)
+{
+	size_t size = state->size;
+	size_t work = bench->quadratic?(size * size / 2):size;
+	size_t repeats = (options->min_ops + work - 1) / work;
+	double * ns_samples = calloc(options->trials, sizeof(*ns_samples));
+	double * cycles_samples = calloc(options->trials, sizeof(*cycles_samples));
+	assert(ns_samples && cycles_samples);
+	
+	for(int trial = -options->warmup; trial < options->trials; ++trial) {
+		int64_t ns = 0;
+		uint64_t cycles = 0;
+		for(size_t i = 0; i < repeats; ++i) {
+			bench->setup(state);
+			int64_t begin_ns = bench_now_ns();
+			uint64_t begin_cycles = bench_cycles();
+			bench->run(state);
+			cycles += bench_cycles() - begin_cycles;
+			ns += bench_now_ns() - begin_ns;
+			bench->teardown(state);
+		}
+		if(trial < 0) continue;
+		ns_samples[trial] = (double)ns / (repeats * size);
+		cycles_samples[trial] = (double)cycles / (repeats * size);
+	}
+	
+	struct bench_summary ns_summary = bench_summarize(ns_samples, options->trials);
+	struct bench_summary cycles_summary = bench_summarize(cycles_samples, options->trials);
+	printf("{\"benchmark\":\"containers\",\"container\":\"%s\",\"op\":\"%s\",\"size\":%zu,"
+		"\"trials\":%d,\"repeats\":%zu,\"timer\":\"%s\",",
+		bench->container, bench->op, size, options->trials, repeats, BENCH_TIMER_NAME);
+	bench_summary_print_json(stdout, "ns_per_op", &ns_summary);
+	printf(",");
+	bench_summary_print_json(stdout, "cycles_per_op", &cycles_summary);
+	printf("}\n");
+	fflush(stdout);
+	
+	free(ns_samples);
+	free(cycles_samples);
+}
+
+static void print_usage(const char * prog_name)
+{
+	fprintf(stderr, "usage: %s [--min-size N] [--max-size N] [--max-quadratic-size N]\n"
+		"\t[--trials T] [--warmup W] [--min-ops N] [--seed S] [--container NAME]\n", prog_name);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_options options = {
+		.min_size = 10,
+		.max_size = 10000000,
+		.max_quadratic_size = 10000,
+		.min_ops = 1000000,
+		.warmup = 1,
+		.trials = 5,
+	};
+	uint64_t seed = 1;
+	
+	static const struct option long_options[] = {
+		{"min-size", required_argument, NULL, 'm'},
+		{"max-size", required_argument, NULL, 'n'},
+		{"max-quadratic-size", required_argument, NULL, 'Q'},
+		{"trials", required_argument, NULL, 't'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"min-ops", required_argument, NULL, 'o'},
+		{"seed", required_argument, NULL, 's'},
+		{"container", required_argument, NULL, 'c'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL},
+	};
+	int c;
+	while((c = getopt_long(argc, argv, "m:n:Q:t:w:o:s:c:h", long_options, NULL)) != -1) {
+		switch(c) {
+		case 'm': options.min_size = strtoull(optarg, NULL, 10); break;
+		case 'n': options.max_size = strtoull(optarg, NULL, 10); break;
+		case 'Q': options.max_quadratic_size = strtoull(optarg, NULL, 10); break;
+		case 't': options.trials = atoi(optarg); break;
+		case 'w': options.warmup = atoi(optarg); break;
+		case 'o': options.min_ops = strtoull(optarg, NULL, 10); break;
+		case 's': seed = strtoull(optarg, NULL, 10); break;
+		case 'c': options.filter = optarg; break;
+		default: print_usage(argv[0]); return (c == 'h')?0:1;
+		}
+	}
+	if(options.min_size < 1 || options.trials < 1 || options.warmup < 0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	
+	struct bench_state state[1];
+	memset(state, 0, sizeof(state));
+	
+	for(size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); ++i) {
+		const struct bench_case * bench = &s_cases[i];
+		if(options.filter && strcmp(options.filter, bench->container)) continue;
+		
+		size_t max_size = options.max_size;
+		if(bench->quadratic && max_size > options.max_quadratic_size) max_size = options.max_quadratic_size;
+		for(size_t size = options.min_size; size <= max_size; size *= 10) {
+			state->size = size;
+			// a shuffle of distinct keys, the order only depends on the seed
+			if(bench->quadratic) {
+				struct bench_rng rng = { seed };
+				state->keys = realloc(state->keys, size * sizeof(*state->keys));
+				assert(state->keys);
+				for(size_t k = 0; k < size; ++k) state->keys[k] = BENCH_DATA(k);
+				for(size_t k = size - 1; k > 0; --k) {
+					size_t j = bench_rng_uniform(&rng, (uint32_t)(k + 1));
+					void * tmp = state->keys[k];
+					state->keys[k] = state->keys[j];
+					state->keys[j] = tmp;
+				}
+			}
+			run_case(bench, state, &options);
+		}
+	}
+	free(state->keys);
+	return 0;
+}
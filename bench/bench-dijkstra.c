@@ -0,0 +1,494 @@
+/*
+ * bench-dijkstra.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <math.h>
+#include <getopt.h>
+
+#include "algorithms-c-common.h"
+#include "dijkstra.h"
+#include "dijkstra-reorder.h"
+#include "dijkstra-compressed.h"
+#include "bench-common.h"
+
+/************************************
+ * bench-dijkstra:
+ *   builds a reproducible synthetic graph and runs random (src_id, dst_id) queries
+ *   through dijkstra->shortest_path(), the results are written to stdout as one JSON line.
+ *
+ * graphs:
+ *   gnm:  G(n, m), m = n * degree random directed edges, weight in [1, 1000]
+ *   grid: sqrt(n) x sqrt(n) grid, 4-neighbours in both directions, weight in [1, 1000]
+ *   rmat: R-MAT (a, b, c, d) = (0.57, 0.19, 0.19, 0.05), n is rounded up to a power of 2
+ *   ln:   Barabasi-Albert scale-free graph of bidirectional channels,
+ *         LN-like fees (base + ppm) and capacities, searched with calc_weight / calc_amount
+ *   ba:   the same power-law topology as ln (a few hubs with thousands of channels),
+ *         weights only (in [1, 1000]), so it also runs with --compressed
+ *
+ * --reorder bfs|rcm|degree: the queries run on a dijkstra_reordered_graph (same random queries, original ids).
+ * --compressed [--weight-shift S]: the queries run on a dijkstra_compressed_graph (binary-heap dijkstra, 
+ *   forward only, not for ln), built after the reordering if any.
+ * --distance-bits 64: always use 64-bit distances (default: 32-bit when the weights fit, never for ln).
+ * built with -DDIJKSTRA_ENABLE_STATS (make bench BENCH_STATS=1), the per-query counters are added as "stats".
+************************************/
+
+#define MILLION (1000 * 1000)
+
+struct bench_fee
+{
+	int64_t ppm;
+	int64_t base;
+};
+
+static int64_t calc_weight(int64_t amount, void * user_data)
+{
+	const struct bench_fee * fee = user_data;
+	return amount * fee->ppm / MILLION + fee->base;
+}
+
+static int64_t calc_amount(int64_t amount, void * user_data)
+{
+	const struct bench_fee * fee = user_data;
+	return amount + amount * fee->ppm / MILLION + fee->base;
+}
+
+struct bench_graph
+{
+	const char * name;
+	uint32_t num_vertices;
+	struct dijkstra_vertex * vertices;
+	struct dijkstra_edges edges[1];
+	struct dijkstra_graph graph[1];
+	
+	size_t num_fees;
+	struct bench_fee * fees;	// ln only, edge->user_data
+};
+
+static inline void add_edge(struct bench_graph * g, struct bench_rng * rng, uint32_t src_id, uint32_t dst_id)
+{
+	if(src_id == dst_id) return;
+	g->edges->update(g->edges, src_id, dst_id, 1 + bench_rng_uniform(rng, 1000));
+}
+
+static void gen_gnm(struct bench_graph * g, struct bench_rng * rng, uint32_t degree)
+{
+	size_t num_edges = (size_t)g->num_vertices * degree;
+	for(size_t i = 0; i < num_edges; ++i) {
+		add_edge(g, rng, bench_rng_uniform(rng, g->num_vertices), bench_rng_uniform(rng, g->num_vertices));
+	}
+}
+
+static void gen_grid(struct bench_graph * g, struct bench_rng * rng, uint32_t width)
+{
+	for(uint32_t y = 0; y < width; ++y) {
+		for(uint32_t x = 0; x < width; ++x) {
+			uint32_t id = y * width + x;
+			if(x + 1 < width) {
+				add_edge(g, rng, id, id + 1);
+				add_edge(g, rng, id + 1, id);
+			}
+			if(y + 1 < width) {
+				add_edge(g, rng, id, id + width);
+				add_edge(g, rng, id + width, id);
+			}
+		}
+	}
+}
+
+static void gen_rmat(struct bench_graph * g, struct bench_rng * rng, uint32_t degree)
+{
+	static const double a = 0.57, b = 0.19, c = 0.19;
+	size_t num_edges = (size_t)g->num_vertices * degree;
+	for(size_t i = 0; i < num_edges; ++i) {
+		uint32_t src_id = 0, dst_id = 0;
+		for(uint32_t bit = g->num_vertices >> 1; bit > 0; bit >>= 1) {
+			double r = bench_rng_double(rng);
+			if(r < a) continue;
+			if(r < a + b) dst_id |= bit;
+			else if(r < a + b + c) src_id |= bit;
+			else { src_id |= bit; dst_id |= bit; }
+		}
+		add_edge(g, rng, src_id, dst_id);
+	}
+}
+
+static double rng_normal(struct bench_rng * rng)
+{
+	double u1 = 1.0 - bench_rng_double(rng);	// (0, 1]
+	double u2 = bench_rng_double(rng);
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static void add_channel_direction(struct bench_graph * g, struct bench_rng * rng, uint32_t src_id, uint32_t dst_id, int64_t capacity)
+{
+	struct bench_fee * fee = &g->fees[g->num_fees++];
+	double r = bench_rng_double(rng);
+	if(r < 0.5) fee->base = 1000;
+	else if(r < 0.75) fee->base = 0;
+	else fee->base = bench_rng_uniform(rng, 5000);
+	
+	double ppm = exp(4.5 + 1.5 * rng_normal(rng));	// median ~90 ppm, long tail
+	fee->ppm = (ppm > 5000)?5000:(int64_t)ppm;
+	
+	struct dijkstra_sparse_edge * edge = g->edges->update(g->edges, src_id, dst_id, fee->base + fee->ppm);
+	edge->user_data = fee;
+	g->edges->set_capacity(g->edges, src_id, dst_id, capacity, 0, capacity);
+}
+
+// ln (with_fees) or ba
+static void gen_scale_free(struct bench_graph * g, struct bench_rng * rng, uint32_t degree, int with_fees)
+{
+	// each new vertex opens k channels, the peers are chosen with probability proportional to their degree
+	uint32_t k = degree / 2;
+	if(k < 1) k = 1;
+	uint32_t num_seeds = k + 1;
+	if(num_seeds > g->num_vertices) num_seeds = g->num_vertices;
+	
+	size_t max_channels = (size_t)g->num_vertices * k + (size_t)num_seeds * num_seeds;
+	if(with_fees) {
+		g->fees = calloc(max_channels * 2, sizeof(*g->fees));
+		assert(g->fees);
+	}
+	uint32_t * endpoints = calloc(max_channels * 2, sizeof(*endpoints));
+	assert(endpoints);
+	size_t num_endpoints = 0;
+	
+	for(uint32_t v = 0; v < g->num_vertices; ++v) {
+		uint32_t num_peers = (v < num_seeds)?v:k;
+		for(uint32_t i = 0; i < num_peers; ++i) {
+			uint32_t peer = (v < num_seeds)?i:endpoints[bench_rng_uniform(rng, num_endpoints)];
+			if(peer == v || g->edges->find(g->edges, v, peer)) continue;
+			
+			if(with_fees) {
+				int64_t capacity = (int64_t)exp(log(2000000.0) + 1.5 * rng_normal(rng));
+				add_channel_direction(g, rng, v, peer, capacity);
+				add_channel_direction(g, rng, peer, v, capacity);
+			}else {
+				add_edge(g, rng, v, peer);
+				add_edge(g, rng, peer, v);
+			}
+			endpoints[num_endpoints++] = v;
+			endpoints[num_endpoints++] = peer;
+		}
+	}
+	free(endpoints);
+}
+
+static struct bench_graph * bench_graph_init(struct bench_graph * g, const char * name, 
+	uint32_t num_vertices, uint32_t degree, uint64_t seed)
+{
+	memset(g, 0, sizeof(*g));
+	struct bench_rng rng = { seed };
+	
+	uint32_t width = 0;
+	if(0 == strcmp(name, "grid")) {
+		width = (uint32_t)ceil(sqrt((double)num_vertices));
+		num_vertices = width * width;
+	}else if(0 == strcmp(name, "rmat")) {
+		uint32_t n = 1;
+		while(n < num_vertices) n <<= 1;
+		num_vertices = n;
+	}else if(strcmp(name, "gnm") && strcmp(name, "ln") && strcmp(name, "ba")) {
+		return NULL;
+	}
+	
+	g->name = name;
+	g->num_vertices = num_vertices;
+	g->vertices = calloc(num_vertices, sizeof(*g->vertices));
+	assert(g->vertices);
+	for(uint32_t i = 0; i < num_vertices; ++i) g->vertices[i].id = i;
+	
+	dijkstra_edges_init(g->edges, 1, num_vertices);
+	if(width) gen_grid(g, &rng, width);
+	else if(0 == strcmp(name, "rmat")) gen_rmat(g, &rng, degree);
+	else if(0 == strcmp(name, "ln")) gen_scale_free(g, &rng, degree, 1);
+	else if(0 == strcmp(name, "ba")) gen_scale_free(g, &rng, degree, 0);
+	else gen_gnm(g, &rng, degree);
+	
+	g->graph->num_vertices = num_vertices;
+	g->graph->vertices = g->vertices;
+	g->graph->edges = g->edges;
+	return g;
+}
+
+static void bench_graph_cleanup(struct bench_graph * g)
+{
+	dijkstra_edges_cleanup(g->edges);
+	free(g->vertices);
+	free(g->fees);
+	memset(g, 0, sizeof(*g));
+}
+
+static void print_usage(const char * prog_name)
+{
+	fprintf(stderr, "usage: %s [--graph gnm|grid|rmat|ln|ba] [--vertices N] [--degree D]\n"
+		"\t[--queries Q] [--seed S] [--amount A] [--reverse] [--reorder none|bfs|rcm|degree]\n"
+		"\t[--compressed [--weight-shift S]] [--distance-bits 32|64]\n", prog_name);
+}
+
+int main(int argc, char **argv)
+{
+	const char * graph_name = "gnm";
+	uint32_t num_vertices = 10000;
+	uint32_t degree = 8;
+	uint32_t num_queries = 200;
+	uint64_t seed = 1;
+	int64_t amount = -1;	// default: 100000 for ln, otherwise 0 (no capacity check)
+	int reverse = 0;
+	const char * reorder_name = "none";
+	int compressed = 0;
+	int weight_shift = 0;
+	int distance_bits = 0;
+	
+	static const struct option options[] = {
+		{"graph", required_argument, NULL, 'g'},
+		{"vertices", required_argument, NULL, 'n'},
+		{"degree", required_argument, NULL, 'd'},
+		{"queries", required_argument, NULL, 'q'},
+		{"seed", required_argument, NULL, 's'},
+		{"amount", required_argument, NULL, 'a'},
+		{"reverse", no_argument, NULL, 'r'},
+		{"reorder", required_argument, NULL, 'o'},
+		{"compressed", no_argument, NULL, 'c'},
+		{"weight-shift", required_argument, NULL, 'w'},
+		{"distance-bits", required_argument, NULL, 'b'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL},
+	};
+	int c;
+	while((c = getopt_long(argc, argv, "g:n:d:q:s:a:ro:cw:b:h", options, NULL)) != -1) {
+		switch(c) {
+		case 'g': graph_name = optarg; break;
+		case 'n': num_vertices = strtoul(optarg, NULL, 10); break;
+		case 'd': degree = strtoul(optarg, NULL, 10); break;
+		case 'q': num_queries = strtoul(optarg, NULL, 10); break;
+		case 's': seed = strtoull(optarg, NULL, 10); break;
+		case 'a': amount = strtoll(optarg, NULL, 10); break;
+		case 'r': reverse = 1; break;
+		case 'o': reorder_name = optarg; break;
+		case 'c': compressed = 1; break;
+		case 'w': weight_shift = atoi(optarg); break;
+		case 'b': distance_bits = atoi(optarg); break;
+		default: print_usage(argv[0]); return (c == 'h')?0:1;
+		}
+	}
+	int reorder = -1;
+	if(0 == strcmp(reorder_name, "bfs")) reorder = DIJKSTRA_REORDER_BFS;
+	else if(0 == strcmp(reorder_name, "rcm")) reorder = DIJKSTRA_REORDER_RCM;
+	else if(0 == strcmp(reorder_name, "degree")) reorder = DIJKSTRA_REORDER_DEGREE;
+	else if(strcmp(reorder_name, "none")) num_queries = 0;	// invalid
+	if(num_vertices < 2 || num_queries < 1) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	
+	struct bench_graph g[1];
+	int64_t begin = bench_now_ns();
+	if(NULL == bench_graph_init(g, graph_name, num_vertices, degree, seed)) {
+		fprintf(stderr, "unknown graph: %s\n", graph_name);
+		print_usage(argv[0]);
+		return 1;
+	}
+	double build_ms = (bench_now_ns() - begin) / 1000000.0;
+	num_vertices = g->num_vertices;
+	
+	int is_ln = (NULL != g->fees);
+	if(amount < 0) amount = is_ln?100000:0;
+	if(compressed && (is_ln || reverse || amount > 0)) {
+		fprintf(stderr, "--compressed: weights only (no ln, no --reverse, no --amount)\n");
+		bench_graph_cleanup(g);
+		return 1;
+	}
+	
+	// search on the reordered copy, the queries are translated to the new ids
+	struct dijkstra_reordered_graph reordered[1];
+	const struct dijkstra_graph * graph = g->graph;
+	const struct dijkstra_edges * edges = g->edges;
+	double reorder_ms = 0;
+	if(reorder >= 0) {
+		begin = bench_now_ns();
+		dijkstra_reordered_graph_init(reordered, g->graph, reorder);
+		reorder_ms = (bench_now_ns() - begin) / 1000000.0;
+		graph = reordered->graph;
+		edges = reordered->edges;
+	}
+	
+	struct dijkstra_compressed_graph compressed_graph[1];
+	struct dijkstra_compressed_context compressed_dijkstra[1];
+	struct clib_u32_vec compressed_path[1];
+	double compress_ms = 0;
+	if(compressed) {
+		begin = bench_now_ns();
+		dijkstra_compressed_graph_init(compressed_graph, edges, weight_shift);
+		compress_ms = (bench_now_ns() - begin) / 1000000.0;
+		dijkstra_compressed_context_init(compressed_dijkstra, compressed_graph);
+		clib_u32_vec_init(compressed_path, NULL);
+	}
+	
+	struct dijkstra_context dijkstra[1];
+	dijkstra_context_init(dijkstra, graph, NULL);
+	dijkstra->amount = amount;
+	dijkstra->distance_bits = distance_bits;
+	if(is_ln) {
+		dijkstra->calc_weight = calc_weight;
+		dijkstra->calc_amount = calc_amount;
+	}
+	
+	struct clib_pointer_array path[1];
+	memset(path, 0, sizeof(path));
+	int64_t * latencies = calloc(num_queries, sizeof(*latencies));
+	assert(latencies);
+	
+	struct bench_rng rng = { seed ^ 0x5bd1e995 };
+	uint32_t num_found = 0;
+	uint64_t total_settled = 0, max_settled = 0, total_path_length = 0;
+	int64_t total_ns = 0;
+#ifdef DIJKSTRA_ENABLE_STATS
+	struct dijkstra_query_stats total_stats = { 0 };
+#endif
+	for(uint32_t q = 0; q < num_queries; ++q) {
+		uint32_t src_id = bench_rng_uniform(&rng, num_vertices);
+		uint32_t dst_id = bench_rng_uniform(&rng, num_vertices - 1);
+		if(dst_id >= src_id) ++dst_id;
+		if(reorder >= 0) {
+			src_id = dijkstra_reordered_new_id(reordered, src_id);
+			dst_id = dijkstra_reordered_new_id(reordered, dst_id);
+		}
+		
+		if(compressed) {
+			begin = bench_now_ns();
+			int64_t min_weight = compressed_dijkstra->shortest_path(compressed_dijkstra, src_id, dst_id, compressed_path);
+			latencies[q] = bench_now_ns() - begin;
+			total_ns += latencies[q];
+			if(min_weight >= 0) {
+				++num_found;
+				total_path_length += compressed_path->length;
+			}
+			total_settled += compressed_dijkstra->vertices_settled;
+			if(compressed_dijkstra->vertices_settled > max_settled) max_settled = compressed_dijkstra->vertices_settled;
+			continue;
+		}
+		
+		begin = bench_now_ns();
+		ssize_t min_weight = reverse?dijkstra->shortest_path_reverse(dijkstra, src_id, dst_id, path)
+			:dijkstra->shortest_path(dijkstra, src_id, dst_id, path);
+		latencies[q] = bench_now_ns() - begin;
+		total_ns += latencies[q];
+		
+		if(min_weight >= 0) {
+			++num_found;
+			total_path_length += path->length;
+		}
+		uint64_t settled = 0;
+		for(uint32_t i = 0; i < num_vertices; ++i) {
+			settled += (dijkstra_search_state_get_flags(dijkstra->search, i) & DIJKSTRA_VERTEX_VISITED) != 0;
+		}
+		total_settled += settled;
+		if(settled > max_settled) max_settled = settled;
+		
+#ifdef DIJKSTRA_ENABLE_STATS
+		total_stats.vertices_enqueued += dijkstra->stats.vertices_enqueued;
+		total_stats.edges_scanned += dijkstra->stats.edges_scanned;
+		total_stats.edges_relaxed += dijkstra->stats.edges_relaxed;
+		total_stats.callbacks += dijkstra->stats.callbacks;
+		total_stats.allocations += dijkstra->stats.allocations;
+		total_stats.init_ns += dijkstra->stats.init_ns;
+		total_stats.search_ns += dijkstra->stats.search_ns;
+		total_stats.path_ns += dijkstra->stats.path_ns;
+		if(dijkstra->stats.queue_high_water > total_stats.queue_high_water) {
+			total_stats.queue_high_water = dijkstra->stats.queue_high_water;
+		}
+#endif
+	}
+	qsort(latencies, num_queries, sizeof(*latencies), bench_compare_i64);
+	
+	printf("{\"benchmark\":\"dijkstra\",\"graph\":\"%s\",\"vertices\":%u,\"edges\":%zu,\"seed\":%llu,"
+		"\"amount\":%lld,\"direction\":\"%s\",\"build_ms\":%.3f,\"reorder\":\"%s\",\"reorder_ms\":%.3f,"
+		"\"queries\":%u,\"found\":%u,\"qps\":%.1f,"
+		"\"latency_us\":{\"mean\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f},"
+		"\"settled\":{\"mean\":%.1f,\"max\":%llu},\"path_length_mean\":%.2f,"
+		"\"peak_rss_kb\":%ld",
+		g->name, num_vertices, g->edges->edge_index->count, (unsigned long long)seed,
+		(long long)amount, reverse?"reverse":"forward", build_ms, reorder_name, reorder_ms,
+		num_queries, num_found, num_queries * 1e9 / (total_ns?total_ns:1),
+		total_ns / 1000.0 / num_queries,
+		bench_percentile(latencies, num_queries, 50) / 1000.0,
+		bench_percentile(latencies, num_queries, 99) / 1000.0,
+		bench_percentile(latencies, num_queries, 99.9) / 1000.0,
+		latencies[num_queries - 1] / 1000.0,
+		(double)total_settled / num_queries, (unsigned long long)max_settled,
+		num_found?(double)total_path_length / num_found:0.0,
+		bench_peak_rss_kb());
+	
+	// after the last query (status_array and parent_candidates of that query)
+	struct dijkstra_edges_memory_usage edges_usage;
+	struct dijkstra_context_memory_usage context_usage;
+	dijkstra_edges_memory_usage(edges, &edges_usage);
+	dijkstra_context_memory_usage(dijkstra, &context_usage);
+	printf(",\"memory_bytes\":{\"edges\":%zu,\"edge_index\":%zu,\"vertex_arrays\":%zu,\"vertex_lists\":%zu,"
+		"\"list_nodes\":%zu,\"vertex_versions\":%zu,\"graph_total\":%zu,"
+		"\"status_array\":%zu,\"parent_candidates\":%zu,\"search_state\":%zu,\"work_queue\":%zu,\"context_total\":%zu},"
+		"\"distance_bits\":%d",
+		edges_usage.edges, edges_usage.edge_index, edges_usage.vertex_arrays, edges_usage.vertex_lists,
+		edges_usage.list_nodes, edges_usage.vertex_versions, edges_usage.total,
+		context_usage.status_array, context_usage.parent_candidates, context_usage.search_state, 
+		context_usage.work_queue, context_usage.total, dijkstra->search->distance_bits);
+	if(compressed) {
+		printf(",\"compressed\":{\"weight_shift\":%d,\"build_ms\":%.3f,\"bytes\":%zu,\"bytes_per_edge\":%.3f}",
+			weight_shift, compress_ms, dijkstra_compressed_graph_memory_usage(compressed_graph),
+			(double)dijkstra_compressed_graph_memory_usage(compressed_graph) / (compressed_graph->num_edges?compressed_graph->num_edges:1));
+	}
+#ifdef DIJKSTRA_ENABLE_STATS
+	// means per query, queue_high_water is the max over all queries
+	printf(",\"stats\":{\"vertices_enqueued\":%.1f,\"edges_scanned\":%.1f,\"edges_relaxed\":%.1f,"
+		"\"callbacks\":%.1f,\"allocations\":%.1f,\"queue_high_water\":%llu,"
+		"\"init_us\":%.3f,\"search_us\":%.3f,\"path_us\":%.3f}",
+		(double)total_stats.vertices_enqueued / num_queries, (double)total_stats.edges_scanned / num_queries,
+		(double)total_stats.edges_relaxed / num_queries, (double)total_stats.callbacks / num_queries,
+		(double)total_stats.allocations / num_queries, (unsigned long long)total_stats.queue_high_water,
+		total_stats.init_ns / 1000.0 / num_queries, total_stats.search_ns / 1000.0 / num_queries,
+		total_stats.path_ns / 1000.0 / num_queries);
+#endif
+	printf("}\n");
+	
+	free(latencies);
+	clib_pointer_array_cleanup(path, NULL);
+	dijkstra_context_cleanup(dijkstra);
+	if(reorder >= 0) dijkstra_reordered_graph_cleanup(reordered);
+	if(compressed) {
+		clib_u32_vec_cleanup(compressed_path);
+		dijkstra_compressed_context_cleanup(compressed_dijkstra);
+		dijkstra_compressed_graph_cleanup(compressed_graph);
+	}
+	bench_graph_cleanup(g);
+	return 0;
+}
@@ -1,7 +1,13 @@
 #ifndef ALGORITHMS_C_COMMON_H_
 #define ALGORITHMS_C_COMMON_H_
 
+#include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
 
 #ifndef debug_printf
 #ifdef _DEBUG
@@ -12,22 +18,235 @@
 #endif
 #endif
 
+/*
+ * static tracepoints (USDT, SystemTap / DTrace compatible):
+ *   with <sys/sdt.h> (systemtap-sdt-dev) each probe compiles to a single NOP plus an ELF note (.note.stapsdt),
+ *   perf, bpftrace and stap can attach to it at runtime without a debug build, eg.
+ *     bpftrace -l 'usdt:lib/libalgorithms-c.so:*'
+ *     bpftrace -e 'usdt:lib/libalgorithms-c.so:dijkstra:query_end { @weight = hist(arg3); }'
+ *   the arguments are evaluated even if no tracer is attached, keep them cheap (ids, sizes, pointers).
+ *   without <sys/sdt.h>, or with -DALGORITHMS_C_NO_PROBES, the probes are compiled out.
+ */
+#if !defined(ALGORITHMS_C_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define ALGORITHMS_C_HAS_PROBES (1)
+#endif
+#endif
+
+#ifdef ALGORITHMS_C_HAS_PROBES
+#define CLIB_PROBE0(provider, name) DTRACE_PROBE(provider, name)
+#define CLIB_PROBE1(provider, name, a1) DTRACE_PROBE1(provider, name, a1)
+#define CLIB_PROBE2(provider, name, a1, a2) DTRACE_PROBE2(provider, name, a1, a2)
+#define CLIB_PROBE3(provider, name, a1, a2, a3) DTRACE_PROBE3(provider, name, a1, a2, a3)
+#define CLIB_PROBE4(provider, name, a1, a2, a3, a4) DTRACE_PROBE4(provider, name, a1, a2, a3, a4)
+#else
+#define CLIB_PROBE0(provider, name) do { } while(0)
+#define CLIB_PROBE1(provider, name, a1) do { (void)(a1); } while(0)
+#define CLIB_PROBE2(provider, name, a1, a2) do { (void)(a1); (void)(a2); } while(0)
+#define CLIB_PROBE3(provider, name, a1, a2, a3) do { (void)(a1); (void)(a2); (void)(a3); } while(0)
+#define CLIB_PROBE4(provider, name, a1, a2, a3, a4) do { (void)(a1); (void)(a2); (void)(a3); (void)(a4); } while(0)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * clib_allocator: pluggable allocator
+ *   alloc() returns zero-filled memory (calloc), realloc() and free() follow libc.
+ *   a NULL allocator means libc.
+**/
+struct clib_allocator
+{
+	void * user_data;
+	void * (* alloc)(struct clib_allocator * allocator, size_t size);
+	void * (* realloc)(struct clib_allocator * allocator, void * ptr, size_t size);
+	void (* free)(struct clib_allocator * allocator, void * ptr);
+};
+struct clib_allocator * clib_allocator_default(void);
+
+static inline void * clib_alloc(struct clib_allocator * allocator, size_t size)
+{
+	return allocator?allocator->alloc(allocator, size):calloc(1, size);
+}
+static inline void * clib_realloc(struct clib_allocator * allocator, void * ptr, size_t size)
+{
+	return allocator?allocator->realloc(allocator, ptr, size):realloc(ptr, size);
+}
+static inline void clib_free(struct clib_allocator * allocator, void * ptr)
+{
+	if(allocator) allocator->free(allocator, ptr);
+	else free(ptr);
+}
+
+/**
+ * clib_arena: bump allocator, free() is (almost) a no-op,
+ *   clib_arena_reset() releases all the memory at once and keeps the chunks for reuse.
+ *   usage: per-query scratch memory, eg. dijkstra_context_init_ex(dijkstra, graph, NULL, arena->base)
+**/
+struct clib_arena
+{
+	struct clib_allocator base[1];
+	size_t chunk_size;
+	size_t total_bytes;	// allocated from libc
+	size_t used_bytes;	// handed out since the last reset
+	
+	struct clib_arena_chunk * chunks;
+	struct clib_arena_chunk * current;
+	char * cursor;
+	char * end;
+};
+struct clib_arena * clib_arena_init(struct clib_arena * arena, size_t chunk_size);
+void clib_arena_reset(struct clib_arena * arena);
+void clib_arena_cleanup(struct clib_arena * arena);
+
+/**
+ * clib_tracking_allocator: counts the live allocations made through a parent allocator (NULL: libc),
+ *   each block is prefixed with its size, so the blocks must be freed / reallocated through the tracker.
+ *   the counters are the requested sizes (no malloc overhead), not thread-safe.
+ *   usage: dijkstra_edges_init_ex(edges, 1, num_vertices, tracker->base)
+**/
+struct clib_tracking_allocator
+{
+	struct clib_allocator base[1];
+	struct clib_allocator * parent;
+	size_t live_bytes;
+	size_t live_blocks;
+	size_t peak_bytes;
+	uint64_t num_allocs;	// alloc() and realloc(NULL, ...)
+	uint64_t num_reallocs;
+	uint64_t num_frees;
+};
+struct clib_tracking_allocator * clib_tracking_allocator_init(struct clib_tracking_allocator * tracker, struct clib_allocator * parent);
+
 struct clib_pointer_array
 {
 	size_t max_size;
 	size_t length;
 	void ** data_ptrs;
+	struct clib_allocator * allocator;
 };
 int clib_pointer_array_resize(struct clib_pointer_array * array, size_t new_size);
 struct clib_pointer_array * clib_pointer_array_init(struct clib_pointer_array * array, size_t size);
+struct clib_pointer_array * clib_pointer_array_init_ex(struct clib_pointer_array * array, size_t size, struct clib_allocator * allocator);
 void clib_pointer_array_cleanup(struct clib_pointer_array * array, void (*free_data)(void *));
 void clib_pointer_array_clear(struct clib_pointer_array * array, void (*free_data)(void *));
 int clib_pointer_array_set_length(struct clib_pointer_array * array, size_t new_length);
 
+/**
+ * CLIB_VECTOR_DEFINE(name, type): typed contiguous vector, elements are stored by value
+ *   defines struct name and the inline functions:
+ *     name_init(), name_cleanup(), name_reserve(), name_resize(), name_shrink(), 
+ *     name_push(), name_pop(), name_clear(), name_data(), name_at()
+ *   capacity grows geometrically (x2).
+ *   the first CLIB_VECTOR_INLINE_BYTES bytes of elements live inside the struct, short vectors never allocate.
+ *   there is no pointer into the struct itself, so a vector can be moved with memcpy() / realloc().
+ *   a zero-filled struct is a valid empty vector on libc.
+**/
+#ifndef CLIB_VECTOR_INLINE_BYTES
+#define CLIB_VECTOR_INLINE_BYTES (16)
+#endif
+#define CLIB_VECTOR_INLINE_COUNT(type) ((sizeof(type) < CLIB_VECTOR_INLINE_BYTES)?(CLIB_VECTOR_INLINE_BYTES / sizeof(type)):1)
+
+#define CLIB_VECTOR_DEFINE(name, type) CLIB_VECTOR_DEFINE_EX(name, type, CLIB_VECTOR_INLINE_COUNT(type))
+#define CLIB_VECTOR_DEFINE_EX(name, type, inline_count)	\
+struct name	\
+{	\
+	size_t length;	\
+	size_t capacity;	/* <= inline_count: the elements are in u.inline_buf */	\
+	struct clib_allocator * allocator;	\
+	union { type * heap; type inline_buf[inline_count]; } u;	\
+};	\
+static inline struct name * name##_init(struct name * vec, struct clib_allocator * allocator)	\
+{	\
+	if(NULL == vec) vec = clib_alloc(allocator, sizeof(*vec));	\
+	else memset(vec, 0, sizeof(*vec));	\
+	assert(vec);	\
+	vec->capacity = (inline_count);	\
+	vec->allocator = allocator;	\
+	return vec;	\
+}	\
+static inline type * name##_data(const struct name * vec)	\
+{	\
+	return (vec->capacity > (inline_count))?vec->u.heap:(type *)vec->u.inline_buf;	\
+}	\
+static inline type * name##_at(const struct name * vec, size_t index)	\
+{	\
+	assert(index < vec->length);	\
+	return name##_data(vec) + index;	\
+}	\
+static inline int name##_reserve(struct name * vec, size_t capacity)	\
+{	\
+	if(capacity <= vec->capacity) return 0;	\
+	if(capacity <= (inline_count)) { vec->capacity = (inline_count); return 0; }	\
+	size_t new_capacity = vec->capacity * 2;	\
+	if(new_capacity < capacity) new_capacity = capacity;	\
+	type * data = NULL;	\
+	CLIB_PROBE3(clib, vector_resize, vec, vec->capacity, new_capacity);	\
+	if(vec->capacity > (inline_count)) {	\
+		data = clib_realloc(vec->allocator, vec->u.heap, new_capacity * sizeof(type));	\
+		if(NULL == data) return -1;	\
+	}else {	\
+		data = clib_alloc(vec->allocator, new_capacity * sizeof(type));	\
+		if(NULL == data) return -1;	\
+		memcpy(data, vec->u.inline_buf, vec->length * sizeof(type));	\
+	}	\
+	vec->u.heap = data;	\
+	vec->capacity = new_capacity;	\
+	return 0;	\
+}	\
+static inline int name##_resize(struct name * vec, size_t length)	\
+{	\
+	if(name##_reserve(vec, length)) return -1;	\
+	if(length > vec->length) memset(name##_data(vec) + vec->length, 0, (length - vec->length) * sizeof(type));	\
+	vec->length = length;	\
+	return 0;	\
+}	\
+static inline int name##_push(struct name * vec, type value)	\
+{	\
+	if(vec->length >= vec->capacity && name##_reserve(vec, vec->length + 1)) return -1;	\
+	name##_data(vec)[vec->length++] = value;	\
+	return 0;	\
+}	\
+static inline int name##_pop(struct name * vec, type * p_value)	\
+{	\
+	if(0 == vec->length) return -1;	\
+	--vec->length;	\
+	if(p_value) *p_value = name##_data(vec)[vec->length];	\
+	return 0;	\
+}	\
+static inline void name##_clear(struct name * vec)	\
+{	\
+	vec->length = 0;	\
+}	\
+static inline void name##_shrink(struct name * vec)	\
+{	\
+	if(vec->capacity <= (inline_count) || vec->length == vec->capacity) return;	\
+	type * heap = vec->u.heap;	\
+	if(vec->length <= (inline_count)) {	\
+		memcpy(vec->u.inline_buf, heap, vec->length * sizeof(type));	\
+		vec->capacity = (inline_count);	\
+		clib_free(vec->allocator, heap);	\
+		return;	\
+	}	\
+	heap = clib_realloc(vec->allocator, heap, vec->length * sizeof(type));	\
+	if(NULL == heap) return;	\
+	vec->u.heap = heap;	\
+	vec->capacity = vec->length;	\
+}	\
+static inline void name##_cleanup(struct name * vec)	\
+{	\
+	if(NULL == vec) return;	\
+	if(vec->capacity > (inline_count)) clib_free(vec->allocator, vec->u.heap);	\
+	vec->u.heap = NULL;	\
+	vec->capacity = (inline_count);	\
+	vec->length = 0;	\
+}
+
+CLIB_VECTOR_DEFINE(clib_u32_vec, uint32_t);
+CLIB_VECTOR_DEFINE(clib_i64_vec, int64_t);
+
 
 struct clib_circular_array
 {
@@ -46,6 +265,33 @@ struct clib_circular_array
 struct clib_circular_array * clib_circular_array_init(struct clib_circular_array * array, size_t size, void (*free_data)(void *));
 void clib_circular_array_cleanup(struct clib_circular_array * array, void (*free_data)(void *));
 
+/**
+ * clib_mempool: slab pool of fixed-size objects
+ *   objects are handed out from contiguous slabs and recycled through a free-list,
+ *   all of them are released at once by clib_mempool_reset() or clib_mempool_cleanup().
+ *   not thread-safe.
+**/
+struct clib_mempool
+{
+	size_t object_size;
+	size_t objects_per_slab;
+	size_t num_slabs;
+	size_t num_objects;	// objects in use
+	
+	void * slabs;
+	void * free_list;
+	char * cursor;	// next unused object in the newest slab
+	char * end;
+	struct clib_allocator * allocator;	// slabs
+};
+struct clib_mempool * clib_mempool_init(struct clib_mempool * pool, size_t object_size, size_t objects_per_slab);
+struct clib_mempool * clib_mempool_init_ex(struct clib_mempool * pool, size_t object_size, size_t objects_per_slab, struct clib_allocator * allocator);
+void clib_mempool_cleanup(struct clib_mempool * pool);
+void clib_mempool_reset(struct clib_mempool * pool);
+void * clib_mempool_alloc(struct clib_mempool * pool);	// zero-filled
+void clib_mempool_free(struct clib_mempool * pool, void * object);
+size_t clib_mempool_memory_usage(const struct clib_mempool * pool);	// bytes of all slabs, used or not
+
 struct clib_slist_node
 {
 	void * data;
@@ -69,7 +315,13 @@ struct clib_slist
 	size_t length;
 	clib_list_iterator_t iter;
 	int is_xor_list;
+	
+	// optional: allocate nodes from a pool (sizeof(struct clib_slist_node)) or an allocator instead of calloc/free
+	struct clib_mempool * node_pool;
+	struct clib_allocator * allocator;
 };
+struct clib_slist_node * clib_slist_node_new(struct clib_slist * list, void * data);
+void clib_slist_node_free(struct clib_slist * list, struct clib_slist_node * node);
 
 int clib_slist_convert_to_xor_list(struct clib_slist * list);
 int clib_slist_reverse(struct clib_slist * list);
@@ -86,8 +338,98 @@ struct clib_queue
 	void * (*leave)(struct clib_queue * queue);
 };
 struct clib_queue * clib_queue_init(struct clib_queue * queue);
+struct clib_queue * clib_queue_init_ex(struct clib_queue * queue, struct clib_allocator * allocator);
 void clib_queue_clear(struct clib_queue * queue, void (*free_data)(void *));
 
+/**
+ * clib_deque: growable ring buffer (FIFO / LIFO) without per-element allocation,
+ *   size is always a power of 2, the elements keep their order when it grows.
+**/
+struct clib_deque
+{
+	size_t size;
+	size_t length;
+	size_t start_pos;
+	void ** data_ptrs;
+	struct clib_allocator * allocator;
+	
+	int (* push_back)(struct clib_deque * deque, void * data);
+	int (* push_front)(struct clib_deque * deque, void * data);
+	void * (* pop_front)(struct clib_deque * deque);	// NULL if empty
+	void * (* pop_back)(struct clib_deque * deque);	// NULL if empty
+	void * (* get)(struct clib_deque * deque, size_t index);
+};
+struct clib_deque * clib_deque_init(struct clib_deque * deque, size_t size);
+struct clib_deque * clib_deque_init_ex(struct clib_deque * deque, size_t size, struct clib_allocator * allocator);
+int clib_deque_resize(struct clib_deque * deque, size_t new_size);
+void clib_deque_clear(struct clib_deque * deque, void (*free_data)(void *));
+void clib_deque_cleanup(struct clib_deque * deque, void (*free_data)(void *));
+
+/**
+ * clib_mpmc_queue: lock-free bounded multi-producer / multi-consumer queue (Dmitry Vyukov's sequence-numbered ring)
+ *   each cell carries a sequence number:
+ *     sequence == pos:     the cell is free for the producer of pos
+ *     sequence == pos + 1: the cell holds the data for the consumer of pos
+ *   the producers and the consumers only contend on their own counter, each one has its own cache line.
+**/
+#ifndef CLIB_CACHE_LINE_SIZE
+#define CLIB_CACHE_LINE_SIZE (64)
+#endif
+struct clib_mpmc_cell
+{
+	size_t sequence;
+	void * data;
+};
+struct clib_mpmc_queue
+{
+	size_t size;	// power of 2
+	struct clib_mpmc_cell * cells;
+	
+	int (* enqueue)(struct clib_mpmc_queue * queue, void * data);	// 0 on success, -1 if full
+	int (* dequeue)(struct clib_mpmc_queue * queue, void ** p_data);	// 0 on success, -1 if empty
+	
+	// move up to count items with a single claim on the counter, returns the number of items moved
+	size_t (* enqueue_batch)(struct clib_mpmc_queue * queue, void ** items, size_t count);
+	size_t (* dequeue_batch)(struct clib_mpmc_queue * queue, void ** items, size_t max_count);
+	
+	size_t enqueue_pos __attribute__((aligned(CLIB_CACHE_LINE_SIZE)));
+	size_t dequeue_pos __attribute__((aligned(CLIB_CACHE_LINE_SIZE)));
+	char padding[CLIB_CACHE_LINE_SIZE - sizeof(size_t)];
+};
+struct clib_mpmc_queue * clib_mpmc_queue_init(struct clib_mpmc_queue * queue, size_t size);
+void clib_mpmc_queue_cleanup(struct clib_mpmc_queue * queue);
+
+/**
+ * clib_scheduler: work-stealing fork/join runtime
+ *   each worker owns a Chase-Lev deque: it pushes / pops at the bottom, idle workers steal from the top.
+ *   tasks spawned from threads outside of the pool go through a shared clib_mpmc_queue.
+ *   the thread calling sync() / parallel_for() executes pending tasks while waiting.
+ *
+ * env:
+ *   CLIB_NUM_THREADS: number of workers when init() is called with num_workers <= 0 (default: online cpus)
+ *   CLIB_PIN_THREADS: set to 1 to pin worker i to cpu (i % num_cpus)
+**/
+#define CLIB_SCHEDULER_PIN_WORKERS (0x01)
+struct clib_task_group
+{
+	long pending;	// number of spawned tasks not yet finished, zero-init before the first spawn()
+};
+struct clib_scheduler
+{
+	int num_workers;
+	int flags;
+	void * priv;
+	
+	void (* spawn)(struct clib_scheduler * scheduler, struct clib_task_group * group, void (* func)(void * arg), void * arg);
+	void (* sync)(struct clib_scheduler * scheduler, struct clib_task_group * group);	// waits until group->pending == 0
+	
+	// calls body() on disjoint sub-ranges of [begin, end) and waits for all of them, grain_size 0: auto
+	void (* parallel_for)(struct clib_scheduler * scheduler, size_t begin, size_t end, size_t grain_size,
+		void (* body)(size_t begin, size_t end, void * arg), void * arg);
+};
+struct clib_scheduler * clib_scheduler_init(struct clib_scheduler * scheduler, int num_workers, int flags);
+void clib_scheduler_cleanup(struct clib_scheduler * scheduler);
+int clib_scheduler_worker_id(void);	// [0, num_workers) inside a worker, -1 elsewhere
 
 struct clib_stack
 {
@@ -114,8 +456,239 @@ struct clib_sorted_list
 	ssize_t (*find)(struct clib_sorted_list * list, const void * data, clib_list_iterator_t *p_iter, int (*compare)(const void *, const void *));
 };
 struct clib_sorted_list * clib_sorted_list_init(struct clib_sorted_list * list, int (*compare_fn)(const void*, const void *), void (*free_data)(void *));
+struct clib_sorted_list * clib_sorted_list_init_ex(struct clib_sorted_list * list, int (*compare_fn)(const void*, const void *), void (*free_data)(void *), 
+	struct clib_allocator * allocator);
 void clib_sorted_list_clear(struct clib_sorted_list * list);
 
+/**
+ * clib_btree: B+-tree ordered container, O(log n) add / remove / find
+ *   same compare / free_data callbacks as clib_sorted_list, equal elements are kept in insertion order.
+ *   the data are stored in the leaves (CLIB_BTREE_NODE_SIZE pointers per node), 
+ *   the leaves are linked for ordered iteration and range queries.
+**/
+#ifndef CLIB_BTREE_NODE_SIZE
+#define CLIB_BTREE_NODE_SIZE (32)
+#endif
+typedef struct clib_btree_iterator
+{
+	void * leaf;
+	int index;
+}clib_btree_iterator_t;
+
+struct clib_btree
+{
+	size_t count;
+	int height;	// 1: the root is a leaf
+	void * root;
+	struct clib_allocator * allocator;
+	
+	// callbacks
+	void (*free_data)(void *);
+	int (*compare)(const void *, const void *);
+	
+	// public methods
+	int (*add)(struct clib_btree * tree, void * data);
+	void * (*remove)(struct clib_btree * tree, const void * data);	// removes data (or the first element equal to it), returns the removed element
+	void * (*find)(struct clib_btree * tree, const void * key);		// the first element equal to key
+	
+	// visits the elements in [lower, upper] in order, NULL means unbounded, callback() returns non-zero to stop
+	size_t (*range)(struct clib_btree * tree, const void * lower, const void * upper, 
+		int (*callback)(void * data, void * user_data), void * user_data);
+};
+struct clib_btree * clib_btree_init(struct clib_btree * tree, int (*compare_fn)(const void*, const void *), void (*free_data)(void *));
+struct clib_btree * clib_btree_init_ex(struct clib_btree * tree, int (*compare_fn)(const void*, const void *), void (*free_data)(void *), 
+	struct clib_allocator * allocator);
+void clib_btree_clear(struct clib_btree * tree);	// frees all nodes (and data with free_data), the tree can be reused
+void clib_btree_cleanup(struct clib_btree * tree);
+
+_Bool clib_btree_iter_begin(struct clib_btree * tree, clib_btree_iterator_t * p_iter);
+_Bool clib_btree_iter_last(struct clib_btree * tree, clib_btree_iterator_t * p_iter);
+_Bool clib_btree_lower_bound(struct clib_btree * tree, const void * key, clib_btree_iterator_t * p_iter);	// the first element >= key
+_Bool clib_btree_iter_next(clib_btree_iterator_t * p_iter);
+_Bool clib_btree_iter_prev(clib_btree_iterator_t * p_iter);
+void * clib_btree_iter_get(const clib_btree_iterator_t * iter);
+
+/**
+ * clib_hashmap: open-addressing hash map (swiss-table style), fixed-size keys and void * values
+ *   ctrl[] holds one byte per slot: 0x80 (empty) or a 7-bit tag taken from the hash,
+ *   a lookup compares the tags of CLIB_HASHMAP_GROUP_WIDTH consecutive slots at once (SSE2, or SWAR without SSE2).
+ *   the probing is linear, so remove() shifts the following slots back instead of leaving tombstones.
+ * 
+ *   the entries are stored densely (hashes / keys / values), independent of the slots:
+ *   iterate with index in [0, count), a rehash never reorders them, remove() moves the last entry into the hole.
+**/
+#define CLIB_HASHMAP_GROUP_WIDTH (16)
+struct clib_hashmap
+{
+	size_t key_size;
+	size_t count;
+	size_t capacity;	// number of slots, power of 2
+	uint8_t * ctrl;		// capacity + CLIB_HASHMAP_GROUP_WIDTH bytes, the tail mirrors the head for unaligned group loads
+	uint32_t * slots;	// index of the entry
+	
+	size_t max_entries;
+	uint64_t * hashes;
+	void * keys;		// key_size bytes per entry
+	void ** values;
+	
+	uint64_t (* hash)(const void * key, size_t key_size);
+	int (* equal)(const void * a, const void * b, size_t key_size);	// NULL: memcmp()
+	struct clib_allocator * allocator;
+	
+	void ** (* find)(struct clib_hashmap * map, const void * key);	// the address of the value, NULL if not found
+	int (* set)(struct clib_hashmap * map, const void * key, void * value);	// 1: inserted, 0: replaced
+	int (* remove)(struct clib_hashmap * map, const void * key, void ** p_value);	// 0 on success, -1 if not found
+};
+struct clib_hashmap * clib_hashmap_init(struct clib_hashmap * map, size_t key_size, size_t size, struct clib_allocator * allocator);
+void clib_hashmap_clear(struct clib_hashmap * map);
+void clib_hashmap_cleanup(struct clib_hashmap * map);
+uint64_t clib_hash_bytes(const void * data, size_t size);
+size_t clib_hashmap_memory_usage(const struct clib_hashmap * map);	// ctrl + slots + entries (hashes, keys, values)
+
+static inline const void * clib_hashmap_key_at(const struct clib_hashmap * map, size_t index)
+{
+	assert(index < map->count);
+	return (const char *)map->keys + index * map->key_size;
+}
+static inline void * clib_hashmap_value_at(const struct clib_hashmap * map, size_t index)
+{
+	assert(index < map->count);
+	return map->values[index];
+}
+
+/**
+ * priority queues (min-heaps on int64_t keys), both have the same methods:
+ *   push, pop (min), peek, decrease_key (through the handle of the element), meld
+ * 
+ * clib_pairing_heap: intrusive, the handle is a clib_pairing_node embedded in the user's struct.
+ *   O(1) push / meld / decrease_key (amortized o(log n)), O(log n) amortized pop.
+ * 
+ * clib_dary_heap: implicit d-ary heap of uint32_t ids, the handle is the id,
+ *   positions[id] locates an id in the heap (CLIB_DARY_HEAP_NPOS if not in the heap).
+**/
+struct clib_pairing_node
+{
+	int64_t key;
+	struct clib_pairing_node * child;	// leftmost child
+	struct clib_pairing_node * sibling;	// right sibling
+	struct clib_pairing_node * prev;	// left sibling, or the parent of the leftmost child
+};
+struct clib_pairing_heap
+{
+	struct clib_pairing_node * root;
+	size_t length;
+	
+	void (* push)(struct clib_pairing_heap * heap, struct clib_pairing_node * node);	// node->key must be set
+	struct clib_pairing_node * (* pop)(struct clib_pairing_heap * heap);	// NULL if empty
+	struct clib_pairing_node * (* peek)(struct clib_pairing_heap * heap);
+	void (* decrease_key)(struct clib_pairing_heap * heap, struct clib_pairing_node * node, int64_t key);
+	void (* meld)(struct clib_pairing_heap * heap, struct clib_pairing_heap * other);	// moves all nodes of other into heap
+};
+struct clib_pairing_heap * clib_pairing_heap_init(struct clib_pairing_heap * heap);
+
+#define CLIB_DARY_HEAP_NPOS ((uint32_t)-1)
+struct clib_dary_heap
+{
+	int arity;	// d
+	size_t length;
+	size_t size;
+	uint32_t * ids;
+	int64_t * keys;		// keys[i] is the key of ids[i]
+	
+	size_t max_ids;
+	uint32_t * positions;	// [id]: index in ids[]
+	struct clib_allocator * allocator;
+	
+	void (* push)(struct clib_dary_heap * heap, uint32_t id, int64_t key);	// id must not be in the heap
+	int (* pop)(struct clib_dary_heap * heap, uint32_t * p_id, int64_t * p_key);	// 0 on success, -1 if empty
+	int (* peek)(struct clib_dary_heap * heap, uint32_t * p_id, int64_t * p_key);
+	void (* decrease_key)(struct clib_dary_heap * heap, uint32_t id, int64_t key);
+	void (* meld)(struct clib_dary_heap * heap, struct clib_dary_heap * other);	// the ids must be disjoint, other is emptied
+};
+struct clib_dary_heap * clib_dary_heap_init(struct clib_dary_heap * heap, int arity, size_t max_ids, struct clib_allocator * allocator);
+void clib_dary_heap_clear(struct clib_dary_heap * heap);
+void clib_dary_heap_cleanup(struct clib_dary_heap * heap);
+static inline int clib_dary_heap_contains(const struct clib_dary_heap * heap, uint32_t id)
+{
+	return (id < heap->max_ids && heap->positions[id] != CLIB_DARY_HEAP_NPOS);
+}
+
+/**
+ * clib_metrics: process-wide counters and latency histograms
+ *   metrics are registered by name (idempotent) and addressed by the returned id.
+ *   each thread records into its own shard without locks, the shards are merged on read,
+ *   the shard of an exited thread is kept (and reused by the next new thread).
+ *   histograms are HDR-style log-linear: values below 2^CLIB_HISTOGRAM_SUB_BITS are exact,
+ *   above that each power of 2 is split into 2^CLIB_HISTOGRAM_SUB_BITS buckets (~3% relative error).
+ *   histograms record nanoseconds, they are exported in seconds (Prometheus summary) or ns (JSON).
+ *   recording is a no-op until clib_metrics_enable(1).
+ *   a module keeps its ids in a static struct (initialized to -1) and registers them with
+ *   clib_metrics_register_once() on its first record, so nothing is registered while disabled.
+ *   clib_metrics_reset() must only be called while no thread is recording (quiescent),
+ *   the shard owners update their values with a plain load + store and could undo a concurrent reset.
+**/
+#define CLIB_METRICS_MAX_METRICS (64)
+#define CLIB_HISTOGRAM_SUB_BITS (5)
+#define CLIB_HISTOGRAM_MAX_BITS (40)	// larger values (> ~18 min in ns) are counted in the last bucket
+
+enum clib_metrics_type
+{
+	CLIB_METRICS_COUNTER,
+	CLIB_METRICS_HISTOGRAM,
+};
+
+enum clib_metrics_format
+{
+	CLIB_METRICS_FORMAT_PROMETHEUS,
+	CLIB_METRICS_FORMAT_JSON,
+};
+
+struct clib_histogram_summary
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t p50, p90, p99, p999;
+};
+
+extern int clib_metrics_enabled;
+static inline int clib_metrics_is_enabled(void)
+{
+	return __atomic_load_n(&clib_metrics_enabled, __ATOMIC_RELAXED);
+}
+void clib_metrics_enable(int enabled);
+
+int clib_metrics_register(const char * name, const char * help, enum clib_metrics_type type);	// @return id, -1 if full
+int clib_metrics_find(const char * name);
+void clib_metrics_count(int id, uint64_t n);
+void clib_metrics_record(int id, uint64_t value);
+
+// run register_metrics() once per process, @return 0 if the metrics are disabled (nothing is registered)
+static inline int clib_metrics_register_once(pthread_once_t * once, void (* register_metrics)(void))
+{
+	if(!clib_metrics_is_enabled()) return 0;
+	pthread_once(once, register_metrics);
+	return 1;
+}
+
+int64_t clib_metrics_now_ns(void);	// CLOCK_MONOTONIC
+// time a section: begin is 0 when disabled, end() records (now - begin) into a histogram
+static inline int64_t clib_metrics_begin(void)
+{
+	return clib_metrics_is_enabled()?clib_metrics_now_ns():0;
+}
+static inline void clib_metrics_end(int id, int64_t begin_ns)
+{
+	if(begin_ns) clib_metrics_record(id, clib_metrics_now_ns() - begin_ns);
+}
+
+uint64_t clib_metrics_counter_value(int id);
+int clib_metrics_histogram_summary(int id, struct clib_histogram_summary * summary);
+int clib_metrics_dump(FILE * fp, enum clib_metrics_format format);
+int clib_metrics_dump_file(const char * path, enum clib_metrics_format format);	// written to path.tmp, then renamed
+void clib_metrics_reset(void);	// zero all values, the registered metrics are kept; quiescent only (no concurrent recording)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,165 @@
+#ifndef ALGORITHMS_C_DIJKSTRA_COMPRESSED_H_
+#define ALGORITHMS_C_DIJKSTRA_COMPRESSED_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DIJKSTRA_COMPRESSED_BLOCK_SIZE
+#define DIJKSTRA_COMPRESSED_BLOCK_SIZE (16)	// vertices per entry of the block index
+#endif
+
+struct dijkstra_compressed_edge
+{
+	uint32_t src_id;
+	uint32_t dst_id;
+	int64_t weight;	// >= 0
+};
+
+/************************************
+ * dijkstra_compressed_graph:
+ *   read-only adjacency, a few bytes per edge (no edge objects, no list nodes).
+ *   the vertices are stored in id order, each one as:
+ *     varint(degree), varint(byte length of the edges) if degree > 0, then for each edge (order by dst_id):
+ *       varint(dst_id delta), the first one is zigzag(dst_id - src_id), the next ones are dst_id - prev_dst_id
+ *       varint(quantized weight)
+ *   block_offsets[] holds the byte offset of every DIJKSTRA_COMPRESSED_BLOCK_SIZE-th vertex,
+ *   a lookup skips at most DIJKSTRA_COMPRESSED_BLOCK_SIZE - 1 vertices from there, two varints each
+ *   whatever their degrees (a hub in the same block is not decoded again).
+ *
+ *   weights are quantized to round(weight / 2^weight_shift), 0: exact.
+ *   a path weight is then off by at most (number of hops) * 2^(weight_shift - 1).
+ *   only the weights are kept: no capacity, htlc limits or user_data (calc_weight / calc_amount are not supported).
+ *   small id gaps between neighbours compress better, see dijkstra_reorder_permutation().
+************************************/
+struct dijkstra_compressed_graph
+{
+	uint32_t num_vertices;
+	uint64_t num_edges;
+	int weight_shift;
+
+	size_t num_bytes;
+	uint8_t * data;
+
+	size_t num_blocks;
+	uint64_t * block_offsets;
+};
+
+// edges->is_sparse_matrix only
+struct dijkstra_compressed_graph * dijkstra_compressed_graph_init(struct dijkstra_compressed_graph * graph,
+	const struct dijkstra_edges * edges, int weight_shift);
+
+// builds from an edge list without a dijkstra_edges, edges[] is sorted in place (by src_id, dst_id)
+struct dijkstra_compressed_graph * dijkstra_compressed_graph_init_from_list(struct dijkstra_compressed_graph * graph,
+	uint32_t num_vertices, struct dijkstra_compressed_edge * edges, size_t num_edges, int weight_shift);
+
+void dijkstra_compressed_graph_cleanup(struct dijkstra_compressed_graph * graph);
+size_t dijkstra_compressed_graph_memory_usage(const struct dijkstra_compressed_graph * graph);	// data + block index
+
+/************************************
+ * decoding iterator:
+ *   struct dijkstra_compressed_iterator iter;
+ *   dijkstra_compressed_iter_begin(graph, vertex_id, &iter);
+ *   while(dijkstra_compressed_iter_next(&iter)) { iter.dst_id, iter.weight ... }
+************************************/
+struct dijkstra_compressed_iterator
+{
+	const uint8_t * p;
+	uint32_t degree;
+	uint32_t remaining;
+	int weight_shift;
+
+	uint32_t dst_id;
+	int64_t weight;	// dequantized
+};
+
+static inline uint64_t dijkstra_compressed_read_varint(const uint8_t ** p_data)
+{
+	const uint8_t * p = *p_data;
+	uint64_t value = *p++;
+	if(value & 0x80) {
+		value &= 0x7f;
+		int shift = 7;
+		uint64_t byte;
+		do {
+			byte = *p++;
+			value |= (byte & 0x7f) << shift;
+			shift += 7;
+		}while(byte & 0x80);
+	}
+	*p_data = p;
+	return value;
+}
+
+static inline void dijkstra_compressed_iter_begin(const struct dijkstra_compressed_graph * graph, uint32_t vertex_id,
+	struct dijkstra_compressed_iterator * iter)
+{
+	assert(vertex_id < graph->num_vertices);
+	uint32_t vertex = vertex_id - vertex_id % DIJKSTRA_COMPRESSED_BLOCK_SIZE;
+	const uint8_t * p = graph->data + graph->block_offsets[vertex / DIJKSTRA_COMPRESSED_BLOCK_SIZE];
+	for(; vertex < vertex_id; ++vertex) {
+		uint64_t degree = dijkstra_compressed_read_varint(&p);
+		if(degree) {
+			uint64_t length = dijkstra_compressed_read_varint(&p);
+			p += length;
+		}
+	}
+	iter->degree = iter->remaining = (uint32_t)dijkstra_compressed_read_varint(&p);
+	if(iter->degree) dijkstra_compressed_read_varint(&p);	// byte length
+	iter->p = p;
+	iter->weight_shift = graph->weight_shift;
+	iter->dst_id = vertex_id;
+	iter->weight = 0;
+}
+
+// @return 1 if an edge was decoded, 0 at the end
+static inline int dijkstra_compressed_iter_next(struct dijkstra_compressed_iterator * iter)
+{
+	if(0 == iter->remaining) return 0;
+	uint64_t delta = dijkstra_compressed_read_varint(&iter->p);
+	if(iter->remaining == iter->degree) {	// zigzag, relative to src_id
+		iter->dst_id += (uint32_t)((delta >> 1) ^ -(int64_t)(delta & 1));
+	}else {
+		iter->dst_id += (uint32_t)delta;
+	}
+	iter->weight = (int64_t)(dijkstra_compressed_read_varint(&iter->p) << iter->weight_shift);
+	--iter->remaining;
+	return 1;
+}
+
+/************************************
+ * dijkstra_compressed_context:
+ *   binary-heap dijkstra driven by the decoding iterator,
+ *   the per-vertex state is stamped, so a search only touches the vertices it reaches.
+************************************/
+struct dijkstra_compressed_context
+{
+	const struct dijkstra_compressed_graph * graph;
+	int64_t * distances;	// valid if stamps[v] == stamp
+	uint32_t * parents;
+	uint32_t * stamps;
+	uint32_t stamp;
+	struct clib_dary_heap heap[1];
+
+	// counters of the last search
+	uint64_t vertices_settled;
+	uint64_t edges_scanned;
+
+	/**
+	 * shortest_path():
+	 *  @param path: [OUT] [src_id, ..., dst_id], optional
+	 *  @return min_weight (dequantized) on success, -1 if no path found.
+	 */
+	int64_t (* shortest_path)(struct dijkstra_compressed_context * dijkstra,
+		uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path);
+};
+struct dijkstra_compressed_context * dijkstra_compressed_context_init(struct dijkstra_compressed_context * dijkstra,
+	const struct dijkstra_compressed_graph * graph);
+void dijkstra_compressed_context_cleanup(struct dijkstra_compressed_context * dijkstra);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,83 @@
+#ifndef ALGORITHMS_C_DIJKSTRA_PARETO_H_
+#define ALGORITHMS_C_DIJKSTRA_PARETO_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DIJKSTRA_PARETO_MAX_CRITERIA
+#define DIJKSTRA_PARETO_MAX_CRITERIA (4)
+#endif
+
+#ifndef DIJKSTRA_PARETO_DEFAULT_MAX_LABELS
+#define DIJKSTRA_PARETO_DEFAULT_MAX_LABELS (16)
+#endif
+
+struct dijkstra_pareto_path
+{
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA];
+	int64_t amount;	// the amount sent by src_id
+	size_t length;
+	uint32_t * vertices;	// [src_id, ..., dst_id]
+};
+
+struct dijkstra_pareto_result
+{
+	size_t num_paths;	// order by costs (lexicographic)
+	struct dijkstra_pareto_path * paths;
+	
+	// non-dominated labels dropped because their vertex already had max_labels labels,
+	// > 0: the paths are pareto-optimal among the labels kept, but the front may be incomplete
+	size_t num_dropped_labels;
+};
+void dijkstra_pareto_result_cleanup(struct dijkstra_pareto_result * result);
+
+/************************************
+ * dijkstra_pareto_context:
+ *   multi-criteria label-setting search,
+ *   each criterion is an additive, non-negative cost to be minimized.
+ *   eg. costs[0] = fees, costs[1] = cltv_delta, costs[2] = -log(success_probability) * 1000000
+ *   the labels live only inside search(), the context owns no memory:
+ *   dijkstra_pareto_context_cleanup() is a no-op kept for symmetry with the other contexts.
+************************************/
+struct dijkstra_pareto_context
+{
+	void * user_data;
+	const struct dijkstra_graph * graph;
+
+	int num_criteria;	// [1, DIJKSTRA_PARETO_MAX_CRITERIA]
+	int max_labels;		// max number of labels kept per vertex, new labels are dropped when full (see result->num_dropped_labels)
+	int max_hops;		// 0: unlimited, otherwise the hop count is also a dominance criterion during the search
+	int64_t amount;		// 0: do not check capacity
+
+	/**
+	 * search(): finds the pareto-optimal paths from src_id to dst_id
+	 *  @param result: [OUT] cleaned up first, then filled with the paths (if any)
+	 *  @return the number of paths found.
+	 */
+	ssize_t (* search)(struct dijkstra_pareto_context * pareto,
+		uint32_t src_id, uint32_t dst_id,
+		struct dijkstra_pareto_result * result);
+
+	/**
+	 * get_costs(): custom callback to get the costs of an edge for the amount it must forward
+	 *  @return 0 on success, -1 if the edge can not be used.
+	 * default: costs[0] = edge->weight
+	 */
+	int (* get_costs)(const struct dijkstra_sparse_edge * edge, int64_t amount,
+		int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA], void * user_data);
+
+	// custom callback to calc the amount of the next hop (see dijkstra_context)
+	int64_t (* calc_amount)(int64_t amount, void * user_data);
+};
+struct dijkstra_pareto_context * dijkstra_pareto_context_init(struct dijkstra_pareto_context * pareto,
+	const struct dijkstra_graph * graph, int num_criteria,
+	void * user_data);
+void dijkstra_pareto_context_cleanup(struct dijkstra_pareto_context * pareto);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
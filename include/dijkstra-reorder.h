@@ -0,0 +1,78 @@
+#ifndef ALGORITHMS_C_DIJKSTRA_REORDER_H_
+#define ALGORITHMS_C_DIJKSTRA_REORDER_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum dijkstra_reorder_method
+{
+	DIJKSTRA_REORDER_BFS,		// breadth-first order, neighbours are numbered next to each other
+	DIJKSTRA_REORDER_RCM,		// reverse Cuthill-McKee, BFS from a low-degree vertex, neighbours by degree (ascending), then reversed
+	DIJKSTRA_REORDER_DEGREE,	// hub clustering, by degree (descending)
+};
+
+/**
+ * function dijkstra_reorder_permutation():
+ *   computes a locality-improving numbering of the vertices,
+ *   the edges are treated as undirected (outgoing + incoming), each connected component gets a contiguous id range.
+ *  @param new_ids: [OUT] num_vertices entries, original id ==> new id
+ *  @return 0 on success, -1 on failure.
+**/
+int dijkstra_reorder_permutation(const struct dijkstra_edges * edges, enum dijkstra_reorder_method method, uint32_t * new_ids);
+
+/************************************
+ * dijkstra_reordered_graph:
+ *   a copy of a graph under new vertex ids,
+ *   the edges are inserted in the new id order, so the edges, the list nodes and the status_array of
+ *   a dijkstra_context initialized with reordered->graph are laid out by the new ids.
+ *   the copy does not follow the updates of the original edges, reorder again after large changes.
+ *
+ *   usage:
+ *     dijkstra_reordered_graph_init(reordered, graph, DIJKSTRA_REORDER_RCM);
+ *     dijkstra_context_init(dijkstra, reordered->graph, NULL);
+ *     reordered->shortest_path(reordered, dijkstra, src_id, dst_id, path);	// original ids
+************************************/
+struct dijkstra_reordered_graph
+{
+	enum dijkstra_reorder_method method;
+	uint32_t num_vertices;
+	uint32_t * new_ids;	// original id ==> new id
+	uint32_t * old_ids;	// new id ==> original id
+
+	struct dijkstra_vertex * vertices;	// vertices[new_id].data = original vertices[old_id].data, NULL if the original graph has no vertices
+	struct dijkstra_edges edges[1];		// user_data, capacity and htlc limits are copied
+	struct dijkstra_graph graph[1];
+
+	/**
+	 * shortest_path() / shortest_path_reverse():
+	 *   search on reordered->graph (dijkstra->graph must be reordered->graph) with the original ids
+	 *  @param path: [OUT] the original ids [src_id, ..., dst_id], optional
+	 *  @return min_weight on success, -1 if no path found.
+	 */
+	int64_t (* shortest_path)(struct dijkstra_reordered_graph * reordered, struct dijkstra_context * dijkstra,
+		uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path);
+	int64_t (* shortest_path_reverse)(struct dijkstra_reordered_graph * reordered, struct dijkstra_context * dijkstra,
+		uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path);
+};
+struct dijkstra_reordered_graph * dijkstra_reordered_graph_init(struct dijkstra_reordered_graph * reordered,
+	const struct dijkstra_graph * graph, enum dijkstra_reorder_method method);
+void dijkstra_reordered_graph_cleanup(struct dijkstra_reordered_graph * reordered);
+
+static inline uint32_t dijkstra_reordered_new_id(const struct dijkstra_reordered_graph * reordered, uint32_t old_id)
+{
+	assert(old_id < reordered->num_vertices);
+	return reordered->new_ids[old_id];
+}
+static inline uint32_t dijkstra_reordered_old_id(const struct dijkstra_reordered_graph * reordered, uint32_t new_id)
+{
+	assert(new_id < reordered->num_vertices);
+	return reordered->old_ids[new_id];
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
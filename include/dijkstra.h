@@ -14,6 +14,7 @@ extern "C" {
 #endif
 
 #define DIJKSTRA_WEIGHT_UNSET (INT64_MAX)
+#define DIJKSTRA_CAPACITY_UNLIMITED (INT64_MAX)
 
 struct dijkstra_vertex
 {
@@ -31,37 +32,106 @@ struct dijkstra_sparse_edge
 						// eg. struct routing_fees {int64_t rate, int64_t bias} fees = { ppm, base };
 						// user_data := &fees;
 						// calc_weight(amount, user_data) ==>  weight = amount * fees.rate + fees.bias;
+	
+	int64_t capacity;	// max amount can be sent through this edge, DIJKSTRA_CAPACITY_UNLIMITED by default
+	int64_t htlc_min;	// min amount per payment, 0 by default
+	int64_t htlc_max;	// max amount per payment, DIJKSTRA_CAPACITY_UNLIMITED by default
 };
 
+static inline int dijkstra_sparse_edge_can_forward(const struct dijkstra_sparse_edge * edge, int64_t amount)
+{
+	return (amount <= edge->capacity && amount >= edge->htlc_min && amount <= edge->htlc_max);
+}
+
 struct dijkstra_edges
 {
 	int is_sparse_matrix;
 	uint32_t num_vertices;
+	struct clib_allocator * allocator;	// NULL: libc
+	
+	// modification counters: update/remove/set_capacity set vertex_versions[src_id] = ++version,
+	// so a cached path is still valid if none of its vertices has a newer version.
+	uint64_t version;
+	uint64_t * vertex_versions;
+	
+	// bounds of all the weights ever set by update(), they are not narrowed by later updates or remove(),
+	// the searches use 32-bit distances when every path weight fits (see dijkstra_search_state)
+	int64_t min_edge_weight;
+	int64_t max_edge_weight;
 	union {
 		struct {
 			int64_t *weights;	// 2-d array
 		};
 		struct {
-			void * search_root;	// binary tree search root
+			struct clib_hashmap edge_index[1];	// (src_id, dst_id) ==> edge
 			struct clib_pointer_array vertex_edges_array[1]; // each row is a sorted-list which hold all the edges corresponding to each vertex, order by weights 
+			struct clib_pointer_array vertex_capacity_array[1]; // the same edges as vertex_edges_array, order by capacity (descending)
+			struct clib_pointer_array vertex_in_edges_array[1]; // each row holds the incoming edges of a vertex, order by capacity (descending)
+			
+			struct clib_mempool edge_pool[1];	// all sparse edges
+			struct clib_mempool node_pool[1];	// list nodes of the rows above
+			
+			// the last edge returned by remove(), released to edge_pool by the next update(), remove() or cleanup()
+			struct dijkstra_sparse_edge * removed_edge;
 		};
 	};
 	
 	// add or update an edge
 	struct dijkstra_sparse_edge * (* update)(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, int64_t weight);
 	
-	// remove an edge
+	// remove an edge.
+	// the returned edge is owned by edges->edge_pool (see removed_edge), not by the caller:
+	// it stays readable until the next update(), remove() or cleanup() on the same edges,
+	// the caller must not free() it and must copy out any field it needs to keep.
 	struct dijkstra_sparse_edge * (* remove)(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id);
 	
 	// get weight between two vertices
 	int64_t (* get_weight)(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id);
 	
+	// find an edge (sparse matrix only)
+	struct dijkstra_sparse_edge * (* find)(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id);
+	
 	// get all edges belongs to a vertex
 	ssize_t (* get_vertex_sparse_edges)(struct dijkstra_edges * edges, uint32_t vertex_id, const struct clib_slist ** p_edges);
+	
+	// set capacity and htlc limits of an existing edge
+	struct dijkstra_sparse_edge * (* set_capacity)(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, 
+		int64_t capacity, int64_t htlc_min, int64_t htlc_max);
+	
+	// get all edges belongs to a vertex, order by capacity (descending), 
+	// the iteration can stop at the first edge whose capacity is less than the amount
+	ssize_t (* get_vertex_capacity_edges)(struct dijkstra_edges * edges, uint32_t vertex_id, const struct clib_slist ** p_edges);
+	
+	// get all edges which end at a vertex, order by capacity (descending)
+	ssize_t (* get_vertex_incoming_edges)(struct dijkstra_edges * edges, uint32_t vertex_id, const struct clib_slist ** p_edges);
 };
 struct dijkstra_edges * dijkstra_edges_init(struct dijkstra_edges * edges, int is_sparse_matrix, uint32_t num_vertices);
+struct dijkstra_edges * dijkstra_edges_init_ex(struct dijkstra_edges * edges, int is_sparse_matrix, uint32_t num_vertices, 
+	struct clib_allocator * allocator);
 void dijkstra_edges_cleanup(struct dijkstra_edges *edges);
 
+/************************************
+ * memory accounting:
+ *   bytes held by each component, computed from the sizes of the containers 
+ *   (requested sizes without the malloc overhead and without the struct itself),
+ *   use a clib_tracking_allocator to count the live allocations instead.
+************************************/
+struct dijkstra_edges_memory_usage
+{
+	size_t edges;			// edge_pool slabs (struct dijkstra_sparse_edge), including the free objects
+	size_t edge_index;		// (src_id, dst_id) ==> edge hashmap
+	size_t vertex_arrays;	// the rows of vertex_edges_array, vertex_capacity_array and vertex_in_edges_array
+	size_t vertex_lists;	// the sorted-list header of each non-empty row
+	size_t list_nodes;		// node_pool slabs, each edge has one node in each of the 3 rows
+	size_t vertex_versions;
+	size_t weights;			// dense matrix
+	size_t total;
+	
+	size_t num_edges;		// edges in use
+	size_t num_lists;
+};
+size_t dijkstra_edges_memory_usage(const struct dijkstra_edges * edges, struct dijkstra_edges_memory_usage * usage);	// @return total
+
 /************************************
  * dijkstra_graph
 ************************************/
@@ -75,6 +145,12 @@ struct dijkstra_graph
 /************************************
  * dijkstra_context
 ************************************/
+/*
+ * dijkstra_vertex_status: 
+ *   the result view of a search, candidates[] of shortest_path() point into dijkstra->status_array.
+ *   only the vertices on the path of the last search are filled, the other entries keep
+ *   min_weight = DIJKSTRA_WEIGHT_UNSET and an empty parent_candidates list.
+ */
 struct dijkstra_vertex_status
 {
 	const struct dijkstra_vertex * vertex;
@@ -85,23 +161,106 @@ struct dijkstra_vertex_status
 	int is_processing; // in working queue
 	
 	int depth;
-	struct clib_pointer_array parent_candidates[1];
+	struct clib_u32_vec parent_candidates[1];	// vertex ids, [0] is the parent on the path
 	
 	int64_t amount; // custom data for calc weights
 };
 void dijkstra_vertex_status_dump(const struct dijkstra_vertex_status * status);
 
+/************************************
+ * dijkstra_query_stats:
+ *   per-query counters of the last search, reset when a search starts.
+ *   only collected when the library is built with -DDIJKSTRA_ENABLE_STATS,
+ *   otherwise the instrumentation compiles to nothing and the counters stay 0.
+************************************/
+struct dijkstra_query_stats
+{
+	uint64_t vertices_settled;	// vertices (labels) whose edges were scanned, a vertex may be scanned again after an improvement
+	uint64_t vertices_enqueued;
+	uint64_t edges_scanned;
+	uint64_t edges_relaxed;		// edges that improved or tied the weight of their target
+	uint64_t queue_high_water;	// max length of the work queue (number of labels for hop-limited searches)
+	uint64_t callbacks;			// calc_weight() + calc_amount() calls
+	uint64_t allocations;		// status_array, scratch buffers, parent_candidates and work queue growth
+	
+	// phase timings
+	int64_t init_ns;	// status_array / scratch buffers
+	int64_t search_ns;
+	int64_t path_ns;	// path reconstruction
+};
+
+/************************************
+ * dijkstra_search_state:
+ *   per-vertex state of shortest_path() / shortest_path_reverse(), one array per field (structure of arrays),
+ *   so a relaxation only touches a few bytes of the target vertex instead of a whole dijkstra_vertex_status.
+ *   the arrays are kept across searches, only the distances and the flags are reset when a search starts,
+ *   parent[], depth[] and amount[] of a vertex are valid once its distance is set.
+ *
+ *   dist32[] (4 bytes per vertex, DIJKSTRA_DIST32_UNSET if not reached) replaces dist64[] when 
+ *   every path weight fits: no calc_weight, edges->min_edge_weight >= 0 and 
+ *   edges->max_edge_weight * (num_vertices - 1) < DIJKSTRA_DIST32_UNSET.
+************************************/
+#define DIJKSTRA_DIST32_UNSET (UINT32_MAX)
+
+enum dijkstra_vertex_flags
+{
+	DIJKSTRA_VERTEX_QUEUED = 1,		// in working queue
+	DIJKSTRA_VERTEX_VISITED = 2,	// its edges have been scanned
+};
+
+struct dijkstra_search_state
+{
+	size_t num_vertices;
+	int distance_bits;		// 32 or 64, of the last search
+	
+	int64_t * dist64;		// allocated on first use
+	uint32_t * dist32;		// allocated on first use
+	uint32_t * parent;		// the parent with the min depth (the next hop for the reverse search)
+	uint32_t * depth;
+	int64_t * amount;		// only used with calc_amount, otherwise the amount is dijkstra->amount on every hop
+	uint64_t * flags;		// 2 bits per vertex, see enum dijkstra_vertex_flags
+	
+	struct clib_u32_vec exported[1];	// the status_array entries filled by the last search
+};
+
+static inline int dijkstra_search_state_get_flags(const struct dijkstra_search_state * state, uint32_t id)
+{
+	assert(id < state->num_vertices);
+	return (int)(state->flags[id / 32] >> ((id % 32) * 2)) & 3;
+}
+
 struct dijkstra_context
 {
 	void * user_data;
 	const struct dijkstra_graph * graph;
-	struct dijkstra_vertex_status * status_array;
+	struct dijkstra_vertex_status * status_array;	// result view, see struct dijkstra_vertex_status
+	struct dijkstra_search_state search[1];
+	int distance_bits;	// 0: 32-bit distances when the weights fit (default), 64: always 64-bit
+	struct clib_deque work_queue[1];	// FIFO of the searches, reused across searches
+	
+	// per-search memory (status_array, search state and scratch buffers), NULL: libc.
+	// with an arena, call dijkstra_clear_status_array() before resetting it.
+	struct clib_allocator * allocator;
+	
+	struct dijkstra_query_stats stats;	// see DIJKSTRA_ENABLE_STATS
 	
 	ssize_t (*shortest_path)(
 		struct dijkstra_context * dijkstra, 
 		uint32_t src_id, uint32_t dst_id,
 		struct clib_pointer_array *first_candidates);
 	
+	// search from dst_id back to src_id, 
+	// amount is the amount to be received by dst_id, and the fees are added hop by hop toward src_id
+	ssize_t (*shortest_path_reverse)(
+		struct dijkstra_context * dijkstra, 
+		uint32_t src_id, uint32_t dst_id,
+		struct clib_pointer_array *first_candidates);
+	
+	// find the cheapest path with at most max_hops edges (layered Bellman-Ford with dominance pruning)
+	ssize_t (*shortest_path_hop_limited)(
+		struct dijkstra_context * dijkstra, 
+		uint32_t src_id, uint32_t dst_id, int max_hops,
+		struct clib_pointer_array *first_candidates);
 	
 	int64_t amount;
 	// custom callback to calc weight
@@ -114,7 +273,23 @@ struct dijkstra_context * dijkstra_context_init(
 	struct dijkstra_context * dijkstra, 
 	const struct dijkstra_graph * graph,
 	void * user_data);
+struct dijkstra_context * dijkstra_context_init_ex(
+	struct dijkstra_context * dijkstra, 
+	const struct dijkstra_graph * graph,
+	void * user_data,
+	struct clib_allocator * allocator);
 void dijkstra_context_cleanup(struct dijkstra_context * dijkstra);
+void dijkstra_clear_status_array(struct dijkstra_context * dijkstra);
+
+struct dijkstra_context_memory_usage
+{
+	size_t status_array;
+	size_t parent_candidates;	// heap buffers of the candidates lists, short lists are stored inline (in status_array)
+	size_t search_state;		// the arrays of dijkstra->search
+	size_t work_queue;
+	size_t total;
+};
+size_t dijkstra_context_memory_usage(const struct dijkstra_context * dijkstra, struct dijkstra_context_memory_usage * usage);	// @return total
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,58 @@
+#ifndef ALGORITHMS_C_MAX_FLOW_H_
+#define ALGORITHMS_C_MAX_FLOW_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct max_flow_result
+{
+	int64_t flow;	// max amount can be sent from src to dst
+
+	// the edges of a min-cut (the bottleneck channels), all of them are saturated
+	size_t num_cut_edges;
+	const struct dijkstra_sparse_edge ** cut_edges;
+};
+void max_flow_result_cleanup(struct max_flow_result * result);
+
+/************************************
+ * max_flow_context
+ *   the context owns no memory (the graph belongs to the caller, the residual network
+ *   is built and freed by each max_flow() call), max_flow_context_cleanup() is a no-op
+ *   kept for symmetry with the other contexts.
+************************************/
+#define MAX_FLOW_DEFAULT_CHUNK_SIZE (64)
+struct max_flow_context
+{
+	void * user_data;
+	const struct dijkstra_graph * graph;
+
+	// 0 or 1: sequential highest-label push-relabel,
+	// >1: synchronous parallel push-relabel with num_threads workers
+	int num_threads;
+	
+	// number of active vertices a worker claims at a time (parallel only), 0: MAX_FLOW_DEFAULT_CHUNK_SIZE
+	size_t chunk_size;
+
+	/**
+	 * max_flow(): computes the max-flow and a min-cut between src_id and dst_id
+	 *  @return the max-flow, -1 on failure.
+	 */
+	int64_t (* max_flow)(struct max_flow_context * ctx,
+		uint32_t src_id, uint32_t dst_id,
+		struct max_flow_result * result);
+
+	// custom callback to get the capacity of an edge (default: edge->capacity)
+	int64_t (* get_capacity)(const struct dijkstra_sparse_edge * edge, void * user_data);
+};
+struct max_flow_context * max_flow_context_init(struct max_flow_context * ctx,
+	const struct dijkstra_graph * graph,
+	void * user_data);
+void max_flow_context_cleanup(struct max_flow_context * ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,85 @@
+#ifndef ALGORITHMS_C_MIN_COST_FLOW_H_
+#define ALGORITHMS_C_MIN_COST_FLOW_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MIN_COST_FLOW_MAX_SEGMENTS
+#define MIN_COST_FLOW_MAX_SEGMENTS (8)
+#endif
+
+/************************************
+ * min_cost_flow_segment:
+ *   a piece of the (convex) cost function of an edge,
+ *   the first @capacity units sent through this piece cost @unit_cost each.
+ *   unit_cost must be non-decreasing across the pieces of an edge.
+************************************/
+struct min_cost_flow_segment
+{
+	int64_t capacity;
+	int64_t unit_cost;
+};
+
+struct min_cost_flow_path
+{
+	int64_t amount;	// the flow along this path
+	int64_t cost;	// sum(unit_cost) * amount
+	size_t num_vertices;
+	uint32_t * vertices; // [src_id, ..., dst_id]
+};
+
+struct min_cost_flow_result
+{
+	int64_t amount;	// the total flow sent
+	int64_t cost;	// the total cost
+	size_t num_paths;
+	struct min_cost_flow_path * paths;
+};
+void min_cost_flow_result_cleanup(struct min_cost_flow_result * result);
+
+/************************************
+ * min_cost_flow_context
+************************************/
+struct min_cost_flow_context
+{
+	void * user_data;
+	const struct dijkstra_graph * graph;
+	void * priv;	// residual network
+
+	// Johnson potentials, kept between solves (warm-start), cleared when the residual network is rebuilt
+	int64_t * potentials;
+
+	/**
+	 * solve(): send @amount from src_id to dst_id with the min cost (successive shortest paths).
+	 *   If the previous solve used the same src/dst and a smaller amount,
+	 *   the search continues from the previous flow instead of starting over.
+	 *
+	 *  @return the total cost on success, 
+	 *          -1 if the amount can not be sent or the total cost would overflow int64.
+	 *          (result holds the partial flow in this case)
+	 */
+	int64_t (* solve)(struct min_cost_flow_context * mcf,
+		uint32_t src_id, uint32_t dst_id, int64_t amount,
+		struct min_cost_flow_result * result);
+
+	// custom callback to get the cost function of an edge,
+	// returns the number of segments (<= MIN_COST_FLOW_MAX_SEGMENTS).
+	// (default: one segment of {edge->capacity, edge->weight})
+	int (* get_cost_segments)(const struct dijkstra_sparse_edge * edge, void * user_data,
+		struct min_cost_flow_segment segments[MIN_COST_FLOW_MAX_SEGMENTS]);
+};
+struct min_cost_flow_context * min_cost_flow_context_init(struct min_cost_flow_context * mcf,
+	const struct dijkstra_graph * graph,
+	void * user_data);
+void min_cost_flow_context_cleanup(struct min_cost_flow_context * mcf);
+
+// drop the residual network and the potentials (must be called after the edges of the graph have been changed)
+void min_cost_flow_context_reset(struct min_cost_flow_context * mcf);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
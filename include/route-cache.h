@@ -0,0 +1,67 @@
+#ifndef ALGORITHMS_C_ROUTE_CACHE_H_
+#define ALGORITHMS_C_ROUTE_CACHE_H_
+
+#include "dijkstra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct route_cache_stats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t inserts;
+	uint64_t evictions;		// removed to stay within max_bytes
+	uint64_t invalidations;	// removed because one of the edges on the path has been changed
+	uint64_t infeasible;	// removed because the path can not carry the amount of a lookup (counted as a miss)
+};
+
+struct route_cache_path
+{
+	int64_t weight;	// weight of the path for the current amount
+	size_t length;
+	uint32_t * vertices;	// [src_id, ..., dst_id]
+};
+void route_cache_path_cleanup(struct route_cache_path * path);
+
+/************************************
+ * route_cache:
+ *   caches the paths found by dijkstra_context, keyed by (src_id, dst_id, log2(amount)),
+ *   bounded by max_bytes (CLOCK eviction).
+ *   a cached path is dropped as soon as one of its vertices gets a newer edges->vertex_versions[],
+ *   the weight of a hit is re-calculated along the path for the exact amount.
+ *   invariants: hits + misses == lookups,
+ *     inserts - evictions - invalidations - infeasible == number of cached paths.
+ *   the entries and the index are allocated from allocator (NULL: libc),
+ *   route_cache_path::vertices is owned by the caller and always uses libc.
+************************************/
+struct route_cache
+{
+	size_t max_bytes;
+	size_t used_bytes;
+	int reverse;	// use dijkstra->shortest_path_reverse() on misses
+	struct route_cache_stats stats;
+	struct clib_allocator * allocator;
+	void * priv;
+
+	/**
+	 * shortest_path(): returns the cached path if valid, otherwise search with dijkstra and cache the result
+	 *   amount, calc_weight and calc_amount are taken from dijkstra.
+	 *  @return min_weight on success, -1 if no path found.
+	 */
+	int64_t (* shortest_path)(struct route_cache * cache, struct dijkstra_context * dijkstra,
+		uint32_t src_id, uint32_t dst_id,
+		struct route_cache_path * path);
+	void (* clear)(struct route_cache * cache);
+};
+struct route_cache * route_cache_init(struct route_cache * cache, size_t max_bytes);
+struct route_cache * route_cache_init_ex(struct route_cache * cache, size_t max_bytes, struct clib_allocator * allocator);
+void route_cache_cleanup(struct route_cache * cache);
+
+int route_cache_amount_bucket(int64_t amount);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
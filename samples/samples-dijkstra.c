@@ -241,6 +241,18 @@ int main(int argc, char **argv)
 		dijkstra_vertex_status_dump(status);
 	}
 	
+	// search from the payee, the fees of each hop are calculated with the exact amount it forwards
+	clib_pointer_array_clear(candidates, NULL);
+	min_weight = dijkstra->shortest_path_reverse(dijkstra, src_id, dst_id, candidates);
+	printf("min_weight(reverse)=%ld\n", (long)min_weight);
+	
+	printf("path: count=%ld\n", candidates->length);
+	for(size_t i = 0; i < candidates->length; ++i)
+	{
+		const struct dijkstra_vertex_status * status = candidates->data_ptrs[i];
+		dijkstra_vertex_status_dump(status);
+	}
+	
 	dijkstra_edges_cleanup(edges);
 	clib_pointer_array_cleanup(candidates, NULL);
 	dijkstra_context_cleanup(dijkstra);
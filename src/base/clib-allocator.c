@@ -0,0 +1,286 @@
+/*
+ * clib-allocator.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "algorithms-c-common.h"
+
+/***************************************
+ * default allocator: libc
+***************************************/
+static void * libc_alloc(struct clib_allocator * allocator, size_t size)
+{
+	return calloc(1, size);
+}
+static void * libc_realloc(struct clib_allocator * allocator, void * ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+static void libc_free(struct clib_allocator * allocator, void * ptr)
+{
+	free(ptr);
+}
+
+static struct clib_allocator s_libc_allocator[1] = {{
+	.alloc = libc_alloc,
+	.realloc = libc_realloc,
+	.free = libc_free,
+}};
+struct clib_allocator * clib_allocator_default(void)
+{
+	return s_libc_allocator;
+}
+
+/***************************************
+ * clib_tracking_allocator
+ *   each block is prefixed with its requested size (padded to keep the data 16-byte aligned)
+***************************************/
+struct clib_tracking_block
+{
+	size_t size;
+	size_t padding;
+	char data[] __attribute__((aligned(16)));
+};
+#define tracking_block_from_data(ptr) ((struct clib_tracking_block *)((char *)(ptr) - offsetof(struct clib_tracking_block, data)))
+
+static inline void tracking_add(struct clib_tracking_allocator * tracker, size_t size)
+{
+	tracker->live_bytes += size;
+	if(tracker->live_bytes > tracker->peak_bytes) tracker->peak_bytes = tracker->live_bytes;
+}
+
+static void * tracking_alloc(struct clib_allocator * allocator, size_t size)
+{
+	struct clib_tracking_allocator * tracker = (struct clib_tracking_allocator *)allocator;
+	struct clib_tracking_block * block = clib_alloc(tracker->parent, sizeof(*block) + size);
+	if(NULL == block) return NULL;
+	block->size = size;
+	
+	++tracker->num_allocs;
+	++tracker->live_blocks;
+	tracking_add(tracker, size);
+	return block->data;
+}
+
+static void tracking_free(struct clib_allocator * allocator, void * ptr)
+{
+	if(NULL == ptr) return;
+	struct clib_tracking_allocator * tracker = (struct clib_tracking_allocator *)allocator;
+	struct clib_tracking_block * block = tracking_block_from_data(ptr);
+	assert(tracker->live_blocks > 0 && tracker->live_bytes >= block->size);
+	
+	++tracker->num_frees;
+	--tracker->live_blocks;
+	tracker->live_bytes -= block->size;
+	clib_free(tracker->parent, block);
+}
+
+static void * tracking_realloc(struct clib_allocator * allocator, void * ptr, size_t size)
+{
+	if(NULL == ptr) return tracking_alloc(allocator, size);
+	struct clib_tracking_allocator * tracker = (struct clib_tracking_allocator *)allocator;
+	struct clib_tracking_block * block = tracking_block_from_data(ptr);
+	size_t old_size = block->size;
+	
+	block = clib_realloc(tracker->parent, block, sizeof(*block) + size);
+	if(NULL == block) return NULL;
+	block->size = size;
+	
+	++tracker->num_reallocs;
+	tracker->live_bytes -= old_size;
+	tracking_add(tracker, size);
+	return block->data;
+}
+
+struct clib_tracking_allocator * clib_tracking_allocator_init(struct clib_tracking_allocator * tracker, struct clib_allocator * parent)
+{
+	if(NULL == tracker) tracker = calloc(1, sizeof(*tracker));
+	else memset(tracker, 0, sizeof(*tracker));
+	assert(tracker);
+	
+	tracker->parent = parent;
+	tracker->base->user_data = tracker;
+	tracker->base->alloc = tracking_alloc;
+	tracker->base->realloc = tracking_realloc;
+	tracker->base->free = tracking_free;
+	return tracker;
+}
+
+/***************************************
+ * clib_arena: bump allocator
+ *   each block is prefixed with its size (for realloc),
+ *   free() only rolls back the last block, reset() releases everything in O(1)
+ *   (the chunks are kept and reused).
+***************************************/
+#define CLIB_ARENA_ALIGNMENT (16)
+#define CLIB_ARENA_DEFAULT_CHUNK_SIZE (1 << 20)
+
+struct clib_arena_chunk
+{
+	struct clib_arena_chunk * next;
+	size_t size;	// usable bytes
+	char data[] __attribute__((aligned(CLIB_ARENA_ALIGNMENT)));
+};
+
+struct clib_arena_block
+{
+	size_t size;
+	size_t padding;
+	char data[] __attribute__((aligned(CLIB_ARENA_ALIGNMENT)));
+};
+
+static inline size_t arena_align(size_t size)
+{
+	return (size + CLIB_ARENA_ALIGNMENT - 1) & ~(size_t)(CLIB_ARENA_ALIGNMENT - 1);
+}
+
+static void arena_use_chunk(struct clib_arena * arena, struct clib_arena_chunk * chunk)
+{
+	arena->current = chunk;
+	arena->cursor = chunk->data;
+	arena->end = chunk->data + chunk->size;
+}
+
+static void * arena_alloc(struct clib_allocator * allocator, size_t size)
+{
+	struct clib_arena * arena = (struct clib_arena *)allocator;
+	size_t block_size = sizeof(struct clib_arena_block) + arena_align(size);
+	
+	while(NULL == arena->current || (size_t)(arena->end - arena->cursor) < block_size) {
+		struct clib_arena_chunk * next = arena->current?arena->current->next:arena->chunks;
+		if(next && next->size >= block_size) { // reuse the chunks kept by reset()
+			arena_use_chunk(arena, next);
+			continue;
+		}
+		
+		size_t chunk_size = arena->chunk_size;
+		if(chunk_size < block_size) chunk_size = block_size;
+		struct clib_arena_chunk * chunk = malloc(sizeof(*chunk) + chunk_size);
+		assert(chunk);
+		chunk->size = chunk_size;
+		
+		// insert after the current chunk
+		if(arena->current) {
+			chunk->next = arena->current->next;
+			arena->current->next = chunk;
+		}else {
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+		}
+		arena->total_bytes += chunk_size;
+		arena_use_chunk(arena, chunk);
+	}
+	
+	struct clib_arena_block * block = (struct clib_arena_block *)arena->cursor;
+	arena->cursor += block_size;
+	arena->used_bytes += block_size;
+	block->size = size;
+	memset(block->data, 0, size);
+	return block->data;
+}
+
+static void arena_free(struct clib_allocator * allocator, void * ptr)
+{
+	if(NULL == ptr) return;
+	struct clib_arena * arena = (struct clib_arena *)allocator;
+	struct clib_arena_block * block = (struct clib_arena_block *)((char *)ptr - offsetof(struct clib_arena_block, data));
+	size_t block_size = sizeof(struct clib_arena_block) + arena_align(block->size);
+	
+	// roll back the last block only
+	if((char *)block + block_size == arena->cursor) {
+		arena->cursor = (char *)block;
+		arena->used_bytes -= block_size;
+	}
+}
+
+static void * arena_realloc(struct clib_allocator * allocator, void * ptr, size_t size)
+{
+	if(NULL == ptr) return arena_alloc(allocator, size);
+	struct clib_arena * arena = (struct clib_arena *)allocator;
+	struct clib_arena_block * block = (struct clib_arena_block *)((char *)ptr - offsetof(struct clib_arena_block, data));
+	if(size <= block->size) return ptr;
+	
+	// the last block: grow in place
+	size_t old_block_size = sizeof(struct clib_arena_block) + arena_align(block->size);
+	size_t new_block_size = sizeof(struct clib_arena_block) + arena_align(size);
+	if((char *)block + old_block_size == arena->cursor 
+		&& (char *)block + new_block_size <= arena->end) 
+	{
+		arena->cursor = (char *)block + new_block_size;
+		arena->used_bytes += new_block_size - old_block_size;
+		block->size = size;
+		return ptr;
+	}
+	
+	void * data = arena_alloc(allocator, size);
+	memcpy(data, ptr, block->size);
+	return data;
+}
+
+struct clib_arena * clib_arena_init(struct clib_arena * arena, size_t chunk_size)
+{
+	if(NULL == arena) arena = calloc(1, sizeof(*arena));
+	else memset(arena, 0, sizeof(*arena));
+	assert(arena);
+	
+	if(0 == chunk_size) chunk_size = CLIB_ARENA_DEFAULT_CHUNK_SIZE;
+	arena->chunk_size = chunk_size;
+	
+	arena->base->user_data = arena;
+	arena->base->alloc = arena_alloc;
+	arena->base->realloc = arena_realloc;
+	arena->base->free = arena_free;
+	return arena;
+}
+
+void clib_arena_reset(struct clib_arena * arena)
+{
+	if(NULL == arena) return;
+	arena->current = NULL;
+	arena->cursor = arena->end = NULL;
+	arena->used_bytes = 0;
+}
+
+void clib_arena_cleanup(struct clib_arena * arena)
+{
+	if(NULL == arena) return;
+	struct clib_arena_chunk * chunk = arena->chunks;
+	while(chunk) {
+		struct clib_arena_chunk * next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	arena->chunks = NULL;
+	arena->total_bytes = 0;
+	clib_arena_reset(arena);
+}
@@ -31,18 +31,45 @@
 #include <assert.h>
 
 #include "algorithms-c-common.h"
-#define CLIB_POINTER_ARRAY_ALLOC_SIZE (4096)
+#define CLIB_POINTER_ARRAY_MIN_SIZE (16)
+#define CLIB_CIRCULAR_ARRAY_DEFAULT_SIZE (4096)
+
+/*
+ * process-wide metrics (clib_metrics), registered on the first use after clib_metrics_enable(1)
+ */
+static struct
+{
+	int pointer_array_grown_bytes;
+} s_metrics = { -1 };
+static pthread_once_t s_metrics_once = PTHREAD_ONCE_INIT;
+
+static void register_metrics(void)
+{
+	s_metrics.pointer_array_grown_bytes = clib_metrics_register("clib_pointer_array_grown_bytes_total", 
+		"bytes added to pointer arrays by clib_pointer_array_resize()", CLIB_METRICS_COUNTER);
+}
 
 int clib_pointer_array_resize(struct clib_pointer_array * array, size_t new_size)
 {
-	if(0 == new_size) new_size = CLIB_POINTER_ARRAY_ALLOC_SIZE;
-	else new_size = (new_size + CLIB_POINTER_ARRAY_ALLOC_SIZE - 1) / CLIB_POINTER_ARRAY_ALLOC_SIZE * CLIB_POINTER_ARRAY_ALLOC_SIZE;
-	if(new_size <= array->max_size) return 0;
+	if(new_size <= array->max_size && array->max_size > 0) return 0;
+	
+	if(0 == array->max_size) { // the first allocation: exactly the requested size
+		if(0 == new_size) new_size = CLIB_POINTER_ARRAY_MIN_SIZE;
+	}else { // geometric growth
+		size_t size = array->max_size;
+		while(size < new_size) size *= 2;
+		new_size = size;
+	}
+	CLIB_PROBE3(clib, pointer_array_resize, array, array->max_size, new_size);
 	
-	void ** data_ptrs = realloc(array->data_ptrs, sizeof(void *) * new_size);
+	void ** data_ptrs = clib_realloc(array->allocator, array->data_ptrs, sizeof(void *) * new_size);
 	assert(data_ptrs);
 	memset(data_ptrs + array->max_size, 0, (new_size - array->max_size) * sizeof(void *));
 	
+	if(clib_metrics_register_once(&s_metrics_once, register_metrics)) {
+		clib_metrics_count(s_metrics.pointer_array_grown_bytes, (new_size - array->max_size) * sizeof(void *));
+	}
+	
 	array->data_ptrs = data_ptrs;
 	array->max_size = new_size;
 	return 0;
@@ -57,9 +84,15 @@ int clib_pointer_array_set_length(struct clib_pointer_array * array, size_t new_
 
 struct clib_pointer_array * clib_pointer_array_init(struct clib_pointer_array * array, size_t size)
 {
-	if(NULL == array) array = calloc(1, sizeof(*array));
+	return clib_pointer_array_init_ex(array, size, NULL);
+}
+
+struct clib_pointer_array * clib_pointer_array_init_ex(struct clib_pointer_array * array, size_t size, struct clib_allocator * allocator)
+{
+	if(NULL == array) array = clib_alloc(allocator, sizeof(*array));
 	else memset(array, 0, sizeof(*array));
 	assert(array);
+	array->allocator = allocator;
 	clib_pointer_array_resize(array, size);
 	return array;
 }
@@ -83,7 +116,7 @@ void clib_pointer_array_cleanup(struct clib_pointer_array * array, void (*free_d
 	clib_pointer_array_clear(array, free_data);
 	
 	if(array->data_ptrs) {
-		free(array->data_ptrs);
+		clib_free(array->allocator, array->data_ptrs);
 		array->data_ptrs = NULL;
 	}
 	
@@ -115,7 +148,7 @@ static int circular_array_pop(struct clib_circular_array * array)
 
 static int circular_array_resize(struct clib_circular_array * array, size_t new_size)
 {
-	if(new_size == 0) new_size = CLIB_POINTER_ARRAY_ALLOC_SIZE;
+	if(new_size == 0) new_size = CLIB_CIRCULAR_ARRAY_DEFAULT_SIZE;
 	if(new_size == array->size) return 0;
 	
 	int rc = clib_pointer_array_resize(array->base, new_size);
@@ -0,0 +1,523 @@
+/*
+ * clib-btree.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "algorithms-c-common.h"
+
+/***************************************
+ * clib_btree: B+-tree
+ *   leaf:  items[count], sorted, linked with prev / next
+ *   inner: keys[count], children[count + 1],
+ *          keys[i] is the first item under children[i + 1] (so a separator never refers to a removed item),
+ *          all items under children[i] <= keys[i] <= all items under children[i + 1]
+ *   every node except the root holds at least MIN_ENTRIES items (leaf) or keys (inner)
+***************************************/
+#define MAX_ENTRIES (CLIB_BTREE_NODE_SIZE)
+#define MIN_ENTRIES (CLIB_BTREE_NODE_SIZE / 2)
+
+struct btree_inner;
+struct btree_node
+{
+	struct btree_inner * parent;
+	int is_leaf;
+	int count;
+};
+
+struct btree_leaf
+{
+	struct btree_node hdr;
+	struct btree_leaf * prev;
+	struct btree_leaf * next;
+	void * items[MAX_ENTRIES];
+};
+
+struct btree_inner
+{
+	struct btree_node hdr;
+	void * keys[MAX_ENTRIES];
+	struct btree_node * children[MAX_ENTRIES + 1];
+};
+
+static struct btree_leaf * leaf_new(struct clib_btree * tree)
+{
+	struct btree_leaf * leaf = clib_alloc(tree->allocator, sizeof(*leaf));
+	assert(leaf);
+	leaf->hdr.is_leaf = 1;
+	return leaf;
+}
+
+static struct btree_inner * inner_new(struct clib_btree * tree)
+{
+	struct btree_inner * inner = clib_alloc(tree->allocator, sizeof(*inner));
+	assert(inner);
+	return inner;
+}
+
+// number of entries < key (lower bound) or <= key (upper bound)
+static inline int bsearch_lower(struct clib_btree * tree, void * const * entries, int count, const void * key)
+{
+	int lo = 0, hi = count;
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		if(tree->compare(entries[mid], key) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+static inline int bsearch_upper(struct clib_btree * tree, void * const * entries, int count, const void * key)
+{
+	int lo = 0, hi = count;
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		if(tree->compare(entries[mid], key) <= 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+static inline int child_index(const struct btree_inner * parent, const struct btree_node * child)
+{
+	for(int i = 0; i <= parent->hdr.count; ++i) {
+		if(parent->children[i] == child) return i;
+	}
+	assert(0);
+	return -1;
+}
+
+// the first item under node has changed: update the separator which refers to it
+static void update_separator(struct btree_node * node, void * first_item)
+{
+	struct btree_inner * parent = node->parent;
+	while(parent) {
+		int index = child_index(parent, node);
+		if(index > 0) {
+			parent->keys[index - 1] = first_item;
+			return;
+		}
+		node = &parent->hdr;
+		parent = node->parent;
+	}
+}
+
+/***************************************
+ * add
+***************************************/
+static void insert_into_parent(struct clib_btree * tree, struct btree_node * left, void * key, struct btree_node * right)
+{
+	struct btree_inner * parent = left->parent;
+	if(NULL == parent) { // new root
+		parent = inner_new(tree);
+		parent->hdr.count = 1;
+		parent->keys[0] = key;
+		parent->children[0] = left;
+		parent->children[1] = right;
+		left->parent = parent;
+		right->parent = parent;
+		tree->root = parent;
+		++tree->height;
+		return;
+	}
+	
+	int index = child_index(parent, left);
+	int count = parent->hdr.count;
+	if(count < MAX_ENTRIES) {
+		memmove(&parent->keys[index + 1], &parent->keys[index], (count - index) * sizeof(void *));
+		memmove(&parent->children[index + 2], &parent->children[index + 1], (count - index) * sizeof(void *));
+		parent->keys[index] = key;
+		parent->children[index + 1] = right;
+		right->parent = parent;
+		++parent->hdr.count;
+		return;
+	}
+	
+	// split the full inner node: keys[mid] moves up
+	void * keys[MAX_ENTRIES + 1];
+	struct btree_node * children[MAX_ENTRIES + 2];
+	memcpy(keys, parent->keys, index * sizeof(void *));
+	keys[index] = key;
+	memcpy(&keys[index + 1], &parent->keys[index], (count - index) * sizeof(void *));
+	memcpy(children, parent->children, (index + 1) * sizeof(void *));
+	children[index + 1] = right;
+	memcpy(&children[index + 2], &parent->children[index + 1], (count - index) * sizeof(void *));
+	
+	const int mid = (MAX_ENTRIES + 1) / 2;
+	struct btree_inner * sibling = inner_new(tree);
+	parent->hdr.count = mid;
+	memcpy(parent->keys, keys, mid * sizeof(void *));
+	memcpy(parent->children, children, (mid + 1) * sizeof(void *));
+	
+	sibling->hdr.count = MAX_ENTRIES - mid;
+	memcpy(sibling->keys, &keys[mid + 1], sibling->hdr.count * sizeof(void *));
+	memcpy(sibling->children, &children[mid + 1], (sibling->hdr.count + 1) * sizeof(void *));
+	
+	right->parent = parent;
+	for(int i = 0; i <= sibling->hdr.count; ++i) sibling->children[i]->parent = sibling;
+	sibling->hdr.parent = parent->hdr.parent;
+	insert_into_parent(tree, &parent->hdr, keys[mid], &sibling->hdr);
+}
+
+static int btree_add(struct clib_btree * tree, void * data)
+{
+	struct btree_node * node = tree->root;
+	while(!node->is_leaf) {
+		struct btree_inner * inner = (struct btree_inner *)node;
+		node = inner->children[bsearch_upper(tree, inner->keys, node->count, data)];
+	}
+	
+	// after the equal elements
+	struct btree_leaf * leaf = (struct btree_leaf *)node;
+	int pos = bsearch_upper(tree, leaf->items, leaf->hdr.count, data);
+	if(0 == pos) update_separator(&leaf->hdr, data);
+	++tree->count;
+	if(leaf->hdr.count < MAX_ENTRIES) {
+		memmove(&leaf->items[pos + 1], &leaf->items[pos], (leaf->hdr.count - pos) * sizeof(void *));
+		leaf->items[pos] = data;
+		++leaf->hdr.count;
+		return 0;
+	}
+	
+	// split the full leaf, then insert into one of the halves
+	struct btree_leaf * sibling = leaf_new(tree);
+	const int mid = MAX_ENTRIES / 2;
+	sibling->hdr.count = MAX_ENTRIES - mid;
+	memcpy(sibling->items, &leaf->items[mid], sibling->hdr.count * sizeof(void *));
+	leaf->hdr.count = mid;
+	
+	sibling->next = leaf->next;
+	sibling->prev = leaf;
+	if(leaf->next) leaf->next->prev = sibling;
+	leaf->next = sibling;
+	sibling->hdr.parent = leaf->hdr.parent;
+	
+	struct btree_leaf * target = leaf;
+	if(pos > mid) {
+		target = sibling;
+		pos -= mid;
+	}
+	memmove(&target->items[pos + 1], &target->items[pos], (target->hdr.count - pos) * sizeof(void *));
+	target->items[pos] = data;
+	++target->hdr.count;
+	
+	insert_into_parent(tree, &leaf->hdr, sibling->items[0], &sibling->hdr);
+	return 0;
+}
+
+/***************************************
+ * remove
+***************************************/
+static void inner_remove_entry(struct clib_btree * tree, struct btree_inner * node, int key_index, int child_index);
+static void rebalance_inner(struct clib_btree * tree, struct btree_inner * node)
+{
+	struct btree_inner * parent = node->hdr.parent;
+	int index = child_index(parent, &node->hdr);
+	struct btree_inner * left = (index > 0)?(struct btree_inner *)parent->children[index - 1]:NULL;
+	struct btree_inner * right = (index < parent->hdr.count)?(struct btree_inner *)parent->children[index + 1]:NULL;
+	int count = node->hdr.count;
+	
+	if(left && left->hdr.count > MIN_ENTRIES) { // rotate right
+		memmove(&node->keys[1], &node->keys[0], count * sizeof(void *));
+		memmove(&node->children[1], &node->children[0], (count + 1) * sizeof(void *));
+		node->keys[0] = parent->keys[index - 1];
+		node->children[0] = left->children[left->hdr.count];
+		node->children[0]->parent = node;
+		parent->keys[index - 1] = left->keys[left->hdr.count - 1];
+		--left->hdr.count;
+		++node->hdr.count;
+		return;
+	}
+	if(right && right->hdr.count > MIN_ENTRIES) { // rotate left
+		node->keys[count] = parent->keys[index];
+		node->children[count + 1] = right->children[0];
+		node->children[count + 1]->parent = node;
+		parent->keys[index] = right->keys[0];
+		memmove(&right->keys[0], &right->keys[1], (right->hdr.count - 1) * sizeof(void *));
+		memmove(&right->children[0], &right->children[1], right->hdr.count * sizeof(void *));
+		--right->hdr.count;
+		++node->hdr.count;
+		return;
+	}
+	
+	// merge with a sibling, the separator moves down
+	if(NULL == left) {
+		left = node;
+		node = right;
+		++index;
+	}
+	int n = left->hdr.count;
+	left->keys[n] = parent->keys[index - 1];
+	memcpy(&left->keys[n + 1], node->keys, node->hdr.count * sizeof(void *));
+	memcpy(&left->children[n + 1], node->children, (node->hdr.count + 1) * sizeof(void *));
+	for(int i = 0; i <= node->hdr.count; ++i) node->children[i]->parent = left;
+	left->hdr.count += 1 + node->hdr.count;
+	clib_free(tree->allocator, node);
+	inner_remove_entry(tree, parent, index - 1, index);
+}
+
+static void inner_remove_entry(struct clib_btree * tree, struct btree_inner * node, int key_index, int child_index)
+{
+	int count = node->hdr.count;
+	memmove(&node->keys[key_index], &node->keys[key_index + 1], (count - key_index - 1) * sizeof(void *));
+	memmove(&node->children[child_index], &node->children[child_index + 1], (count - child_index) * sizeof(void *));
+	--node->hdr.count;
+	
+	if(NULL == node->hdr.parent) {
+		if(0 == node->hdr.count) { // shrink the tree
+			tree->root = node->children[0];
+			node->children[0]->parent = NULL;
+			--tree->height;
+			clib_free(tree->allocator, node);
+		}
+		return;
+	}
+	if(node->hdr.count < MIN_ENTRIES) rebalance_inner(tree, node);
+}
+
+static void rebalance_leaf(struct clib_btree * tree, struct btree_leaf * leaf)
+{
+	struct btree_inner * parent = leaf->hdr.parent;
+	int index = child_index(parent, &leaf->hdr);
+	struct btree_leaf * left = (index > 0)?(struct btree_leaf *)parent->children[index - 1]:NULL;
+	struct btree_leaf * right = (index < parent->hdr.count)?(struct btree_leaf *)parent->children[index + 1]:NULL;
+	
+	if(left && left->hdr.count > MIN_ENTRIES) { // borrow the last item of left
+		memmove(&leaf->items[1], &leaf->items[0], leaf->hdr.count * sizeof(void *));
+		leaf->items[0] = left->items[--left->hdr.count];
+		++leaf->hdr.count;
+		parent->keys[index - 1] = leaf->items[0];
+		return;
+	}
+	if(right && right->hdr.count > MIN_ENTRIES) { // borrow the first item of right
+		leaf->items[leaf->hdr.count++] = right->items[0];
+		memmove(&right->items[0], &right->items[1], (right->hdr.count - 1) * sizeof(void *));
+		--right->hdr.count;
+		parent->keys[index] = right->items[0];
+		return;
+	}
+	
+	// merge into the left one
+	if(NULL == left) {
+		left = leaf;
+		leaf = right;
+		++index;
+	}
+	memcpy(&left->items[left->hdr.count], leaf->items, leaf->hdr.count * sizeof(void *));
+	left->hdr.count += leaf->hdr.count;
+	left->next = leaf->next;
+	if(leaf->next) leaf->next->prev = left;
+	clib_free(tree->allocator, leaf);
+	inner_remove_entry(tree, parent, index - 1, index);
+}
+
+static void * btree_remove(struct clib_btree * tree, const void * data)
+{
+	clib_btree_iterator_t iter, first;
+	if(!clib_btree_lower_bound(tree, data, &iter)) return NULL;
+	if(0 != tree->compare(clib_btree_iter_get(&iter), data)) return NULL;
+	
+	// prefer the same pointer among the equal elements
+	first = iter;
+	do {
+		void * item = clib_btree_iter_get(&iter);
+		if(item == data) break;
+		if(0 != tree->compare(item, data)) {
+			iter = first;
+			break;
+		}
+	}while(clib_btree_iter_next(&iter));
+	if(NULL == iter.leaf) iter = first;
+	
+	struct btree_leaf * leaf = iter.leaf;
+	void * item = leaf->items[iter.index];
+	memmove(&leaf->items[iter.index], &leaf->items[iter.index + 1], (leaf->hdr.count - iter.index - 1) * sizeof(void *));
+	--leaf->hdr.count;
+	--tree->count;
+	if(0 == iter.index && leaf->hdr.count > 0) update_separator(&leaf->hdr, leaf->items[0]);
+	
+	if(leaf->hdr.parent && leaf->hdr.count < MIN_ENTRIES) rebalance_leaf(tree, leaf);
+	return item;
+}
+
+/***************************************
+ * find / iterate
+***************************************/
+_Bool clib_btree_lower_bound(struct clib_btree * tree, const void * key, clib_btree_iterator_t * p_iter)
+{
+	assert(tree && p_iter);
+	struct btree_node * node = tree->root;
+	while(!node->is_leaf) {
+		struct btree_inner * inner = (struct btree_inner *)node;
+		node = inner->children[bsearch_lower(tree, inner->keys, node->count, key)];
+	}
+	struct btree_leaf * leaf = (struct btree_leaf *)node;
+	int pos = bsearch_lower(tree, leaf->items, leaf->hdr.count, key);
+	if(pos == leaf->hdr.count) {	// the first element >= key is in the next leaf
+		leaf = leaf->next;
+		pos = 0;
+	}
+	p_iter->leaf = leaf;
+	p_iter->index = pos;
+	return (NULL != leaf);
+}
+
+_Bool clib_btree_iter_begin(struct clib_btree * tree, clib_btree_iterator_t * p_iter)
+{
+	assert(tree && p_iter);
+	struct btree_node * node = tree->root;
+	while(!node->is_leaf) node = ((struct btree_inner *)node)->children[0];
+	p_iter->leaf = (node->count > 0)?node:NULL;
+	p_iter->index = 0;
+	return (NULL != p_iter->leaf);
+}
+
+_Bool clib_btree_iter_last(struct clib_btree * tree, clib_btree_iterator_t * p_iter)
+{
+	assert(tree && p_iter);
+	struct btree_node * node = tree->root;
+	while(!node->is_leaf) node = ((struct btree_inner *)node)->children[node->count];
+	p_iter->leaf = (node->count > 0)?node:NULL;
+	p_iter->index = node->count - 1;
+	return (NULL != p_iter->leaf);
+}
+
+_Bool clib_btree_iter_next(clib_btree_iterator_t * p_iter)
+{
+	struct btree_leaf * leaf = p_iter->leaf;
+	if(NULL == leaf) return 0;
+	if(++p_iter->index >= leaf->hdr.count) {
+		p_iter->leaf = leaf->next;
+		p_iter->index = 0;
+	}
+	return (NULL != p_iter->leaf);
+}
+
+_Bool clib_btree_iter_prev(clib_btree_iterator_t * p_iter)
+{
+	struct btree_leaf * leaf = p_iter->leaf;
+	if(NULL == leaf) return 0;
+	if(--p_iter->index < 0) {
+		p_iter->leaf = leaf->prev;
+		p_iter->index = leaf->prev?(leaf->prev->hdr.count - 1):0;
+	}
+	return (NULL != p_iter->leaf);
+}
+
+void * clib_btree_iter_get(const clib_btree_iterator_t * iter)
+{
+	struct btree_leaf * leaf = iter->leaf;
+	if(NULL == leaf) return NULL;
+	assert(iter->index >= 0 && iter->index < leaf->hdr.count);
+	return leaf->items[iter->index];
+}
+
+static void * btree_find(struct clib_btree * tree, const void * key)
+{
+	clib_btree_iterator_t iter;
+	if(!clib_btree_lower_bound(tree, key, &iter)) return NULL;
+	void * item = clib_btree_iter_get(&iter);
+	return (0 == tree->compare(item, key))?item:NULL;
+}
+
+static size_t btree_range(struct clib_btree * tree, const void * lower, const void * upper, 
+	int (*callback)(void * data, void * user_data), void * user_data)
+{
+	clib_btree_iterator_t iter;
+	_Bool ok = lower?clib_btree_lower_bound(tree, lower, &iter):clib_btree_iter_begin(tree, &iter);
+	size_t count = 0;
+	for(; ok; ok = clib_btree_iter_next(&iter)) {
+		void * item = clib_btree_iter_get(&iter);
+		if(upper && tree->compare(item, upper) > 0) break;
+		++count;
+		if(callback && callback(item, user_data)) break;
+	}
+	return count;
+}
+
+/***************************************
+ * init / clear
+***************************************/
+struct clib_btree * clib_btree_init(struct clib_btree * tree, int (*compare_fn)(const void*, const void *), void (*free_data)(void *))
+{
+	return clib_btree_init_ex(tree, compare_fn, free_data, NULL);
+}
+
+struct clib_btree * clib_btree_init_ex(struct clib_btree * tree, int (*compare_fn)(const void*, const void *), void (*free_data)(void *), 
+	struct clib_allocator * allocator)
+{
+	assert(compare_fn);
+	if(NULL == tree) tree = clib_alloc(allocator, sizeof(*tree));
+	else memset(tree, 0, sizeof(*tree));
+	assert(tree);
+	
+	tree->allocator = allocator;
+	tree->compare = compare_fn;
+	tree->free_data = free_data;
+	tree->add = btree_add;
+	tree->remove = btree_remove;
+	tree->find = btree_find;
+	tree->range = btree_range;
+	
+	tree->root = leaf_new(tree);
+	tree->height = 1;
+	return tree;
+}
+
+static void free_node(struct clib_btree * tree, struct btree_node * node)
+{
+	if(node->is_leaf) {
+		struct btree_leaf * leaf = (struct btree_leaf *)node;
+		if(tree->free_data) {
+			for(int i = 0; i < leaf->hdr.count; ++i) tree->free_data(leaf->items[i]);
+		}
+	}else {
+		struct btree_inner * inner = (struct btree_inner *)node;
+		for(int i = 0; i <= inner->hdr.count; ++i) free_node(tree, inner->children[i]);
+	}
+	clib_free(tree->allocator, node);
+}
+
+void clib_btree_clear(struct clib_btree * tree)
+{
+	if(NULL == tree || NULL == tree->root) return;
+	free_node(tree, tree->root);
+	tree->root = leaf_new(tree);
+	tree->height = 1;
+	tree->count = 0;
+}
+
+void clib_btree_cleanup(struct clib_btree * tree)
+{
+	if(NULL == tree || NULL == tree->root) return;
+	free_node(tree, tree->root);
+	tree->root = NULL;
+	tree->height = 0;
+	tree->count = 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * clib-deque.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "algorithms-c-common.h"
+
+/***************************************
+ * clib_deque: ring buffer, capacity is a power of 2 
+ *   the slot of the i-th element: (start_pos + i) & (size - 1)
+***************************************/
+#define CLIB_DEQUE_MIN_SIZE (16)
+
+int clib_deque_resize(struct clib_deque * deque, size_t new_size)
+{
+	assert(deque);
+	if(new_size < CLIB_DEQUE_MIN_SIZE) new_size = CLIB_DEQUE_MIN_SIZE;
+	if(new_size & (new_size - 1)) { // round up to a power of 2
+		new_size = (size_t)1 << (64 - __builtin_clzll((unsigned long long)new_size));
+	}
+	if(new_size <= deque->size) return 0;
+	CLIB_PROBE3(clib, deque_resize, deque, deque->size, new_size);
+	
+	void ** data_ptrs = clib_alloc(deque->allocator, new_size * sizeof(*data_ptrs));
+	assert(data_ptrs);
+	
+	// unwrap: [start_pos, size) + [0, start_pos) ==> [0, length)
+	if(deque->length > 0) {
+		size_t first = deque->size - deque->start_pos;
+		if(first > deque->length) first = deque->length;
+		memcpy(data_ptrs, deque->data_ptrs + deque->start_pos, first * sizeof(*data_ptrs));
+		memcpy(data_ptrs + first, deque->data_ptrs, (deque->length - first) * sizeof(*data_ptrs));
+	}
+	clib_free(deque->allocator, deque->data_ptrs);
+	
+	deque->data_ptrs = data_ptrs;
+	deque->size = new_size;
+	deque->start_pos = 0;
+	return 0;
+}
+
+static int deque_push_back(struct clib_deque * deque, void * data)
+{
+	if(deque->length == deque->size) clib_deque_resize(deque, deque->size * 2);
+	deque->data_ptrs[(deque->start_pos + deque->length) & (deque->size - 1)] = data;
+	++deque->length;
+	return 0;
+}
+
+static int deque_push_front(struct clib_deque * deque, void * data)
+{
+	if(deque->length == deque->size) clib_deque_resize(deque, deque->size * 2);
+	deque->start_pos = (deque->start_pos - 1) & (deque->size - 1);
+	deque->data_ptrs[deque->start_pos] = data;
+	++deque->length;
+	return 0;
+}
+
+static void * deque_pop_front(struct clib_deque * deque)
+{
+	if(0 == deque->length) return NULL;
+	void * data = deque->data_ptrs[deque->start_pos];
+	deque->start_pos = (deque->start_pos + 1) & (deque->size - 1);
+	--deque->length;
+	return data;
+}
+
+static void * deque_pop_back(struct clib_deque * deque)
+{
+	if(0 == deque->length) return NULL;
+	--deque->length;
+	return deque->data_ptrs[(deque->start_pos + deque->length) & (deque->size - 1)];
+}
+
+static void * deque_get(struct clib_deque * deque, size_t index)
+{
+	if(index >= deque->length) return NULL;
+	return deque->data_ptrs[(deque->start_pos + index) & (deque->size - 1)];
+}
+
+struct clib_deque * clib_deque_init(struct clib_deque * deque, size_t size)
+{
+	return clib_deque_init_ex(deque, size, NULL);
+}
+
+struct clib_deque * clib_deque_init_ex(struct clib_deque * deque, size_t size, struct clib_allocator * allocator)
+{
+	if(NULL == deque) deque = clib_alloc(allocator, sizeof(*deque));
+	else memset(deque, 0, sizeof(*deque));
+	assert(deque);
+	
+	deque->allocator = allocator;
+	clib_deque_resize(deque, size);
+	
+	deque->push_back = deque_push_back;
+	deque->push_front = deque_push_front;
+	deque->pop_front = deque_pop_front;
+	deque->pop_back = deque_pop_back;
+	deque->get = deque_get;
+	return deque;
+}
+
+void clib_deque_clear(struct clib_deque * deque, void (*free_data)(void *))
+{
+	if(NULL == deque) return;
+	if(free_data) {
+		for(size_t i = 0; i < deque->length; ++i) {
+			free_data(deque->data_ptrs[(deque->start_pos + i) & (deque->size - 1)]);
+		}
+	}
+	deque->start_pos = 0;
+	deque->length = 0;
+}
+
+void clib_deque_cleanup(struct clib_deque * deque, void (*free_data)(void *))
+{
+	if(NULL == deque) return;
+	clib_deque_clear(deque, free_data);
+	clib_free(deque->allocator, deque->data_ptrs);
+	deque->data_ptrs = NULL;
+	deque->size = 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * clib-hashmap.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "algorithms-c-common.h"
+
+#define GROUP_WIDTH (CLIB_HASHMAP_GROUP_WIDTH)
+#define CTRL_EMPTY  ((uint8_t)0x80)
+#define MIN_CAPACITY (16)
+
+static inline uint64_t mix64(uint64_t x)
+{
+	x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+uint64_t clib_hash_bytes(const void * data, size_t size)
+{
+	const unsigned char * p = data;
+	uint64_t hash = 0x9e3779b97f4a7c15ULL ^ size;
+	while(size >= 8) {
+		uint64_t value;
+		memcpy(&value, p, 8);
+		hash = mix64(hash ^ value);
+		p += 8;
+		size -= 8;
+	}
+	if(size > 0) {
+		uint64_t value = 0;
+		memcpy(&value, p, size);
+		hash = mix64(hash ^ value);
+	}
+	return hash;
+}
+
+/***************************************
+ * group matching: bit i is set if ctrl[i] matches
+***************************************/
+#if defined(__SSE2__)
+static inline uint32_t group_match(const uint8_t * ctrl, uint8_t tag)
+{
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+}
+static inline uint32_t group_match_empty(const uint8_t * ctrl)
+{
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (uint32_t)_mm_movemask_epi8(group);	// only the empty slots have the high bit set
+}
+#else
+// SWAR over two 64-bit words (may report false positives above a true match, the keys are compared anyway)
+#define LSB_BYTES (0x0101010101010101ULL)
+#define MSB_BYTES (0x8080808080808080ULL)
+static inline uint32_t msb_to_bits(uint64_t msb)
+{
+	return (uint32_t)(((msb >> 7) * 0x0102040810204080ULL) >> 56);
+}
+static inline uint32_t group_match(const uint8_t * ctrl, uint8_t tag)
+{
+	uint64_t words[2];
+	memcpy(words, ctrl, sizeof(words));
+	uint32_t bits = 0;
+	for(int i = 0; i < 2; ++i) {
+		uint64_t x = words[i] ^ (LSB_BYTES * tag);
+		bits |= msb_to_bits((x - LSB_BYTES) & ~x & MSB_BYTES) << (i * 8);
+	}
+	return bits;
+}
+static inline uint32_t group_match_empty(const uint8_t * ctrl)
+{
+	uint64_t words[2];
+	memcpy(words, ctrl, sizeof(words));
+	return msb_to_bits(words[0] & MSB_BYTES) | (msb_to_bits(words[1] & MSB_BYTES) << 8);
+}
+#endif
+
+static inline uint8_t hash_tag(uint64_t hash)
+{
+	return (uint8_t)(hash >> 57);
+}
+
+static inline void set_ctrl(struct clib_hashmap * map, size_t slot, uint8_t value)
+{
+	map->ctrl[slot] = value;
+	if(slot < GROUP_WIDTH) map->ctrl[map->capacity + slot] = value;
+}
+
+static inline int keys_equal(const struct clib_hashmap * map, size_t index, const void * key)
+{
+	const void * entry_key = (const char *)map->keys + index * map->key_size;
+	if(map->equal) return map->equal(entry_key, key, map->key_size);
+	return (0 == memcmp(entry_key, key, map->key_size));
+}
+
+// @return the slot of key, or -1
+static ssize_t find_slot(const struct clib_hashmap * map, const void * key, uint64_t hash)
+{
+	const size_t mask = map->capacity - 1;
+	const uint8_t tag = hash_tag(hash);
+	size_t pos = hash & mask;
+	for(size_t probed = 0; probed < map->capacity; probed += GROUP_WIDTH) {
+		uint32_t match = group_match(map->ctrl + pos, tag);
+		while(match) {
+			size_t slot = (pos + __builtin_ctz(match)) & mask;
+			uint32_t index = map->slots[slot];
+			if(map->hashes[index] == hash && keys_equal(map, index, key)) return slot;
+			match &= match - 1;
+		}
+		if(group_match_empty(map->ctrl + pos)) break;
+		pos = (pos + GROUP_WIDTH) & mask;
+	}
+	return -1;
+}
+
+static size_t find_empty_slot(const struct clib_hashmap * map, uint64_t hash)
+{
+	const size_t mask = map->capacity - 1;
+	size_t pos = hash & mask;
+	while(1) {
+		uint32_t empty = group_match_empty(map->ctrl + pos);
+		if(empty) return (pos + __builtin_ctz(empty)) & mask;
+		pos = (pos + GROUP_WIDTH) & mask;
+	}
+}
+
+static void rehash(struct clib_hashmap * map, size_t capacity)
+{
+	CLIB_PROBE3(clib, hashmap_rehash, map, map->capacity, capacity);
+	clib_free(map->allocator, map->ctrl);
+	clib_free(map->allocator, map->slots);
+	
+	map->capacity = capacity;
+	map->ctrl = clib_alloc(map->allocator, capacity + GROUP_WIDTH);
+	map->slots = clib_alloc(map->allocator, capacity * sizeof(*map->slots));
+	assert(map->ctrl && map->slots);
+	memset(map->ctrl, CTRL_EMPTY, capacity + GROUP_WIDTH);
+	
+	for(size_t i = 0; i < map->count; ++i) {
+		size_t slot = find_empty_slot(map, map->hashes[i]);
+		set_ctrl(map, slot, hash_tag(map->hashes[i]));
+		map->slots[slot] = i;
+	}
+}
+
+static void resize_entries(struct clib_hashmap * map, size_t max_entries)
+{
+	CLIB_PROBE3(clib, hashmap_resize, map, map->max_entries, max_entries);
+	map->hashes = clib_realloc(map->allocator, map->hashes, max_entries * sizeof(*map->hashes));
+	map->keys = clib_realloc(map->allocator, map->keys, max_entries * map->key_size);
+	map->values = clib_realloc(map->allocator, map->values, max_entries * sizeof(*map->values));
+	assert(map->hashes && map->keys && map->values);
+	map->max_entries = max_entries;
+}
+
+static void ** hashmap_find(struct clib_hashmap * map, const void * key)
+{
+	uint64_t hash = map->hash(key, map->key_size);
+	ssize_t slot = find_slot(map, key, hash);
+	if(slot < 0) return NULL;
+	return &map->values[map->slots[slot]];
+}
+
+static int hashmap_set(struct clib_hashmap * map, const void * key, void * value)
+{
+	uint64_t hash = map->hash(key, map->key_size);
+	ssize_t slot = find_slot(map, key, hash);
+	if(slot >= 0) {
+		map->values[map->slots[slot]] = value;
+		return 0;
+	}
+	
+	// max load factor: 7/8
+	if((map->count + 1) * 8 > map->capacity * 7) rehash(map, map->capacity * 2);
+	if(map->count >= map->max_entries) resize_entries(map, map->max_entries * 2);
+	
+	size_t index = map->count++;
+	map->hashes[index] = hash;
+	memcpy((char *)map->keys + index * map->key_size, key, map->key_size);
+	map->values[index] = value;
+	
+	slot = find_empty_slot(map, hash);
+	set_ctrl(map, slot, hash_tag(hash));
+	map->slots[slot] = index;
+	return 1;
+}
+
+/*
+ * backward shift deletion: 
+ *   move the following slots of the same probe run back into the hole when it is still on their probe path.
+ */
+static void remove_slot(struct clib_hashmap * map, size_t hole)
+{
+	const size_t mask = map->capacity - 1;
+	size_t slot = (hole + 1) & mask;
+	while(map->ctrl[slot] != CTRL_EMPTY) {
+		size_t home = map->hashes[map->slots[slot]] & mask;
+		if(((slot - home) & mask) >= ((slot - hole) & mask)) {
+			set_ctrl(map, hole, map->ctrl[slot]);
+			map->slots[hole] = map->slots[slot];
+			hole = slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	set_ctrl(map, hole, CTRL_EMPTY);
+}
+
+static int hashmap_remove(struct clib_hashmap * map, const void * key, void ** p_value)
+{
+	uint64_t hash = map->hash(key, map->key_size);
+	ssize_t slot = find_slot(map, key, hash);
+	if(slot < 0) return -1;
+	
+	uint32_t index = map->slots[slot];
+	if(p_value) *p_value = map->values[index];
+	remove_slot(map, slot);
+	
+	// keep the entries dense: move the last one into the hole
+	uint32_t last = map->count - 1;
+	if(index != last) {
+		const size_t mask = map->capacity - 1;
+		size_t pos = map->hashes[last] & mask;
+		while(map->slots[pos] != last || map->ctrl[pos] == CTRL_EMPTY) pos = (pos + 1) & mask;
+		map->slots[pos] = index;
+		
+		map->hashes[index] = map->hashes[last];
+		memcpy((char *)map->keys + index * map->key_size, (char *)map->keys + last * map->key_size, map->key_size);
+		map->values[index] = map->values[last];
+	}
+	--map->count;
+	return 0;
+}
+
+struct clib_hashmap * clib_hashmap_init(struct clib_hashmap * map, size_t key_size, size_t size, struct clib_allocator * allocator)
+{
+	assert(key_size > 0);
+	if(NULL == map) map = clib_alloc(allocator, sizeof(*map));
+	else memset(map, 0, sizeof(*map));
+	assert(map);
+	
+	map->key_size = key_size;
+	map->allocator = allocator;
+	map->hash = clib_hash_bytes;
+	map->find = hashmap_find;
+	map->set = hashmap_set;
+	map->remove = hashmap_remove;
+	
+	size_t capacity = MIN_CAPACITY;
+	while(capacity * 7 < size * 8) capacity *= 2;
+	rehash(map, capacity);
+	resize_entries(map, (size > 16)?size:16);
+	return map;
+}
+
+void clib_hashmap_clear(struct clib_hashmap * map)
+{
+	if(NULL == map || NULL == map->ctrl) return;
+	memset(map->ctrl, CTRL_EMPTY, map->capacity + GROUP_WIDTH);
+	map->count = 0;
+}
+
+size_t clib_hashmap_memory_usage(const struct clib_hashmap * map)
+{
+	if(NULL == map || NULL == map->ctrl) return 0;
+	return (map->capacity + GROUP_WIDTH) 
+		+ map->capacity * sizeof(*map->slots)
+		+ map->max_entries * (sizeof(*map->hashes) + map->key_size + sizeof(*map->values));
+}
+
+void clib_hashmap_cleanup(struct clib_hashmap * map)
+{
+	if(NULL == map) return;
+	clib_free(map->allocator, map->ctrl);
+	clib_free(map->allocator, map->slots);
+	clib_free(map->allocator, map->hashes);
+	clib_free(map->allocator, map->keys);
+	clib_free(map->allocator, map->values);
+	map->ctrl = NULL;
+	map->slots = NULL;
+	map->hashes = NULL;
+	map->keys = NULL;
+	map->values = NULL;
+	map->count = 0;
+	map->capacity = 0;
+	map->max_entries = 0;
+}
@@ -0,0 +1,500 @@
+/*
+ * clib-heap.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "algorithms-c-common.h"
+
+/***************************************
+ * clib_pairing_heap
+***************************************/
+// the root with the larger key becomes the leftmost child of the other one
+static inline struct clib_pairing_node * pairing_link(struct clib_pairing_node * a, struct clib_pairing_node * b)
+{
+	if(NULL == a) return b;
+	if(NULL == b) return a;
+	if(b->key < a->key) {
+		struct clib_pairing_node * tmp = a;
+		a = b;
+		b = tmp;
+	}
+	b->sibling = a->child;
+	if(a->child) a->child->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->sibling = NULL;
+	a->prev = NULL;
+	return a;
+}
+
+static void pairing_push(struct clib_pairing_heap * heap, struct clib_pairing_node * node)
+{
+	assert(node);
+	node->child = node->sibling = node->prev = NULL;
+	heap->root = pairing_link(heap->root, node);
+	++heap->length;
+}
+
+static struct clib_pairing_node * pairing_peek(struct clib_pairing_heap * heap)
+{
+	return heap->root;
+}
+
+/*
+ * two-pass pairing of the children of the old root:
+ *   1. link the children in pairs from left to right (the results are chained through prev, in reverse order)
+ *   2. link the pairs from right to left
+ */
+static struct clib_pairing_node * pairing_combine(struct clib_pairing_node * first)
+{
+	struct clib_pairing_node * pairs = NULL;
+	while(first) {
+		struct clib_pairing_node * a = first;
+		struct clib_pairing_node * b = a->sibling;
+		first = b?b->sibling:NULL;
+		a->sibling = a->prev = NULL;
+		if(b) b->sibling = b->prev = NULL;
+		
+		struct clib_pairing_node * pair = pairing_link(a, b);
+		pair->prev = pairs;
+		pairs = pair;
+	}
+	
+	struct clib_pairing_node * root = NULL;
+	while(pairs) {
+		struct clib_pairing_node * next = pairs->prev;
+		pairs->prev = NULL;
+		root = pairing_link(root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+static struct clib_pairing_node * pairing_pop(struct clib_pairing_heap * heap)
+{
+	struct clib_pairing_node * root = heap->root;
+	if(NULL == root) return NULL;
+	heap->root = pairing_combine(root->child);
+	--heap->length;
+	root->child = NULL;
+	return root;
+}
+
+static void pairing_decrease_key(struct clib_pairing_heap * heap, struct clib_pairing_node * node, int64_t key)
+{
+	assert(key <= node->key);
+	node->key = key;
+	if(node == heap->root) return;
+	
+	// cut the subtree of node, then link it with the root
+	if(node->prev->child == node) node->prev->child = node->sibling;
+	else node->prev->sibling = node->sibling;
+	if(node->sibling) node->sibling->prev = node->prev;
+	node->sibling = node->prev = NULL;
+	heap->root = pairing_link(heap->root, node);
+}
+
+static void pairing_meld(struct clib_pairing_heap * heap, struct clib_pairing_heap * other)
+{
+	heap->root = pairing_link(heap->root, other->root);
+	heap->length += other->length;
+	other->root = NULL;
+	other->length = 0;
+}
+
+struct clib_pairing_heap * clib_pairing_heap_init(struct clib_pairing_heap * heap)
+{
+	if(NULL == heap) heap = calloc(1, sizeof(*heap));
+	else memset(heap, 0, sizeof(*heap));
+	assert(heap);
+	
+	heap->push = pairing_push;
+	heap->pop = pairing_pop;
+	heap->peek = pairing_peek;
+	heap->decrease_key = pairing_decrease_key;
+	heap->meld = pairing_meld;
+	return heap;
+}
+
+/***************************************
+ * clib_dary_heap
+***************************************/
+static inline void dary_place(struct clib_dary_heap * heap, size_t pos, uint32_t id, int64_t key)
+{
+	heap->ids[pos] = id;
+	heap->keys[pos] = key;
+	heap->positions[id] = pos;
+}
+
+static void dary_sift_up(struct clib_dary_heap * heap, size_t pos, uint32_t id, int64_t key)
+{
+	const size_t arity = heap->arity;
+	while(pos > 0) {
+		size_t parent = (pos - 1) / arity;
+		if(heap->keys[parent] <= key) break;
+		dary_place(heap, pos, heap->ids[parent], heap->keys[parent]);
+		pos = parent;
+	}
+	dary_place(heap, pos, id, key);
+}
+
+static void dary_sift_down(struct clib_dary_heap * heap, size_t pos, uint32_t id, int64_t key)
+{
+	const size_t arity = heap->arity;
+	const size_t length = heap->length;
+	while(1) {
+		size_t first = pos * arity + 1;
+		if(first >= length) break;
+		size_t last = first + arity;
+		if(last > length) last = length;
+		
+		size_t min_child = first;
+		for(size_t child = first + 1; child < last; ++child) {
+			if(heap->keys[child] < heap->keys[min_child]) min_child = child;
+		}
+		if(heap->keys[min_child] >= key) break;
+		dary_place(heap, pos, heap->ids[min_child], heap->keys[min_child]);
+		pos = min_child;
+	}
+	dary_place(heap, pos, id, key);
+}
+
+static void dary_reserve_ids(struct clib_dary_heap * heap, uint32_t id)
+{
+	if(id < heap->max_ids) return;
+	size_t max_ids = heap->max_ids?heap->max_ids:64;
+	while(max_ids <= id) max_ids *= 2;
+	heap->positions = clib_realloc(heap->allocator, heap->positions, max_ids * sizeof(*heap->positions));
+	assert(heap->positions);
+	memset(heap->positions + heap->max_ids, 0xff, (max_ids - heap->max_ids) * sizeof(*heap->positions));
+	heap->max_ids = max_ids;
+}
+
+static void dary_reserve(struct clib_dary_heap * heap, size_t size)
+{
+	if(size <= heap->size) return;
+	size_t new_size = heap->size?heap->size:64;
+	while(new_size < size) new_size *= 2;
+	CLIB_PROBE3(clib, dary_heap_resize, heap, heap->size, new_size);
+	heap->ids = clib_realloc(heap->allocator, heap->ids, new_size * sizeof(*heap->ids));
+	heap->keys = clib_realloc(heap->allocator, heap->keys, new_size * sizeof(*heap->keys));
+	assert(heap->ids && heap->keys);
+	heap->size = new_size;
+}
+
+static void dary_push(struct clib_dary_heap * heap, uint32_t id, int64_t key)
+{
+	dary_reserve_ids(heap, id);
+	assert(heap->positions[id] == CLIB_DARY_HEAP_NPOS);
+	dary_reserve(heap, heap->length + 1);
+	dary_sift_up(heap, heap->length++, id, key);
+}
+
+static int dary_peek(struct clib_dary_heap * heap, uint32_t * p_id, int64_t * p_key)
+{
+	if(0 == heap->length) return -1;
+	if(p_id) *p_id = heap->ids[0];
+	if(p_key) *p_key = heap->keys[0];
+	return 0;
+}
+
+static int dary_pop(struct clib_dary_heap * heap, uint32_t * p_id, int64_t * p_key)
+{
+	if(0 == heap->length) return -1;
+	if(p_id) *p_id = heap->ids[0];
+	if(p_key) *p_key = heap->keys[0];
+	heap->positions[heap->ids[0]] = CLIB_DARY_HEAP_NPOS;
+	
+	size_t last = --heap->length;
+	if(last > 0) dary_sift_down(heap, 0, heap->ids[last], heap->keys[last]);
+	return 0;
+}
+
+static void dary_decrease_key(struct clib_dary_heap * heap, uint32_t id, int64_t key)
+{
+	assert(clib_dary_heap_contains(heap, id));
+	size_t pos = heap->positions[id];
+	assert(key <= heap->keys[pos]);
+	dary_sift_up(heap, pos, id, key);
+}
+
+static void dary_meld(struct clib_dary_heap * heap, struct clib_dary_heap * other)
+{
+	if(0 == other->length) return;
+	dary_reserve(heap, heap->length + other->length);
+	for(size_t i = 0; i < other->length; ++i) {
+		uint32_t id = other->ids[i];
+		dary_reserve_ids(heap, id);
+		assert(heap->positions[id] == CLIB_DARY_HEAP_NPOS);
+		dary_place(heap, heap->length++, id, other->keys[i]);
+	}
+	clib_dary_heap_clear(other);
+	
+	// heapify bottom-up (Floyd)
+	for(size_t pos = heap->length / heap->arity + 1; pos-- > 0; ) {
+		dary_sift_down(heap, pos, heap->ids[pos], heap->keys[pos]);
+	}
+}
+
+struct clib_dary_heap * clib_dary_heap_init(struct clib_dary_heap * heap, int arity, size_t max_ids, struct clib_allocator * allocator)
+{
+	if(NULL == heap) heap = clib_alloc(allocator, sizeof(*heap));
+	else memset(heap, 0, sizeof(*heap));
+	assert(heap);
+	
+	if(arity < 2) arity = 4;
+	heap->arity = arity;
+	heap->allocator = allocator;
+	heap->push = dary_push;
+	heap->pop = dary_pop;
+	heap->peek = dary_peek;
+	heap->decrease_key = dary_decrease_key;
+	heap->meld = dary_meld;
+	
+	if(max_ids > 0) dary_reserve_ids(heap, max_ids - 1);
+	return heap;
+}
+
+void clib_dary_heap_clear(struct clib_dary_heap * heap)
+{
+	if(NULL == heap) return;
+	for(size_t i = 0; i < heap->length; ++i) heap->positions[heap->ids[i]] = CLIB_DARY_HEAP_NPOS;
+	heap->length = 0;
+}
+
+void clib_dary_heap_cleanup(struct clib_dary_heap * heap)
+{
+	if(NULL == heap) return;
+	clib_free(heap->allocator, heap->ids);
+	clib_free(heap->allocator, heap->keys);
+	clib_free(heap->allocator, heap->positions);
+	heap->ids = NULL;
+	heap->keys = NULL;
+	heap->positions = NULL;
+	heap->length = heap->size = heap->max_ids = 0;
+}
+
+
+/****************************************************
+ * TEST_MODULE::clib-heap
+ * build:
+ *   tests/make.sh heap
+ * run:
+ *   tests/heap [num_vertices] [out_degree]
+****************************************************/
+#if defined(TEST_CLIB_HEAP) && defined(ALGORITHMS_C_STAND_ALONE)
+#include <time.h>
+
+struct graph
+{
+	uint32_t num_vertices;
+	uint32_t * offsets;	// [num_vertices + 1]
+	uint32_t * targets;
+	int64_t * weights;
+};
+
+struct vertex
+{
+	struct clib_pairing_node node;	// intrusive handle
+	uint32_t id;
+	int in_heap;
+};
+
+static double now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void dijkstra_dary(const struct graph * g, int arity, uint32_t src, int64_t * dist)
+{
+	struct clib_dary_heap heap[1];
+	clib_dary_heap_init(heap, arity, g->num_vertices, NULL);
+	for(uint32_t v = 0; v < g->num_vertices; ++v) dist[v] = INT64_MAX;
+	dist[src] = 0;
+	heap->push(heap, src, 0);
+	
+	uint32_t v;
+	int64_t d;
+	while(0 == heap->pop(heap, &v, &d)) {
+		for(uint32_t e = g->offsets[v]; e < g->offsets[v + 1]; ++e) {
+			uint32_t w = g->targets[e];
+			int64_t nd = d + g->weights[e];
+			if(nd >= dist[w]) continue;
+			if(dist[w] == INT64_MAX) heap->push(heap, w, nd);
+			else heap->decrease_key(heap, w, nd);
+			dist[w] = nd;
+		}
+	}
+	clib_dary_heap_cleanup(heap);
+}
+
+static void dijkstra_pairing(const struct graph * g, struct vertex * vertices, uint32_t src, int64_t * dist)
+{
+	struct clib_pairing_heap heap[1];
+	clib_pairing_heap_init(heap);
+	for(uint32_t v = 0; v < g->num_vertices; ++v) {
+		dist[v] = INT64_MAX;
+		vertices[v].id = v;
+		vertices[v].in_heap = 0;
+	}
+	dist[src] = 0;
+	vertices[src].node.key = 0;
+	vertices[src].in_heap = 1;
+	heap->push(heap, &vertices[src].node);
+	
+	struct clib_pairing_node * node;
+	while((node = heap->pop(heap))) {
+		struct vertex * vertex = (struct vertex *)node;	// node is the first member
+		uint32_t v = vertex->id;
+		int64_t d = node->key;
+		vertex->in_heap = 0;
+		for(uint32_t e = g->offsets[v]; e < g->offsets[v + 1]; ++e) {
+			uint32_t w = g->targets[e];
+			int64_t nd = d + g->weights[e];
+			if(nd >= dist[w]) continue;
+			dist[w] = nd;
+			if(vertices[w].in_heap) {
+				heap->decrease_key(heap, &vertices[w].node, nd);
+			}else {
+				vertices[w].node.key = nd;
+				vertices[w].in_heap = 1;
+				heap->push(heap, &vertices[w].node);
+			}
+		}
+	}
+}
+
+static void test_heaps_sort(void)
+{
+	enum { N = 5000 };
+	static struct vertex vertices[N];
+	static int64_t keys[N];
+	struct clib_pairing_heap pairing[1], pairing2[1];
+	struct clib_dary_heap dary[1], dary2[1];
+	clib_pairing_heap_init(pairing);
+	clib_pairing_heap_init(pairing2);
+	clib_dary_heap_init(dary, 3, 0, NULL);
+	clib_dary_heap_init(dary2, 3, 0, NULL);
+	
+	// push into two heaps, decrease half of the keys, meld, then pop in order
+	srand(5);
+	for(uint32_t i = 0; i < N; ++i) {
+		keys[i] = rand() % 100000;
+		vertices[i].id = i;
+		vertices[i].node.key = keys[i];
+		pairing_push((i & 1)?pairing2:pairing, &vertices[i].node);
+		((i & 1)?dary2:dary)->push((i & 1)?dary2:dary, i, keys[i]);
+	}
+	for(uint32_t i = 0; i < N; i += 2) {
+		keys[i] -= rand() % 1000;
+		pairing->decrease_key(pairing, &vertices[i].node, keys[i]);
+		dary->decrease_key(dary, i, keys[i]);
+	}
+	pairing->meld(pairing, pairing2);
+	dary->meld(dary, dary2);
+	assert(pairing->length == N && pairing2->length == 0 && dary->length == N && dary2->length == 0);
+	
+	int64_t prev = INT64_MIN;
+	for(int i = 0; i < N; ++i) {
+		struct clib_pairing_node * node = pairing->pop(pairing);
+		uint32_t id;
+		int64_t key;
+		assert(0 == dary->pop(dary, &id, &key));
+		assert(node->key == key && key >= prev && keys[id] == key && keys[((struct vertex *)node)->id] == key);
+		prev = key;
+	}
+	assert(NULL == pairing->pop(pairing) && -1 == dary->pop(dary, NULL, NULL));
+	clib_dary_heap_cleanup(dary);
+	clib_dary_heap_cleanup(dary2);
+}
+
+int main(int argc, char **argv)
+{
+	test_heaps_sort();
+	
+	// dijkstra on a random sparse graph
+	uint32_t num_vertices = (argc > 1)?atoi(argv[1]):100000;
+	uint32_t out_degree = (argc > 2)?atoi(argv[2]):8;
+	struct graph g = { .num_vertices = num_vertices };
+	g.offsets = calloc(num_vertices + 1, sizeof(*g.offsets));
+	g.targets = calloc((size_t)num_vertices * out_degree, sizeof(*g.targets));
+	g.weights = calloc((size_t)num_vertices * out_degree, sizeof(*g.weights));
+	srand(1);
+	for(uint32_t v = 0; v < num_vertices; ++v) {
+		g.offsets[v] = v * out_degree;
+		for(uint32_t i = 0; i < out_degree; ++i) {
+			g.targets[v * out_degree + i] = rand() % num_vertices;
+			g.weights[v * out_degree + i] = 1 + rand() % 1000;
+		}
+	}
+	g.offsets[num_vertices] = num_vertices * out_degree;
+	
+	int64_t * expected = calloc(num_vertices, sizeof(*expected));
+	int64_t * dist = calloc(num_vertices, sizeof(*dist));
+	struct vertex * vertices = calloc(num_vertices, sizeof(*vertices));
+	
+	const int num_queries = 5;
+	printf("dijkstra: %u vertices, %u edges, %d queries\n", num_vertices, num_vertices * out_degree, num_queries);
+	static const int arities[] = { 2, 4, 8 };
+	double elapsed[4] = { 0 };
+	for(int q = 0; q < num_queries; ++q) {
+		uint32_t src = rand() % num_vertices;
+		double begin = now_ms();
+		dijkstra_dary(&g, 2, src, expected);
+		elapsed[0] += now_ms() - begin;
+		
+		for(int i = 1; i < 3; ++i) {
+			begin = now_ms();
+			dijkstra_dary(&g, arities[i], src, dist);
+			elapsed[i] += now_ms() - begin;
+			assert(0 == memcmp(dist, expected, num_vertices * sizeof(*dist)));
+		}
+		
+		begin = now_ms();
+		dijkstra_pairing(&g, vertices, src, dist);
+		elapsed[3] += now_ms() - begin;
+		assert(0 == memcmp(dist, expected, num_vertices * sizeof(*dist)));
+	}
+	for(int i = 0; i < 3; ++i) printf("  %d-ary heap:   %8.2f ms/query\n", arities[i], elapsed[i] / num_queries);
+	printf("  pairing heap: %8.2f ms/query\n", elapsed[3] / num_queries);
+	
+	free(vertices);
+	free(dist);
+	free(expected);
+	free(g.offsets);
+	free(g.targets);
+	free(g.weights);
+	return 0;
+}
+#endif
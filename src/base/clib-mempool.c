@@ -0,0 +1,149 @@
+/*
+ * clib-mempool.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "algorithms-c-common.h"
+
+/***************************************
+ * clib_mempool: fixed-size objects carved from contiguous slabs
+ *   slab layout: [next slab pointer | padding | object 0 | object 1 | ... ]
+ *   released objects are linked through their first word (free_list).
+***************************************/
+#define CLIB_MEMPOOL_SLAB_HEADER_SIZE (16)
+#define CLIB_MEMPOOL_DEFAULT_OBJECTS_PER_SLAB (256)
+
+struct clib_mempool * clib_mempool_init(struct clib_mempool * pool, size_t object_size, size_t objects_per_slab)
+{
+	return clib_mempool_init_ex(pool, object_size, objects_per_slab, NULL);
+}
+
+struct clib_mempool * clib_mempool_init_ex(struct clib_mempool * pool, size_t object_size, size_t objects_per_slab, struct clib_allocator * allocator)
+{
+	assert(object_size > 0);
+	if(NULL == pool) pool = calloc(1, sizeof(*pool));
+	else memset(pool, 0, sizeof(*pool));
+	assert(pool);
+	
+	// size class: a multiple of 8 bytes which can hold a free-list link
+	if(object_size < sizeof(void *)) object_size = sizeof(void *);
+	object_size = (object_size + 7) & ~(size_t)7;
+	if(0 == objects_per_slab) objects_per_slab = CLIB_MEMPOOL_DEFAULT_OBJECTS_PER_SLAB;
+	
+	pool->object_size = object_size;
+	pool->objects_per_slab = objects_per_slab;
+	pool->allocator = allocator;
+	return pool;
+}
+
+static void clib_mempool_new_slab(struct clib_mempool * pool)
+{
+	size_t slab_size = CLIB_MEMPOOL_SLAB_HEADER_SIZE + pool->object_size * pool->objects_per_slab;
+	char * slab = clib_alloc(pool->allocator, slab_size);
+	assert(slab);
+	CLIB_PROBE3(clib, mempool_grow, pool, pool->num_slabs + 1, slab_size);
+	
+	*(void **)slab = pool->slabs;
+	pool->slabs = slab;
+	++pool->num_slabs;
+	
+	pool->cursor = slab + CLIB_MEMPOOL_SLAB_HEADER_SIZE;
+	pool->end = slab + slab_size;
+}
+
+void * clib_mempool_alloc(struct clib_mempool * pool)
+{
+	assert(pool && pool->object_size > 0);
+	void * object = pool->free_list;
+	if(object) {
+		pool->free_list = *(void **)object;
+	}else {
+		if(pool->cursor >= pool->end) clib_mempool_new_slab(pool);
+		object = pool->cursor;
+		pool->cursor += pool->object_size;
+	}
+	++pool->num_objects;
+	memset(object, 0, pool->object_size);
+	return object;
+}
+
+void clib_mempool_free(struct clib_mempool * pool, void * object)
+{
+	if(NULL == object) return;
+	assert(pool && pool->num_objects > 0);
+	*(void **)object = pool->free_list;
+	pool->free_list = object;
+	--pool->num_objects;
+}
+
+/*
+ * release all objects at once, keep the newest slab for reuse
+ */
+void clib_mempool_reset(struct clib_mempool * pool)
+{
+	if(NULL == pool || NULL == pool->slabs) return;
+	char * slab = pool->slabs;
+	void * next = *(void **)slab;
+	while(next) {
+		void * p = next;
+		next = *(void **)p;
+		clib_free(pool->allocator, p);
+	}
+	*(void **)slab = NULL;
+	pool->num_slabs = 1;
+	pool->num_objects = 0;
+	pool->free_list = NULL;
+	pool->cursor = slab + CLIB_MEMPOOL_SLAB_HEADER_SIZE;
+	pool->end = slab + CLIB_MEMPOOL_SLAB_HEADER_SIZE + pool->object_size * pool->objects_per_slab;
+}
+
+size_t clib_mempool_memory_usage(const struct clib_mempool * pool)
+{
+	if(NULL == pool) return 0;
+	return pool->num_slabs * (CLIB_MEMPOOL_SLAB_HEADER_SIZE + pool->object_size * pool->objects_per_slab);
+}
+
+void clib_mempool_cleanup(struct clib_mempool * pool)
+{
+	if(NULL == pool) return;
+	void * slab = pool->slabs;
+	while(slab) {
+		void * next = *(void **)slab;
+		clib_free(pool->allocator, slab);
+		slab = next;
+	}
+	pool->slabs = NULL;
+	pool->num_slabs = 0;
+	pool->num_objects = 0;
+	pool->free_list = NULL;
+	pool->cursor = pool->end = NULL;
+}
@@ -0,0 +1,473 @@
+/*
+ * clib-metrics.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "algorithms-c-common.h"
+
+#define HISTOGRAM_SUB_BUCKETS (1 << CLIB_HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_NUM_BUCKETS ((CLIB_HISTOGRAM_MAX_BITS - CLIB_HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct metrics_histogram
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[HISTOGRAM_NUM_BUCKETS];
+};
+
+// one per thread, only the owner thread writes to it
+struct metrics_shard
+{
+	struct metrics_shard * next;
+	int in_use;
+	uint64_t counters[CLIB_METRICS_MAX_METRICS];
+	struct metrics_histogram * histograms[CLIB_METRICS_MAX_METRICS];	// allocated on the first record
+};
+
+struct metrics_info
+{
+	char name[64];
+	char help[128];
+	enum clib_metrics_type type;
+};
+
+int clib_metrics_enabled;
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct metrics_info s_metrics[CLIB_METRICS_MAX_METRICS];
+static int s_num_metrics;
+static struct metrics_shard * s_shards;
+
+static pthread_once_t s_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_shard_key;
+static __thread struct metrics_shard * t_shard;
+
+void clib_metrics_enable(int enabled)
+{
+	__atomic_store_n(&clib_metrics_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+int64_t clib_metrics_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/***************************************
+ * registry
+***************************************/
+static int find_metric(const char * name)
+{
+	for(int id = 0; id < s_num_metrics; ++id) {
+		if(0 == strcmp(s_metrics[id].name, name)) return id;
+	}
+	return -1;
+}
+
+int clib_metrics_register(const char * name, const char * help, enum clib_metrics_type type)
+{
+	assert(name && strlen(name) < sizeof(s_metrics[0].name));
+	pthread_mutex_lock(&s_mutex);
+	int id = find_metric(name);
+	if(id >= 0) {
+		assert(s_metrics[id].type == type);
+	}else if(s_num_metrics < CLIB_METRICS_MAX_METRICS) {
+		id = s_num_metrics;
+		struct metrics_info * info = &s_metrics[id];
+		strncpy(info->name, name, sizeof(info->name) - 1);
+		if(help) strncpy(info->help, help, sizeof(info->help) - 1);
+		info->type = type;
+		__atomic_store_n(&s_num_metrics, id + 1, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&s_mutex);
+	return id;
+}
+
+int clib_metrics_find(const char * name)
+{
+	pthread_mutex_lock(&s_mutex);
+	int id = find_metric(name);
+	pthread_mutex_unlock(&s_mutex);
+	return id;
+}
+
+/***************************************
+ * per-thread shards
+***************************************/
+static void release_shard(void * shard)
+{
+	// keep the values, the next new thread takes over the shard
+	__atomic_store_n(&((struct metrics_shard *)shard)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_shard_key(void)
+{
+	int rc = pthread_key_create(&s_shard_key, release_shard);
+	assert(0 == rc);
+}
+
+static struct metrics_shard * get_shard(void)
+{
+	if(t_shard) return t_shard;
+	pthread_once(&s_key_once, create_shard_key);
+	
+	pthread_mutex_lock(&s_mutex);
+	struct metrics_shard * shard = s_shards;
+	while(shard && __atomic_load_n(&shard->in_use, __ATOMIC_ACQUIRE)) shard = shard->next;
+	if(NULL == shard) {
+		shard = calloc(1, sizeof(*shard));
+		assert(shard);
+		shard->next = s_shards;
+		s_shards = shard;
+	}
+	shard->in_use = 1;
+	pthread_mutex_unlock(&s_mutex);
+	
+	pthread_setspecific(s_shard_key, shard);
+	t_shard = shard;
+	return shard;
+}
+
+// single writer: a relaxed load + store is enough, readers may see a slightly old value
+static inline void shard_add(uint64_t * value, uint64_t n)
+{
+	__atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline int histogram_bucket_index(uint64_t value)
+{
+	if(value < HISTOGRAM_SUB_BUCKETS) return (int)value;
+	int msb = 63 - __builtin_clzll(value);
+	if(msb >= CLIB_HISTOGRAM_MAX_BITS) return HISTOGRAM_NUM_BUCKETS - 1;
+	int shift = msb - CLIB_HISTOGRAM_SUB_BITS;
+	return (shift + 1) * HISTOGRAM_SUB_BUCKETS + (int)(value >> shift) - HISTOGRAM_SUB_BUCKETS;
+}
+
+// the middle of the bucket
+static inline uint64_t histogram_bucket_value(int index)
+{
+	int group = index / HISTOGRAM_SUB_BUCKETS;
+	uint64_t sub = index % HISTOGRAM_SUB_BUCKETS;
+	if(0 == group) return sub;
+	int shift = group - 1;
+	return ((HISTOGRAM_SUB_BUCKETS + sub) << shift) + ((1ULL << shift) >> 1);
+}
+
+void clib_metrics_count(int id, uint64_t n)
+{
+	if(id < 0 || !clib_metrics_is_enabled()) return;
+	assert(id < CLIB_METRICS_MAX_METRICS && s_metrics[id].type == CLIB_METRICS_COUNTER);
+	shard_add(&get_shard()->counters[id], n);
+}
+
+void clib_metrics_record(int id, uint64_t value)
+{
+	if(id < 0 || !clib_metrics_is_enabled()) return;
+	assert(id < CLIB_METRICS_MAX_METRICS && s_metrics[id].type == CLIB_METRICS_HISTOGRAM);
+	struct metrics_shard * shard = get_shard();
+	struct metrics_histogram * histogram = shard->histograms[id];
+	if(NULL == histogram) {
+		histogram = calloc(1, sizeof(*histogram));
+		assert(histogram);
+		histogram->min = UINT64_MAX;
+		__atomic_store_n(&shard->histograms[id], histogram, __ATOMIC_RELEASE);
+	}
+	
+	shard_add(&histogram->buckets[histogram_bucket_index(value)], 1);
+	shard_add(&histogram->sum, value);
+	if(value < histogram->min) __atomic_store_n(&histogram->min, value, __ATOMIC_RELAXED);
+	if(value > histogram->max) __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+	shard_add(&histogram->count, 1);
+}
+
+/***************************************
+ * readers: merge all shards
+***************************************/
+uint64_t clib_metrics_counter_value(int id)
+{
+	if(id < 0 || id >= CLIB_METRICS_MAX_METRICS) return 0;
+	uint64_t value = 0;
+	pthread_mutex_lock(&s_mutex);
+	for(struct metrics_shard * shard = s_shards; shard; shard = shard->next) {
+		value += __atomic_load_n(&shard->counters[id], __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&s_mutex);
+	return value;
+}
+
+static uint64_t histogram_percentile(const struct metrics_histogram * merged, double percent)
+{
+	if(0 == merged->count) return 0;
+	uint64_t rank = (uint64_t)(percent / 100.0 * merged->count + 0.5);
+	if(rank < 1) rank = 1;
+	if(rank > merged->count) rank = merged->count;
+	
+	uint64_t total = 0;
+	for(int i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		total += merged->buckets[i];
+		if(total < rank) continue;
+		uint64_t value = histogram_bucket_value(i);
+		if(value < merged->min) value = merged->min;
+		if(value > merged->max) value = merged->max;
+		return value;
+	}
+	return merged->max;
+}
+
+int clib_metrics_histogram_summary(int id, struct clib_histogram_summary * summary)
+{
+	assert(summary);
+	memset(summary, 0, sizeof(*summary));
+	if(id < 0 || id >= CLIB_METRICS_MAX_METRICS) return -1;
+	
+	struct metrics_histogram * merged = calloc(1, sizeof(*merged));
+	assert(merged);
+	merged->min = UINT64_MAX;
+	
+	pthread_mutex_lock(&s_mutex);
+	for(struct metrics_shard * shard = s_shards; shard; shard = shard->next) {
+		const struct metrics_histogram * histogram = __atomic_load_n(&shard->histograms[id], __ATOMIC_ACQUIRE);
+		if(NULL == histogram) continue;
+		merged->count += __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+		merged->sum += __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+		uint64_t min = __atomic_load_n(&histogram->min, __ATOMIC_RELAXED);
+		uint64_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+		if(min < merged->min) merged->min = min;
+		if(max > merged->max) merged->max = max;
+		for(int i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+			merged->buckets[i] += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+		}
+	}
+	pthread_mutex_unlock(&s_mutex);
+	
+	if(merged->count) {
+		summary->count = merged->count;
+		summary->sum = merged->sum;
+		summary->min = merged->min;
+		summary->max = merged->max;
+		summary->p50 = histogram_percentile(merged, 50);
+		summary->p90 = histogram_percentile(merged, 90);
+		summary->p99 = histogram_percentile(merged, 99);
+		summary->p999 = histogram_percentile(merged, 99.9);
+	}
+	free(merged);
+	return 0;
+}
+
+/*
+ * quiescent only: a shard is written by its owner with a plain load + store (shard_add),
+ * a reset running concurrently with a record could be undone or leave a torn histogram.
+ * call it between runs (eg. after joining the workers), not as a periodic scrape-and-clear.
+ */
+void clib_metrics_reset(void)
+{
+	pthread_mutex_lock(&s_mutex);
+	for(struct metrics_shard * shard = s_shards; shard; shard = shard->next) {
+		for(int id = 0; id < CLIB_METRICS_MAX_METRICS; ++id) {
+			__atomic_store_n(&shard->counters[id], 0, __ATOMIC_RELAXED);
+			struct metrics_histogram * histogram = __atomic_load_n(&shard->histograms[id], __ATOMIC_ACQUIRE);
+			if(NULL == histogram) continue;
+			memset(histogram, 0, sizeof(*histogram));
+			histogram->min = UINT64_MAX;
+		}
+	}
+	pthread_mutex_unlock(&s_mutex);
+}
+
+/***************************************
+ * export
+***************************************/
+int clib_metrics_dump(FILE * fp, enum clib_metrics_format format)
+{
+	assert(fp);
+	int num_metrics = __atomic_load_n(&s_num_metrics, __ATOMIC_ACQUIRE);
+	int is_json = (format == CLIB_METRICS_FORMAT_JSON);
+	
+	if(is_json) fprintf(fp, "{\"counters\":{");
+	int first = 1;
+	for(int id = 0; id < num_metrics; ++id) {
+		const struct metrics_info * info = &s_metrics[id];
+		if(info->type != CLIB_METRICS_COUNTER) continue;
+		uint64_t value = clib_metrics_counter_value(id);
+		if(is_json) {
+			fprintf(fp, "%s\"%s\":%llu", first?"":",", info->name, (unsigned long long)value);
+		}else {
+			fprintf(fp, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", 
+				info->name, info->help, info->name, info->name, (unsigned long long)value);
+		}
+		first = 0;
+	}
+	
+	if(is_json) fprintf(fp, "},\"histograms\":{");
+	first = 1;
+	for(int id = 0; id < num_metrics; ++id) {
+		const struct metrics_info * info = &s_metrics[id];
+		if(info->type != CLIB_METRICS_HISTOGRAM) continue;
+		struct clib_histogram_summary summary;
+		clib_metrics_histogram_summary(id, &summary);
+		if(is_json) {
+			fprintf(fp, "%s\"%s\":{\"count\":%llu,\"sum_ns\":%llu,\"min_ns\":%llu,\"max_ns\":%llu,"
+				"\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}",
+				first?"":",", info->name,
+				(unsigned long long)summary.count, (unsigned long long)summary.sum,
+				(unsigned long long)summary.min, (unsigned long long)summary.max,
+				(unsigned long long)summary.p50, (unsigned long long)summary.p90,
+				(unsigned long long)summary.p99, (unsigned long long)summary.p999);
+		}else {
+			fprintf(fp, "# HELP %s %s\n# TYPE %s summary\n", info->name, info->help, info->name);
+			fprintf(fp, "%s{quantile=\"0.5\"} %.9f\n", info->name, summary.p50 / 1e9);
+			fprintf(fp, "%s{quantile=\"0.9\"} %.9f\n", info->name, summary.p90 / 1e9);
+			fprintf(fp, "%s{quantile=\"0.99\"} %.9f\n", info->name, summary.p99 / 1e9);
+			fprintf(fp, "%s{quantile=\"0.999\"} %.9f\n", info->name, summary.p999 / 1e9);
+			fprintf(fp, "%s_sum %.9f\n%s_count %llu\n", info->name, summary.sum / 1e9, 
+				info->name, (unsigned long long)summary.count);
+		}
+		first = 0;
+	}
+	if(is_json) fprintf(fp, "}}\n");
+	return ferror(fp)?-1:0;
+}
+
+int clib_metrics_dump_file(const char * path, enum clib_metrics_format format)
+{
+	assert(path);
+	size_t length = strlen(path);
+	char * tmp_path = malloc(length + sizeof(".tmp"));
+	assert(tmp_path);
+	memcpy(tmp_path, path, length);
+	memcpy(tmp_path + length, ".tmp", sizeof(".tmp"));
+	
+	int rc = -1;
+	FILE * fp = fopen(tmp_path, "w");
+	if(fp) {
+		rc = clib_metrics_dump(fp, format);
+		if(fclose(fp)) rc = -1;
+		if(0 == rc) rc = rename(tmp_path, path);
+		if(rc) remove(tmp_path);
+	}
+	free(tmp_path);
+	return rc;
+}
+
+
+/****************************************************
+ * TEST_MODULE::clib-metrics
+ * build:
+ *   tests/make.sh metrics
+****************************************************/
+#if defined(TEST_CLIB_METRICS) && defined(ALGORITHMS_C_STAND_ALONE)
+#define NUM_THREADS (4)
+#define NUM_SAMPLES (100000)
+
+static int s_counter_id = -1;
+static int s_histogram_id = -1;
+
+static void * record_thread(void * arg)
+{
+	(void)arg;
+	for(uint64_t i = 0; i < NUM_SAMPLES; ++i) {
+		clib_metrics_count(s_counter_id, 1);
+		clib_metrics_record(s_histogram_id, (i + 1) * 1000);	// uniform in [1us, 100ms]
+	}
+	return NULL;
+}
+
+static void run_threads(void)
+{
+	pthread_t threads[NUM_THREADS];
+	for(int i = 0; i < NUM_THREADS; ++i) pthread_create(&threads[i], NULL, record_thread, NULL);
+	for(int i = 0; i < NUM_THREADS; ++i) pthread_join(threads[i], NULL);
+}
+
+int main(int argc, char **argv)
+{
+	// bucket boundaries
+	for(uint64_t value = 1; value < (1ULL << 36); value = value * 3 / 2 + 1) {
+		int index = histogram_bucket_index(value);
+		uint64_t middle = histogram_bucket_value(index);
+		assert(histogram_bucket_index(middle) == index);
+		assert(middle * 32 >= value * 31 && middle * 31 <= value * 32);
+	}
+	
+	s_counter_id = clib_metrics_register("test_events_total", "test counter", CLIB_METRICS_COUNTER);
+	s_histogram_id = clib_metrics_register("test_latency_seconds", "test latency", CLIB_METRICS_HISTOGRAM);
+	assert(s_counter_id >= 0 && s_histogram_id >= 0 && s_counter_id != s_histogram_id);
+	assert(clib_metrics_register("test_events_total", NULL, CLIB_METRICS_COUNTER) == s_counter_id);
+	assert(clib_metrics_find("test_latency_seconds") == s_histogram_id && clib_metrics_find("none") == -1);
+	
+	// disabled: nothing is recorded
+	record_thread(NULL);
+	assert(0 == clib_metrics_counter_value(s_counter_id));
+	
+	clib_metrics_enable(1);
+	run_threads();
+	run_threads();	// the shards of the exited threads are reused
+	
+	struct clib_histogram_summary summary;
+	clib_metrics_histogram_summary(s_histogram_id, &summary);
+	const uint64_t count = 2 * NUM_THREADS * NUM_SAMPLES;
+	assert(clib_metrics_counter_value(s_counter_id) == count);
+	assert(summary.count == count);
+	assert(summary.sum == 2 * NUM_THREADS * (uint64_t)NUM_SAMPLES * (NUM_SAMPLES + 1) / 2 * 1000);
+	assert(summary.min == 1000 && summary.max == NUM_SAMPLES * 1000ULL);
+	
+	// ~3% relative error
+	const uint64_t expected[] = { 50000000, 90000000, 99000000, 99900000 };
+	const uint64_t actual[] = { summary.p50, summary.p90, summary.p99, summary.p999 };
+	for(int i = 0; i < 4; ++i) {
+		printf("percentile[%d]: expected=%llu, actual=%llu\n", i, (unsigned long long)expected[i], (unsigned long long)actual[i]);
+		assert(actual[i] * 100 >= expected[i] * 97 && actual[i] * 100 <= expected[i] * 103);
+	}
+	
+	// memory growth of the pointer arrays: 16 slots, then 32
+	struct clib_pointer_array array[1];
+	clib_pointer_array_init(array, 16);
+	clib_pointer_array_set_length(array, 17);
+	assert(clib_metrics_counter_value(clib_metrics_find("clib_pointer_array_grown_bytes_total")) == 32 * sizeof(void *));
+	clib_pointer_array_cleanup(array, NULL);
+	
+	clib_metrics_dump(stdout, CLIB_METRICS_FORMAT_PROMETHEUS);
+	clib_metrics_dump(stdout, CLIB_METRICS_FORMAT_JSON);
+	const char * path = (argc > 1)?argv[1]:"/tmp/clib-metrics-test.json";
+	assert(0 == clib_metrics_dump_file(path, CLIB_METRICS_FORMAT_JSON));
+	
+	clib_metrics_reset();
+	clib_metrics_histogram_summary(s_histogram_id, &summary);
+	assert(0 == summary.count && 0 == clib_metrics_counter_value(s_counter_id));
+	return 0;
+}
+#endif
@@ -0,0 +1,328 @@
+/*
+ * clib-mpmc-queue.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "algorithms-c-common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do { } while(0)
+#endif
+
+static inline size_t load_acquire(const size_t * p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline size_t load_relaxed(const size_t * p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void store_release(size_t * p, size_t value) { __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+static inline int cas_relaxed(size_t * p, size_t * expected, size_t desired) 
+{
+	return __atomic_compare_exchange_n(p, expected, desired, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+static int mpmc_enqueue(struct clib_mpmc_queue * queue, void * data)
+{
+	const size_t mask = queue->size - 1;
+	size_t pos = load_relaxed(&queue->enqueue_pos);
+	struct clib_mpmc_cell * cell = NULL;
+	while(1) {
+		cell = &queue->cells[pos & mask];
+		intptr_t diff = (intptr_t)load_acquire(&cell->sequence) - (intptr_t)pos;
+		if(diff == 0) {
+			if(cas_relaxed(&queue->enqueue_pos, &pos, pos + 1)) break;
+		}else if(diff < 0) {
+			return -1; // full
+		}else {
+			pos = load_relaxed(&queue->enqueue_pos);
+		}
+	}
+	cell->data = data;
+	store_release(&cell->sequence, pos + 1);
+	return 0;
+}
+
+static int mpmc_dequeue(struct clib_mpmc_queue * queue, void ** p_data)
+{
+	const size_t mask = queue->size - 1;
+	size_t pos = load_relaxed(&queue->dequeue_pos);
+	struct clib_mpmc_cell * cell = NULL;
+	while(1) {
+		cell = &queue->cells[pos & mask];
+		intptr_t diff = (intptr_t)load_acquire(&cell->sequence) - (intptr_t)(pos + 1);
+		if(diff == 0) {
+			if(cas_relaxed(&queue->dequeue_pos, &pos, pos + 1)) break;
+		}else if(diff < 0) {
+			return -1; // empty
+		}else {
+			pos = load_relaxed(&queue->dequeue_pos);
+		}
+	}
+	if(p_data) *p_data = cell->data;
+	store_release(&cell->sequence, pos + mask + 1);
+	return 0;
+}
+
+/*
+ * batch operations:
+ *   claim [pos, pos + n) with one CAS once the last cell of the range is ready.
+ *   the positions are claimed in order on both sides, so the cells before the last one are ready too,
+ *   or are being released by a thread which has already claimed them (a short spin).
+ */
+static size_t mpmc_enqueue_batch(struct clib_mpmc_queue * queue, void ** items, size_t count)
+{
+	if(0 == count) return 0;
+	const size_t mask = queue->size - 1;
+	size_t pos = load_relaxed(&queue->enqueue_pos);
+	size_t n = 0;
+	while(1) {
+		intptr_t space = (intptr_t)(load_relaxed(&queue->dequeue_pos) + queue->size - pos);
+		if(space <= 0) space = 1; // stale counters, let the first cell decide
+		n = ((size_t)space < count)?(size_t)space:count;
+		
+		while(n > 0 && load_acquire(&queue->cells[(pos + n - 1) & mask].sequence) != pos + n - 1) n >>= 1;
+		if(n == 0) {
+			intptr_t diff = (intptr_t)load_acquire(&queue->cells[pos & mask].sequence) - (intptr_t)pos;
+			if(diff < 0) return 0; // full
+			pos = load_relaxed(&queue->enqueue_pos);
+			continue;
+		}
+		if(cas_relaxed(&queue->enqueue_pos, &pos, pos + n)) break;
+	}
+	
+	for(size_t i = 0; i < n; ++i) {
+		struct clib_mpmc_cell * cell = &queue->cells[(pos + i) & mask];
+		while(load_acquire(&cell->sequence) != pos + i) cpu_relax();
+		cell->data = items[i];
+		store_release(&cell->sequence, pos + i + 1);
+	}
+	return n;
+}
+
+static size_t mpmc_dequeue_batch(struct clib_mpmc_queue * queue, void ** items, size_t max_count)
+{
+	if(0 == max_count) return 0;
+	const size_t mask = queue->size - 1;
+	size_t pos = load_relaxed(&queue->dequeue_pos);
+	size_t n = 0;
+	while(1) {
+		intptr_t available = (intptr_t)(load_relaxed(&queue->enqueue_pos) - pos);
+		if(available <= 0) available = 1;
+		n = ((size_t)available < max_count)?(size_t)available:max_count;
+		
+		while(n > 0 && load_acquire(&queue->cells[(pos + n - 1) & mask].sequence) != pos + n) n >>= 1;
+		if(n == 0) {
+			intptr_t diff = (intptr_t)load_acquire(&queue->cells[pos & mask].sequence) - (intptr_t)(pos + 1);
+			if(diff < 0) return 0; // empty
+			pos = load_relaxed(&queue->dequeue_pos);
+			continue;
+		}
+		if(cas_relaxed(&queue->dequeue_pos, &pos, pos + n)) break;
+	}
+	
+	for(size_t i = 0; i < n; ++i) {
+		struct clib_mpmc_cell * cell = &queue->cells[(pos + i) & mask];
+		while(load_acquire(&cell->sequence) != pos + i + 1) cpu_relax();
+		items[i] = cell->data;
+		store_release(&cell->sequence, pos + i + mask + 1);
+	}
+	return n;
+}
+
+struct clib_mpmc_queue * clib_mpmc_queue_init(struct clib_mpmc_queue * queue, size_t size)
+{
+	if(NULL == queue) queue = aligned_alloc(CLIB_CACHE_LINE_SIZE, sizeof(*queue));
+	assert(queue);
+	memset(queue, 0, sizeof(*queue));
+	
+	if(size < 2) size = 2;
+	if(size & (size - 1)) size = (size_t)1 << (64 - __builtin_clzll((unsigned long long)size));
+	queue->size = size;
+	queue->cells = aligned_alloc(CLIB_CACHE_LINE_SIZE, size * sizeof(*queue->cells));
+	assert(queue->cells);
+	for(size_t i = 0; i < size; ++i) {
+		queue->cells[i].sequence = i;
+		queue->cells[i].data = NULL;
+	}
+	
+	queue->enqueue = mpmc_enqueue;
+	queue->dequeue = mpmc_dequeue;
+	queue->enqueue_batch = mpmc_enqueue_batch;
+	queue->dequeue_batch = mpmc_dequeue_batch;
+	return queue;
+}
+
+void clib_mpmc_queue_cleanup(struct clib_mpmc_queue * queue)
+{
+	if(NULL == queue) return;
+	free(queue->cells);
+	queue->cells = NULL;
+	queue->size = 0;
+}
+
+
+/****************************************************
+ * TEST_MODULE::clib-mpmc-queue
+ * build:
+ *   tests/make.sh mpmc-queue
+ * run:
+ *   tests/mpmc-queue [num_producers] [num_consumers] [batch_size]
+****************************************************/
+#if defined(TEST_CLIB_MPMC_QUEUE) && defined(ALGORITHMS_C_STAND_ALONE)
+#include <pthread.h>
+#include <time.h>
+
+#define ITEMS_PER_PRODUCER (1000000)
+struct bench_context
+{
+	struct clib_mpmc_queue * queue;
+	int batch_size;
+	size_t items_per_consumer;
+	uint64_t sum;
+};
+
+static void * producer_thread(void * user_data)
+{
+	struct bench_context * ctx = user_data;
+	void * items[64];
+	size_t value = 1;
+	while(value <= ITEMS_PER_PRODUCER) {
+		if(ctx->batch_size <= 1) {
+			if(0 == ctx->queue->enqueue(ctx->queue, (void *)(uintptr_t)value)) ++value;
+			else sched_yield();
+			continue;
+		}
+		size_t n = 0;
+		for(; n < (size_t)ctx->batch_size && value + n <= ITEMS_PER_PRODUCER; ++n) items[n] = (void *)(uintptr_t)(value + n);
+		size_t sent = 0;
+		while(sent < n) {
+			size_t k = ctx->queue->enqueue_batch(ctx->queue, items + sent, n - sent);
+			if(0 == k) sched_yield();
+			sent += k;
+		}
+		value += n;
+	}
+	return NULL;
+}
+
+static void * consumer_thread(void * user_data)
+{
+	struct bench_context * ctx = user_data;
+	void * items[64];
+	size_t received = 0;
+	uint64_t sum = 0;
+	while(received < ctx->items_per_consumer) {
+		size_t max_count = ctx->items_per_consumer - received;
+		if(max_count > (size_t)ctx->batch_size) max_count = ctx->batch_size;
+		size_t n = 0;
+		if(ctx->batch_size <= 1) n = (0 == ctx->queue->dequeue(ctx->queue, &items[0]));
+		else n = ctx->queue->dequeue_batch(ctx->queue, items, max_count);
+		if(0 == n) { sched_yield(); continue; }
+		for(size_t i = 0; i < n; ++i) sum += (uintptr_t)items[i];
+		received += n;
+	}
+	ctx->sum = sum;
+	return NULL;
+}
+
+static double run_benchmark(int num_producers, int num_consumers, int batch_size)
+{
+	struct clib_mpmc_queue * queue = clib_mpmc_queue_init(NULL, 4096);
+	size_t total = (size_t)num_producers * ITEMS_PER_PRODUCER;
+	assert(total % num_consumers == 0);
+	
+	struct bench_context producers[num_producers], consumers[num_consumers];
+	pthread_t threads[num_producers + num_consumers];
+	
+	struct timespec start, finish;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int i = 0; i < num_consumers; ++i) {
+		consumers[i] = (struct bench_context){ .queue = queue, .batch_size = batch_size, .items_per_consumer = total / num_consumers };
+		pthread_create(&threads[i], NULL, consumer_thread, &consumers[i]);
+	}
+	for(int i = 0; i < num_producers; ++i) {
+		producers[i] = (struct bench_context){ .queue = queue, .batch_size = batch_size };
+		pthread_create(&threads[num_consumers + i], NULL, producer_thread, &producers[i]);
+	}
+	for(int i = 0; i < num_producers + num_consumers; ++i) pthread_join(threads[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	
+	// every item must be received exactly once
+	uint64_t sum = 0;
+	for(int i = 0; i < num_consumers; ++i) sum += consumers[i].sum;
+	uint64_t expected = (uint64_t)num_producers * ITEMS_PER_PRODUCER * (ITEMS_PER_PRODUCER + 1) / 2;
+	assert(sum == expected);
+	assert(queue->enqueue_pos == total && queue->dequeue_pos == total);
+	
+	double seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+	printf("  producers=%d, consumers=%d, batch=%2d: %8.2f M items/s\n", 
+		num_producers, num_consumers, batch_size, total / seconds / 1e6);
+	clib_mpmc_queue_cleanup(queue);
+	free(queue);
+	return seconds;
+}
+
+int main(int argc, char **argv)
+{
+	// single thread: full / empty
+	struct clib_mpmc_queue queue[1];
+	clib_mpmc_queue_init(queue, 5);
+	assert(queue->size == 8);
+	void * data = NULL;
+	assert(-1 == queue->dequeue(queue, &data));
+	for(uintptr_t i = 0; i < 8; ++i) assert(0 == queue->enqueue(queue, (void *)(i + 1)));
+	assert(-1 == queue->enqueue(queue, (void *)100));
+	for(uintptr_t i = 0; i < 3; ++i) assert(0 == queue->dequeue(queue, &data) && (uintptr_t)data == i + 1);
+	void * items[16] = { NULL };
+	assert(3 == queue->enqueue_batch(queue, items, 16));
+	assert(8 == queue->dequeue_batch(queue, items, 16));
+	assert((uintptr_t)items[0] == 4 && (uintptr_t)items[4] == 8 && items[5] == NULL);
+	assert(0 == queue->dequeue_batch(queue, items, 16));
+	clib_mpmc_queue_cleanup(queue);
+	
+	// throughput under contention
+	int num_producers = 0, num_consumers = 0, batch_size = 0;
+	if(argc > 1) num_producers = atoi(argv[1]);
+	if(argc > 2) num_consumers = atoi(argv[2]);
+	if(argc > 3) batch_size = atoi(argv[3]);
+	if(num_producers > 0 && num_consumers > 0) {
+		if(batch_size < 1 || batch_size > 64) batch_size = 1;
+		run_benchmark(num_producers, num_consumers, batch_size);
+		return 0;
+	}
+	
+	static const int configs[][2] = { {1, 1}, {2, 2}, {4, 4}, {4, 1}, {1, 4} };
+	for(size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); ++i) {
+		run_benchmark(configs[i][0], configs[i][1], 1);
+		run_benchmark(configs[i][0], configs[i][1], 16);
+	}
+	return 0;
+}
+#endif
@@ -37,10 +37,7 @@ static int clib_queue_enter(struct clib_queue * queue, void * data)
 {
 	assert(queue);
 	struct clib_slist * list = (struct clib_slist *)queue;
-	struct clib_slist_node * node = calloc(1, sizeof(*node));
-	assert(node);
-	node->data = data;
-	node->next = NULL;
+	struct clib_slist_node * node = clib_slist_node_new(list, data);
 	
 	if(NULL == list->head) list->head = node;
 	else list->tail->next = node;
@@ -66,15 +63,21 @@ static void * clib_queue_leave(struct clib_queue * queue)
 		assert(list->length == 0);
 		list->tail = NULL;
 	}
-	free(node);
+	clib_slist_node_free(list, node);
 	return data;
 }
 
 struct clib_queue * clib_queue_init(struct clib_queue * queue)
 {
-	if(NULL == queue) queue = calloc(1, sizeof(*queue));
+	return clib_queue_init_ex(queue, NULL);
+}
+
+struct clib_queue * clib_queue_init_ex(struct clib_queue * queue, struct clib_allocator * allocator)
+{
+	if(NULL == queue) queue = clib_alloc(allocator, sizeof(*queue));
 	else memset(queue, 0, sizeof(*queue));
 	assert(queue);
+	queue->base->allocator = allocator;
 	
 	queue->enter = clib_queue_enter;
 	queue->leave = clib_queue_leave;
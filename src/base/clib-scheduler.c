@@ -0,0 +1,596 @@
+/*
+ * clib-scheduler.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "algorithms-c-common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do { } while(0)
+#endif
+
+#define INJECTION_QUEUE_SIZE (4096)
+#define BACKOFF_SPIN_ROUNDS  (64)
+#define BACKOFF_YIELD_ROUNDS (16)
+#define IDLE_WAIT_NS (1000000)	// re-check for work at least every 1ms while sleeping
+
+struct task
+{
+	void (* func)(void * arg);
+	void * arg;
+	struct clib_task_group * group;
+	
+	// sub-range of a parallel_for()
+	const struct loop_body * loop;
+	size_t begin;
+	size_t end;
+};
+
+struct loop_body
+{
+	void (* body)(size_t begin, size_t end, void * arg);
+	void * arg;
+	size_t grain_size;
+};
+
+/***************************************
+ * task_deque: Chase-Lev work-stealing deque
+ *   (memory orders from Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013)
+ *   the owner pushes / pops at bottom, thieves take from top.
+ *   outgrown buffers are kept in the retired list until cleanup, a thief may still read them.
+***************************************/
+struct task_buffer
+{
+	int64_t size;	// power of 2
+	struct task_buffer * retired;
+	struct task * tasks[];
+};
+
+struct task_deque
+{
+	int64_t top __attribute__((aligned(CLIB_CACHE_LINE_SIZE)));
+	int64_t bottom __attribute__((aligned(CLIB_CACHE_LINE_SIZE)));
+	struct task_buffer * buffer;
+};
+
+static struct task_buffer * task_buffer_new(int64_t size)
+{
+	struct task_buffer * buffer = calloc(1, sizeof(*buffer) + size * sizeof(buffer->tasks[0]));
+	assert(buffer);
+	buffer->size = size;
+	return buffer;
+}
+
+static inline struct task * task_buffer_get(struct task_buffer * buffer, int64_t index)
+{
+	return __atomic_load_n(&buffer->tasks[index & (buffer->size - 1)], __ATOMIC_RELAXED);
+}
+static inline void task_buffer_set(struct task_buffer * buffer, int64_t index, struct task * task)
+{
+	__atomic_store_n(&buffer->tasks[index & (buffer->size - 1)], task, __ATOMIC_RELAXED);
+}
+
+static void task_deque_init(struct task_deque * deque, int64_t size)
+{
+	memset(deque, 0, sizeof(*deque));
+	deque->buffer = task_buffer_new(size);
+}
+
+static void task_deque_cleanup(struct task_deque * deque)
+{
+	struct task_buffer * buffer = deque->buffer;
+	while(buffer) {
+		struct task_buffer * retired = buffer->retired;
+		free(buffer);
+		buffer = retired;
+	}
+	deque->buffer = NULL;
+}
+
+static void task_deque_push(struct task_deque * deque, struct task * task)
+{
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+	struct task_buffer * buffer = __atomic_load_n(&deque->buffer, __ATOMIC_RELAXED);
+	if((bottom - top) > (buffer->size - 1)) {
+		struct task_buffer * larger = task_buffer_new(buffer->size * 2);
+		for(int64_t i = top; i < bottom; ++i) task_buffer_set(larger, i, task_buffer_get(buffer, i));
+		larger->retired = buffer;
+		__atomic_store_n(&deque->buffer, larger, __ATOMIC_RELEASE);
+		buffer = larger;
+	}
+	task_buffer_set(buffer, bottom, task);
+	__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);	// publishes the task to the thieves
+}
+
+static struct task * task_deque_pop(struct task_deque * deque)
+{
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+	struct task_buffer * buffer = __atomic_load_n(&deque->buffer, __ATOMIC_RELAXED);
+	__atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+	
+	struct task * task = NULL;
+	if(top <= bottom) {
+		task = task_buffer_get(buffer, bottom);
+		if(top == bottom) { // the last one, race against the thieves
+			if(!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) task = NULL;
+			__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+		}
+	}else {
+		__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+	}
+	return task;
+}
+
+static struct task * task_deque_steal(struct task_deque * deque)
+{
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+	if(top >= bottom) return NULL;
+	
+	struct task_buffer * buffer = __atomic_load_n(&deque->buffer, __ATOMIC_ACQUIRE);
+	struct task * task = task_buffer_get(buffer, top);
+	if(!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) return NULL;
+	return task;
+}
+
+/***************************************
+ * scheduler
+***************************************/
+struct worker
+{
+	struct task_deque deque[1];
+	struct scheduler_private * priv;
+	int id;
+	uint32_t rand_state;
+	pthread_t th;
+};
+
+struct scheduler_private
+{
+	struct clib_scheduler * scheduler;
+	int num_workers;
+	struct worker * workers;
+	struct clib_mpmc_queue injection[1];	// tasks spawned by the threads outside of the pool
+	
+	int quit;
+	int num_sleepers;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+static __thread struct worker * s_current_worker;
+
+int clib_scheduler_worker_id(void)
+{
+	return s_current_worker?s_current_worker->id:-1;
+}
+
+static inline uint32_t xorshift32(uint32_t * state)
+{
+	uint32_t x = *state;
+	x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void wake_sleepers(struct scheduler_private * priv)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(0 == __atomic_load_n(&priv->num_sleepers, __ATOMIC_RELAXED)) return;
+	pthread_mutex_lock(&priv->mutex);
+	pthread_cond_signal(&priv->cond);
+	pthread_mutex_unlock(&priv->mutex);
+}
+
+static void execute_task(struct scheduler_private * priv, struct task * task);
+
+static void submit_task(struct scheduler_private * priv, struct task * task)
+{
+	struct worker * worker = s_current_worker;
+	if(worker && worker->priv == priv) {
+		task_deque_push(worker->deque, task);
+	}else if(0 != priv->injection->enqueue(priv->injection, task)) {
+		execute_task(priv, task); // the injection queue is full, run it in place
+		return;
+	}
+	wake_sleepers(priv);
+}
+
+static struct task * find_task(struct scheduler_private * priv, struct worker * worker)
+{
+	struct task * task = NULL;
+	if(worker && worker->priv == priv) {
+		task = task_deque_pop(worker->deque);
+		if(task) return task;
+	}
+	
+	void * data = NULL;
+	if(0 == priv->injection->dequeue(priv->injection, &data)) return data;
+	
+	// steal from random victims
+	static __thread uint32_t s_rand_state;
+	uint32_t * rand_state = worker?&worker->rand_state:&s_rand_state;
+	if(0 == *rand_state) *rand_state = (uint32_t)(uintptr_t)&data | 1;
+	
+	int num_workers = priv->num_workers;
+	int start = xorshift32(rand_state) % num_workers;
+	for(int i = 0; i < num_workers; ++i) {
+		struct worker * victim = &priv->workers[(start + i) % num_workers];
+		if(victim == worker) continue;
+		task = task_deque_steal(victim->deque);
+		if(task) return task;
+	}
+	return NULL;
+}
+
+static void run_loop(struct scheduler_private * priv, const struct loop_body * loop, size_t begin, size_t end, struct clib_task_group * group);
+static void execute_task(struct scheduler_private * priv, struct task * task)
+{
+	struct clib_task_group * group = task->group;
+	if(task->loop) run_loop(priv, task->loop, task->begin, task->end, group);
+	else task->func(task->arg);
+	free(task);
+	__atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * backoff: spin with pause first, then yield the cpu, then sleep on the condition variable.
+ *  the timed wait bounds the cost of a wakeup lost between the last check and the wait.
+ */
+static void idle_backoff(struct scheduler_private * priv, int * rounds)
+{
+	int n = (*rounds)++;
+	if(n < BACKOFF_SPIN_ROUNDS) {
+		for(int i = 0; i < (1 << (n < 6?n:6)); ++i) cpu_relax();
+		return;
+	}
+	if(n < BACKOFF_SPIN_ROUNDS + BACKOFF_YIELD_ROUNDS) {
+		sched_yield();
+		return;
+	}
+	
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += IDLE_WAIT_NS;
+	if(deadline.tv_nsec >= 1000000000) { deadline.tv_sec += 1; deadline.tv_nsec -= 1000000000; }
+	
+	pthread_mutex_lock(&priv->mutex);
+	__atomic_add_fetch(&priv->num_sleepers, 1, __ATOMIC_SEQ_CST);
+	if(!__atomic_load_n(&priv->quit, __ATOMIC_ACQUIRE)) pthread_cond_timedwait(&priv->cond, &priv->mutex, &deadline);
+	__atomic_sub_fetch(&priv->num_sleepers, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&priv->mutex);
+}
+
+static void * worker_thread(void * user_data)
+{
+	struct worker * worker = user_data;
+	struct scheduler_private * priv = worker->priv;
+	s_current_worker = worker;
+	
+	int rounds = 0;
+	while(!__atomic_load_n(&priv->quit, __ATOMIC_ACQUIRE)) {
+		struct task * task = find_task(priv, worker);
+		if(NULL == task) {
+			idle_backoff(priv, &rounds);
+			continue;
+		}
+		rounds = 0;
+		execute_task(priv, task);
+	}
+	s_current_worker = NULL;
+	return NULL;
+}
+
+static void scheduler_spawn(struct clib_scheduler * scheduler, struct clib_task_group * group, void (* func)(void * arg), void * arg)
+{
+	assert(scheduler && scheduler->priv && group && func);
+	struct task * task = calloc(1, sizeof(*task));
+	assert(task);
+	task->func = func;
+	task->arg = arg;
+	task->group = group;
+	
+	__atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+	submit_task(scheduler->priv, task);
+}
+
+static void scheduler_sync(struct clib_scheduler * scheduler, struct clib_task_group * group)
+{
+	assert(scheduler && scheduler->priv && group);
+	struct scheduler_private * priv = scheduler->priv;
+	
+	// help with the pending tasks instead of blocking
+	int rounds = 0;
+	while(__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+		struct task * task = find_task(priv, s_current_worker);
+		if(NULL == task) {
+			if(rounds < BACKOFF_SPIN_ROUNDS + BACKOFF_YIELD_ROUNDS) idle_backoff(priv, &rounds);
+			else sched_yield(); // never sleep here, the group is finished by other threads
+			continue;
+		}
+		rounds = 0;
+		execute_task(priv, task);
+	}
+}
+
+/*
+ * parallel_for: splits the range in halves, spawns the right half and keeps the left one,
+ *   until the range fits in grain_size. the spawned halves are split again by the thieves.
+ */
+static void run_loop(struct scheduler_private * priv, const struct loop_body * loop, size_t begin, size_t end, struct clib_task_group * group)
+{
+	while((end - begin) > loop->grain_size) {
+		size_t mid = begin + (end - begin) / 2;
+		struct task * task = calloc(1, sizeof(*task));
+		assert(task);
+		task->loop = loop;
+		task->begin = mid;
+		task->end = end;
+		task->group = group;
+		__atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+		submit_task(priv, task);
+		end = mid;
+	}
+	loop->body(begin, end, loop->arg);
+}
+
+static void scheduler_parallel_for(struct clib_scheduler * scheduler, size_t begin, size_t end, size_t grain_size,
+	void (* body)(size_t begin, size_t end, void * arg), void * arg)
+{
+	assert(scheduler && scheduler->priv && body);
+	if(begin >= end) return;
+	
+	struct scheduler_private * priv = scheduler->priv;
+	if(0 == grain_size) {
+		// ~8 chunks per worker
+		grain_size = (end - begin) / ((size_t)priv->num_workers * 8);
+		if(0 == grain_size) grain_size = 1;
+	}
+	struct loop_body loop = { .body = body, .arg = arg, .grain_size = grain_size };
+	struct clib_task_group group = { 0 };
+	
+	run_loop(priv, &loop, begin, end, &group);
+	scheduler_sync(scheduler, &group);
+}
+
+static int get_env_int(const char * name, int default_value)
+{
+	const char * value = getenv(name);
+	if(NULL == value || !value[0]) return default_value;
+	return atoi(value);
+}
+
+static void pin_worker(struct worker * worker)
+{
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(num_cpus <= 0) return;
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(worker->id % num_cpus, &cpus);
+	int rc = pthread_setaffinity_np(worker->th, sizeof(cpus), &cpus);
+	if(rc) debug_printf("[WARN]::%s(worker=%d): pthread_setaffinity_np() failed: %s\n", __FUNCTION__, worker->id, strerror(rc));
+}
+
+struct clib_scheduler * clib_scheduler_init(struct clib_scheduler * scheduler, int num_workers, int flags)
+{
+	if(NULL == scheduler) scheduler = calloc(1, sizeof(*scheduler));
+	else memset(scheduler, 0, sizeof(*scheduler));
+	assert(scheduler);
+	
+	if(num_workers <= 0) num_workers = get_env_int("CLIB_NUM_THREADS", 0);
+	if(num_workers <= 0) num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(num_workers <= 0) num_workers = 1;
+	if(get_env_int("CLIB_PIN_THREADS", 0) > 0) flags |= CLIB_SCHEDULER_PIN_WORKERS;
+	
+	scheduler->num_workers = num_workers;
+	scheduler->flags = flags;
+	scheduler->spawn = scheduler_spawn;
+	scheduler->sync = scheduler_sync;
+	scheduler->parallel_for = scheduler_parallel_for;
+	
+	struct scheduler_private * priv = calloc(1, sizeof(*priv));
+	assert(priv);
+	priv->scheduler = scheduler;
+	priv->num_workers = num_workers;
+	pthread_mutex_init(&priv->mutex, NULL);
+	pthread_cond_init(&priv->cond, NULL);
+	clib_mpmc_queue_init(priv->injection, INJECTION_QUEUE_SIZE);
+	
+	priv->workers = aligned_alloc(CLIB_CACHE_LINE_SIZE, num_workers * sizeof(*priv->workers));
+	assert(priv->workers);
+	memset(priv->workers, 0, num_workers * sizeof(*priv->workers));
+	for(int i = 0; i < num_workers; ++i) {
+		struct worker * worker = &priv->workers[i];
+		task_deque_init(worker->deque, 256);
+		worker->priv = priv;
+		worker->id = i;
+		worker->rand_state = 2654435761u * (i + 1);
+	}
+	scheduler->priv = priv;
+	
+	for(int i = 0; i < num_workers; ++i) {
+		struct worker * worker = &priv->workers[i];
+		int rc = pthread_create(&worker->th, NULL, worker_thread, worker);
+		assert(0 == rc);
+		if(flags & CLIB_SCHEDULER_PIN_WORKERS) pin_worker(worker);
+	}
+	return scheduler;
+}
+
+void clib_scheduler_cleanup(struct clib_scheduler * scheduler)
+{
+	if(NULL == scheduler || NULL == scheduler->priv) return;
+	struct scheduler_private * priv = scheduler->priv;
+	
+	pthread_mutex_lock(&priv->mutex);
+	__atomic_store_n(&priv->quit, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&priv->cond);
+	pthread_mutex_unlock(&priv->mutex);
+	
+	for(int i = 0; i < priv->num_workers; ++i) {
+		pthread_join(priv->workers[i].th, NULL);
+	}
+	for(int i = 0; i < priv->num_workers; ++i) {
+		struct task * task = NULL;
+		while((task = task_deque_pop(priv->workers[i].deque))) free(task);
+		task_deque_cleanup(priv->workers[i].deque);
+	}
+	void * data = NULL;
+	while(0 == priv->injection->dequeue(priv->injection, &data)) free(data);
+	clib_mpmc_queue_cleanup(priv->injection);
+	
+	free(priv->workers);
+	pthread_mutex_destroy(&priv->mutex);
+	pthread_cond_destroy(&priv->cond);
+	free(priv);
+	scheduler->priv = NULL;
+}
+
+
+/****************************************************
+ * TEST_MODULE::clib-scheduler
+ * build:
+ *   tests/make.sh scheduler
+ * run:
+ *   CLIB_NUM_THREADS=4 tests/scheduler
+****************************************************/
+#if defined(TEST_CLIB_SCHEDULER) && defined(ALGORITHMS_C_STAND_ALONE)
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// parallel_for: sum of sqrt
+#include <math.h>
+struct sum_context
+{
+	const double * values;
+	double * partial;	// one slot per chunk
+	size_t grain_size;
+};
+static void sum_body(size_t begin, size_t end, void * arg)
+{
+	struct sum_context * ctx = arg;
+	double sum = 0;
+	for(size_t i = begin; i < end; ++i) sum += sqrt(ctx->values[i]);
+	ctx->partial[begin / ctx->grain_size] = sum;
+}
+
+// spawn / sync: recursive fibonacci
+struct clib_scheduler * g_scheduler;
+struct fib_args { int n; long result; };
+static long fib_serial(int n) { return (n < 2)?n:(fib_serial(n - 1) + fib_serial(n - 2)); }
+static void fib_task(void * arg)
+{
+	struct fib_args * args = arg;
+	if(args->n < 20) {
+		args->result = fib_serial(args->n);
+		return;
+	}
+	struct fib_args a = { .n = args->n - 1 }, b = { .n = args->n - 2 };
+	struct clib_task_group group = { 0 };
+	g_scheduler->spawn(g_scheduler, &group, fib_task, &a);
+	fib_task(&b);
+	g_scheduler->sync(g_scheduler, &group);
+	args->result = a.result + b.result;
+}
+
+static void count_body(size_t begin, size_t end, void * arg)
+{
+	__atomic_add_fetch((long *)arg, (long)(end - begin), __ATOMIC_RELAXED);
+}
+
+int main(int argc, char **argv)
+{
+	struct clib_scheduler scheduler[1];
+	clib_scheduler_init(scheduler, 0, 0);
+	g_scheduler = scheduler;
+	printf("num_workers: %d\n", scheduler->num_workers);
+	assert(-1 == clib_scheduler_worker_id());
+	
+	// every index is visited exactly once, for any grain size
+	for(size_t grain_size = 0; grain_size <= 7; ++grain_size) {
+		long count = 0;
+		scheduler->parallel_for(scheduler, 3, 10003, grain_size, count_body, &count);
+		assert(count == 10000);
+	}
+	
+	// parallel_for
+	size_t num_values = 1 << 22;
+	double * values = malloc(num_values * sizeof(*values));
+	for(size_t i = 0; i < num_values; ++i) values[i] = (double)i;
+	
+	double t0 = now_seconds();
+	double serial = 0;
+	for(size_t i = 0; i < num_values; ++i) serial += sqrt(values[i]);
+	double t1 = now_seconds();
+	
+	struct sum_context ctx = { .values = values, .grain_size = 1 << 14 };
+	ctx.partial = calloc(num_values / ctx.grain_size, sizeof(*ctx.partial));
+	scheduler->parallel_for(scheduler, 0, num_values, ctx.grain_size, sum_body, &ctx);
+	double parallel = 0;
+	for(size_t i = 0; i < num_values / ctx.grain_size; ++i) parallel += ctx.partial[i];
+	double t2 = now_seconds();
+	assert(fabs(parallel - serial) < 1e-6 * serial);
+	printf("parallel_for(sum_sqrt): serial %.3f ms, parallel %.3f ms\n", (t1 - t0) * 1000, (t2 - t1) * 1000);
+	free(ctx.partial);
+	free(values);
+	
+	// spawn / sync
+	int n = (argc > 1)?atoi(argv[1]):30;
+	t0 = now_seconds();
+	long expected = fib_serial(n);
+	t1 = now_seconds();
+	struct fib_args args = { .n = n };
+	fib_task(&args);
+	t2 = now_seconds();
+	assert(args.result == expected);
+	printf("spawn/sync(fib(%d) = %ld): serial %.3f ms, parallel %.3f ms\n", n, expected, (t1 - t0) * 1000, (t2 - t1) * 1000);
+	
+	clib_scheduler_cleanup(scheduler);
+	return 0;
+}
+#endif
@@ -38,6 +38,22 @@
 /***************************************
  * clib_slist
 ***************************************/
+struct clib_slist_node * clib_slist_node_new(struct clib_slist * list, void * data)
+{
+	struct clib_slist_node * node = NULL;
+	if(list->node_pool) node = clib_mempool_alloc(list->node_pool);
+	else node = clib_alloc(list->allocator, sizeof(*node));
+	assert(node);
+	node->data = data;
+	return node;
+}
+
+void clib_slist_node_free(struct clib_slist * list, struct clib_slist_node * node)
+{
+	if(list->node_pool) clib_mempool_free(list->node_pool, node);
+	else clib_free(list->allocator, node);
+}
+
 void clib_slist_clear(struct clib_slist * list, void (*free_data)(void *))
 {
 	if(NULL == list) return;
@@ -68,7 +84,7 @@ void clib_slist_clear(struct clib_slist * list, void (*free_data)(void *))
 			node->data = NULL;
 		}
 		
-		free(node);
+		clib_slist_node_free(list, node);
 		node = next;
 	}
 	
@@ -80,10 +96,7 @@ void clib_slist_clear(struct clib_slist * list, void (*free_data)(void *))
 
 int clib_slist_push(struct clib_slist *list, void * data)
 {
-	struct clib_slist_node * node = calloc(1, sizeof(*node));
-	assert(node);
-	node->data = data;
-	node->next = NULL;
+	struct clib_slist_node * node = clib_slist_node_new(list, data);
 	
 	++list->length;
 	if(NULL == list->head) {
@@ -198,9 +211,7 @@ static int sorted_list_add(struct clib_sorted_list * list, void * data)
 {
 	assert(list && list->base->is_xor_list);
 	
-	struct clib_slist_node * new_node = calloc(1, sizeof(*new_node));
-	assert(new_node);
-	new_node->data = data;
+	struct clib_slist_node * new_node = clib_slist_node_new(list->base, data);
 	
 	clib_list_iterator_t iter;
 	memset(&iter, 0, sizeof(iter));
@@ -269,16 +280,15 @@ static void * sorted_list_remove(struct clib_sorted_list * list, clib_list_itera
 		}else {
 			base->tail = NULL;
 		}
-		free(current);
+		clib_slist_node_free(base, current);
 		return data;
 	}
 	if(NULL == iter.next) { // remove tail
-		struct clib_slist_node * prev_prev = xor_list_node_get_next(iter.current, iter.prev);
-		assert(prev_prev);
+		struct clib_slist_node * prev_prev = xor_list_node_get_next(iter.current, iter.prev); // NULL if prev is the head
 		iter.prev->next = prev_prev; // (prev ^ NULL)
 		base->tail = iter.prev;
 		
-		free(current);
+		clib_slist_node_free(base, current);
 		return data;
 	}
 	
@@ -290,7 +300,7 @@ static void * sorted_list_remove(struct clib_sorted_list * list, clib_list_itera
 	iter.prev->next = (struct clib_slist_node *)((uintptr_t)prev_prev ^ (uintptr_t)iter.next);
 	iter.next->next = (struct clib_slist_node *)((uintptr_t)iter.prev ^ (uintptr_t)next_next);
 	
-	free(current);
+	clib_slist_node_free(base, current);
 	return data;
 }
 
@@ -318,9 +328,16 @@ static int sorted_list_compare_default(const void * a, const void * b)
 }
 struct clib_sorted_list * clib_sorted_list_init(struct clib_sorted_list * list, int (*compare_fn)(const void*, const void *), void (*free_data)(void *))
 {
-	if(NULL == list) list = calloc(1, sizeof(*list));
+	return clib_sorted_list_init_ex(list, compare_fn, free_data, NULL);
+}
+
+struct clib_sorted_list * clib_sorted_list_init_ex(struct clib_sorted_list * list, int (*compare_fn)(const void*, const void *), void (*free_data)(void *), 
+	struct clib_allocator * allocator)
+{
+	if(NULL == list) list = clib_alloc(allocator, sizeof(*list));
 	else memset(list, 0, sizeof(*list));
 	assert(list);
+	list->base->allocator = allocator;
 	if(NULL == compare_fn) compare_fn = sorted_list_compare_default;
 	
 	list->compare = compare_fn;
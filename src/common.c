@@ -32,6 +32,7 @@
 #include <assert.h>
 
 #include <stdint.h>
+#include <time.h>
 #include "algorithms-c-common.h"
 
 /***************************************
@@ -108,6 +109,9 @@ static void test_pointer_array(void)
 		++array->length;
 	}
 	
+	// 16 slots at first, then x2
+	assert(array->max_size == 128);
+	
 	// dump data
 	printf("  array: length=%Zu, max_size=%Zu\n", array->length, array->max_size);
 	for(int i = 0; i < array->length; ++i) {
@@ -116,6 +120,15 @@ static void test_pointer_array(void)
 	}
 	
 	clib_pointer_array_cleanup(array, NULL);
+	
+	// the initial size is allocated exactly, eg. one slot per vertex
+	clib_pointer_array_init(array, 20000);
+	assert(array->max_size == 20000);
+	clib_pointer_array_set_length(array, 20000);
+	assert(array->max_size == 20000);
+	clib_pointer_array_set_length(array, 20001);
+	assert(array->max_size == 40000);
+	clib_pointer_array_cleanup(array, NULL);
 }
 
 static void test_stack(void)
@@ -219,6 +232,394 @@ static void test_sorted_list(void)
 	clib_sorted_list_clear(list);
 }
 
+static void test_mempool(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	struct clib_mempool pool[1];
+	clib_mempool_init(pool, sizeof(struct clib_slist_node), 64);
+	
+	// queue nodes are recycled through the free-list
+	struct clib_queue queue[1];
+	clib_queue_init(queue);
+	queue->base->node_pool = pool;
+	for(int round = 0; round < 10; ++round) {
+		for(int i = 0; i < 100; ++i) queue->enter(queue, (void *)(intptr_t)i);
+		for(int i = 0; i < 100; ++i) {
+			void * data = queue->leave(queue);
+			assert((intptr_t)data == i);
+		}
+	}
+	printf("  queue: num_slabs=%d, num_objects=%d\n", (int)pool->num_slabs, (int)pool->num_objects);
+	assert(pool->num_objects == 0 && pool->num_slabs == 2);
+	
+	// sorted list with pooled nodes
+	struct clib_sorted_list list[1];
+	clib_sorted_list_init(list, compare_data, NULL);
+	list->base->node_pool = pool;
+	for(int i = 0; i < 200; ++i) list->add(list, (void *)(intptr_t)((i * 37) % 200));
+	assert(pool->num_objects == 200);
+	
+	clib_list_iterator_t iter;
+	memset(&iter, 0, sizeof(iter));
+	int expected = 0;
+	if(clib_slist_iter_begin(list->base, &iter)) {
+		do {
+			assert((intptr_t)clib_list_iterator_get_data(iter) == expected);
+			++expected;
+		}while(clib_slist_iter_next(list->base, &iter));
+	}
+	assert(expected == 200);
+	clib_sorted_list_clear(list);
+	assert(pool->num_objects == 0);
+	
+	// bulk release
+	for(int i = 0; i < 1000; ++i) clib_mempool_alloc(pool);
+	clib_mempool_reset(pool);
+	assert(pool->num_objects == 0 && pool->num_slabs == 1);
+	clib_mempool_cleanup(pool);
+}
+
+static void test_allocator(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	struct clib_arena arena[1];
+	clib_arena_init(arena, 4096);
+	struct clib_allocator * allocator = arena->base;
+	
+	// realloc keeps the data, the last block grows in place
+	int * values = clib_alloc(allocator, 10 * sizeof(*values));
+	for(int i = 0; i < 10; ++i) values[i] = i;
+	int * grown = clib_realloc(allocator, values, 100 * sizeof(*values));
+	assert(grown == values);
+	void * other = clib_alloc(allocator, 16);
+	grown = clib_realloc(allocator, values, 200 * sizeof(*values));
+	assert(grown != values && other);
+	for(int i = 0; i < 10; ++i) assert(grown[i] == i);
+	
+	// containers on the arena
+	struct clib_pointer_array array[1];
+	clib_pointer_array_init_ex(array, 100, allocator);
+	struct clib_queue queue[1];
+	clib_queue_init_ex(queue, allocator);
+	struct clib_sorted_list * list = clib_sorted_list_init_ex(NULL, compare_data, NULL, allocator);
+	for(int i = 0; i < 1000; ++i) {
+		queue->enter(queue, (void *)(intptr_t)i);
+		list->add(list, (void *)(intptr_t)(1000 - i));
+	}
+	for(int i = 0; i < 1000; ++i) assert((intptr_t)queue->leave(queue) == i);
+	assert((intptr_t)list->base->head->data == 1);
+	printf("  arena: used_bytes=%zu, total_bytes=%zu\n", arena->used_bytes, arena->total_bytes);
+	
+	// O(1) release, the chunks are reused
+	size_t total_bytes = arena->total_bytes;
+	clib_arena_reset(arena);
+	assert(arena->used_bytes == 0);
+	for(int i = 0; i < 1000; ++i) clib_alloc(allocator, 16);
+	assert(arena->total_bytes == total_bytes);
+	clib_arena_cleanup(arena);
+	
+	// tracking allocator
+	struct clib_tracking_allocator tracker[1];
+	clib_tracking_allocator_init(tracker, NULL);
+	allocator = tracker->base;
+	values = clib_alloc(allocator, 10 * sizeof(*values));
+	assert(values && values[9] == 0 && ((uintptr_t)values & 15) == 0);
+	for(int i = 0; i < 10; ++i) values[i] = i;
+	values = clib_realloc(allocator, values, 100 * sizeof(*values));
+	assert(values[9] == 9);
+	clib_pointer_array_init_ex(array, 100, allocator);
+	assert(tracker->live_blocks == 2 && array->max_size == 100);
+	assert(tracker->live_bytes == 100 * sizeof(*values) + array->max_size * sizeof(void *));
+	clib_free(allocator, values);
+	clib_pointer_array_cleanup(array, NULL);
+	printf("  tracker: allocs=%lu, reallocs=%lu, frees=%lu, peak_bytes=%zu\n", 
+		(unsigned long)tracker->num_allocs, (unsigned long)tracker->num_reallocs, (unsigned long)tracker->num_frees,
+		tracker->peak_bytes);
+	assert(tracker->live_blocks == 0 && tracker->live_bytes == 0);
+	assert(tracker->num_allocs == tracker->num_frees && tracker->peak_bytes >= 100 * sizeof(*values));
+	
+	// the default allocator
+	values = clib_alloc(clib_allocator_default(), 10 * sizeof(*values));
+	assert(values && values[9] == 0);
+	clib_free(clib_allocator_default(), values);
+}
+
+static void test_deque(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	struct clib_deque deque[1];
+	clib_deque_init(deque, 0);
+	assert(deque->size == 16);
+	
+	// FIFO with wrap-around, then grow while wrapped
+	for(int i = 0; i < 10; ++i) deque->push_back(deque, (void *)(intptr_t)i);
+	for(int i = 0; i < 8; ++i) assert((intptr_t)deque->pop_front(deque) == i);
+	for(int i = 10; i < 100; ++i) deque->push_back(deque, (void *)(intptr_t)i);
+	printf("  size=%zu, length=%zu\n", deque->size, deque->length);
+	assert(deque->size == 128 && deque->length == 92);
+	for(int i = 0; i < 92; ++i) assert((intptr_t)deque->get(deque, i) == i + 8);
+	
+	// both ends, compared with a plain array
+	intptr_t model[4096];
+	size_t begin = 2048, end = 2048 + deque->length;
+	for(size_t i = begin; i < end; ++i) model[i] = i - begin + 8;
+	srand(1);
+	for(int i = 0; i < 1000; ++i) {
+		int op = rand() % 4;
+		if(op == 0) { model[end] = i; deque->push_back(deque, (void *)(intptr_t)model[end++]); }
+		else if(op == 1) { model[--begin] = i; deque->push_front(deque, (void *)(intptr_t)model[begin]); }
+		else if(op == 2 && begin < end) assert((intptr_t)deque->pop_front(deque) == model[begin++]);
+		else if(op == 3 && begin < end) assert((intptr_t)deque->pop_back(deque) == model[--end]);
+		assert(deque->length == end - begin);
+	}
+	for(size_t i = begin; i < end; ++i) assert((intptr_t)deque->pop_front(deque) == model[i]);
+	assert(deque->length == 0 && NULL == deque->pop_front(deque) && NULL == deque->pop_back(deque));
+	clib_deque_cleanup(deque, NULL);
+}
+
+struct point { int32_t x; int32_t y; int64_t weight; };
+CLIB_VECTOR_DEFINE(point_vec, struct point);
+static void test_vector(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	struct clib_u32_vec ids[1];
+	clib_u32_vec_init(ids, NULL);
+	assert(ids->capacity == 4);
+	
+	// inline storage
+	for(uint32_t i = 0; i < 4; ++i) clib_u32_vec_push(ids, i);
+	assert(clib_u32_vec_data(ids) == ids->u.inline_buf);
+	
+	// geometric growth on the heap
+	for(uint32_t i = 4; i < 1000; ++i) clib_u32_vec_push(ids, i);
+	printf("  length=%zu, capacity=%zu\n", ids->length, ids->capacity);
+	assert(ids->capacity == 1024);
+	for(uint32_t i = 0; i < 1000; ++i) assert(*clib_u32_vec_at(ids, i) == i);
+	
+	uint32_t value = 0;
+	for(uint32_t i = 999; i >= 2; --i) assert(0 == clib_u32_vec_pop(ids, &value) && value == i);
+	clib_u32_vec_shrink(ids);	// back to the inline buffer
+	assert(ids->capacity == 4 && ids->length == 2 && clib_u32_vec_data(ids)[1] == 1);
+	
+	clib_u32_vec_resize(ids, 10);
+	assert(ids->length == 10 && *clib_u32_vec_at(ids, 1) == 1 && *clib_u32_vec_at(ids, 9) == 0);
+	clib_u32_vec_shrink(ids);
+	assert(ids->capacity == 10);
+	clib_u32_vec_cleanup(ids);
+	assert(ids->length == 0 && 0 != clib_u32_vec_pop(ids, NULL));
+	
+	// structs by value, a zero-filled vector is valid
+	struct point_vec points[1];
+	memset(points, 0, sizeof(points));
+	for(int i = 0; i < 100; ++i) {
+		point_vec_reserve(points, i + 1);
+		point_vec_data(points)[points->length++] = (struct point){ .x = i, .y = -i, .weight = i * 10 };
+	}
+	assert(point_vec_at(points, 99)->weight == 990 && point_vec_at(points, 50)->y == -50);
+	point_vec_cleanup(points);
+}
+
+struct btree_item { int key; int seq; };
+static int compare_btree_item(const void * a, const void * b)
+{
+	return ((const struct btree_item *)a)->key - ((const struct btree_item *)b)->key;
+}
+static int compare_btree_model(const void * _a, const void * _b)
+{
+	const struct btree_item * a = *(const struct btree_item **)_a;
+	const struct btree_item * b = *(const struct btree_item **)_b;
+	if(a->key != b->key) return a->key - b->key;
+	return a->seq - b->seq;
+}
+static int count_range(void * data, void * user_data)
+{
+	++*(int *)user_data;
+	return 0;
+}
+static double elapsed_ms(const struct timespec * begin)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - begin->tv_sec) * 1000.0 + (end.tv_nsec - begin->tv_nsec) / 1000000.0;
+}
+
+static void test_btree(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	enum { NUM_ITEMS = 20000 };
+	static struct btree_item items[NUM_ITEMS];
+	static struct btree_item * model[NUM_ITEMS];
+	struct clib_btree tree[1];
+	clib_btree_init(tree, compare_btree_item, NULL);
+	
+	// random add / remove with duplicates, compared with a sorted array
+	// (equal keys must stay in insertion order)
+	srand(7);
+	size_t num_model = 0;
+	int seq = 0;
+	for(int round = 0; round < 4; ++round) {
+		for(int i = 0; i < NUM_ITEMS; ++i) {
+			struct btree_item * item = &items[i];
+			if(item->seq) continue;	// in the tree
+			item->key = rand() % 5000;
+			item->seq = ++seq;
+			tree->add(tree, item);
+			model[num_model++] = item;
+		}
+		for(int i = 0; i < NUM_ITEMS / 2; ++i) {
+			struct btree_item * item = &items[rand() % NUM_ITEMS];
+			if(0 == item->seq) continue;
+			assert(tree->remove(tree, item) == item);
+			item->seq = 0;
+		}
+		num_model = 0;
+		for(int i = 0; i < NUM_ITEMS; ++i) if(items[i].seq) model[num_model++] = &items[i];
+		qsort(model, num_model, sizeof(model[0]), compare_btree_model);
+		
+		assert(tree->count == num_model);
+		clib_btree_iterator_t iter;
+		size_t index = 0;
+		for(_Bool ok = clib_btree_iter_begin(tree, &iter); ok; ok = clib_btree_iter_next(&iter)) {
+			assert(clib_btree_iter_get(&iter) == model[index++]);
+		}
+		assert(index == num_model);
+		for(_Bool ok = clib_btree_iter_last(tree, &iter); ok; ok = clib_btree_iter_prev(&iter)) {
+			assert(clib_btree_iter_get(&iter) == model[--index]);
+		}
+		assert(index == 0);
+	}
+	printf("  count=%zu, height=%d\n", tree->count, tree->height);
+	
+	// find / range
+	struct btree_item key = { .key = model[100]->key };
+	struct btree_item * found = tree->find(tree, &key);
+	assert(found && found->key == key.key);
+	assert(found == model[100] || model[99]->key == key.key);
+	
+	struct btree_item lower = { .key = 1000 }, upper = { .key = 1999 };
+	int visited = 0, expected = 0;
+	size_t count = tree->range(tree, &lower, &upper, count_range, &visited);
+	for(size_t i = 0; i < num_model; ++i) expected += (model[i]->key >= 1000 && model[i]->key <= 1999);
+	assert((int)count == expected && visited == expected);
+	assert(tree->range(tree, NULL, NULL, NULL, NULL) == num_model);
+	
+	// remove everything, the tree shrinks back to a leaf
+	for(size_t i = 0; i < num_model; ++i) assert(tree->remove(tree, model[i]) == model[i]);
+	assert(tree->count == 0 && tree->height == 1 && NULL == tree->find(tree, &key));
+	clib_btree_cleanup(tree);
+	
+	// sorted insertion: clib_btree vs clib_sorted_list (O(n^2))
+	const int num_bench = 5000;
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	clib_btree_init(tree, compare_data, NULL);
+	for(int i = 0; i < num_bench; ++i) tree->add(tree, (void *)(intptr_t)(items[i].key + 1));
+	for(int i = 0; i < num_bench; ++i) assert(tree->find(tree, (void *)(intptr_t)(items[i].key + 1)));
+	double btree_ms = elapsed_ms(&begin);
+	clib_btree_cleanup(tree);
+	
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	struct clib_sorted_list list[1];
+	clib_sorted_list_init(list, compare_data, NULL);
+	for(int i = 0; i < num_bench; ++i) list->add(list, (void *)(intptr_t)items[i].key);
+	clib_list_iterator_t iter;
+	for(int i = 0; i < num_bench; ++i) {
+		memset(&iter, 0, sizeof(iter));
+		assert(list->find(list, (void *)(intptr_t)items[i].key, &iter, compare_data));
+	}
+	double list_ms = elapsed_ms(&begin);
+	clib_sorted_list_clear(list);
+	printf("  add + find %d items: btree %.2f ms, sorted_list %.2f ms\n", num_bench, btree_ms, list_ms);
+}
+
+#include <search.h>
+struct edge_key { uint32_t src_id; uint32_t dst_id; };
+static int compare_edge_key(const void * _a, const void * _b)
+{
+	const struct edge_key * a = _a, * b = _b;
+	if(a->src_id != b->src_id) return (a->src_id < b->src_id)?-1:1;
+	if(a->dst_id != b->dst_id) return (a->dst_id < b->dst_id)?-1:1;
+	return 0;
+}
+static void free_nothing(void * data) { }
+
+static void test_hashmap(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	enum { NUM_KEYS = 4096 };
+	static intptr_t model[NUM_KEYS];	// 0: not in the map
+	struct clib_hashmap map[1];
+	clib_hashmap_init(map, sizeof(uint32_t), 0, NULL);
+	
+	// random set / remove, compared with a plain array
+	srand(11);
+	size_t count = 0;
+	for(int i = 0; i < 200000; ++i) {
+		uint32_t key = rand() % NUM_KEYS;
+		if(rand() % 3) {
+			intptr_t value = i + 1;
+			int inserted = map->set(map, &key, (void *)value);
+			assert(inserted == (0 == model[key]));
+			count += inserted;
+			model[key] = value;
+		}else {
+			void * value = NULL;
+			int rc = map->remove(map, &key, &value);
+			assert((0 == rc) == (0 != model[key]));
+			if(0 == rc) {
+				assert((intptr_t)value == model[key]);
+				model[key] = 0;
+				--count;
+			}
+		}
+		assert(map->count == count);
+	}
+	for(uint32_t key = 0; key < NUM_KEYS; ++key) {
+		void ** p_value = map->find(map, &key);
+		assert((NULL != p_value) == (0 != model[key]));
+		if(p_value) assert((intptr_t)*p_value == model[key]);
+	}
+	// dense entries
+	for(size_t i = 0; i < map->count; ++i) {
+		uint32_t key = *(const uint32_t *)clib_hashmap_key_at(map, i);
+		assert(model[key] == (intptr_t)clib_hashmap_value_at(map, i));
+	}
+	printf("  count=%zu, capacity=%zu\n", map->count, map->capacity);
+	clib_hashmap_cleanup(map);
+	
+	// (src_id, dst_id) edge index: clib_hashmap vs tsearch
+	enum { NUM_EDGES = 200000 };
+	struct edge_key * edges = malloc(NUM_EDGES * sizeof(*edges));
+	for(int i = 0; i < NUM_EDGES; ++i) edges[i] = (struct edge_key){ .src_id = rand() % 50000, .dst_id = rand() % 50000 };
+	
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	void * root = NULL;
+	for(int i = 0; i < NUM_EDGES; ++i) tsearch(&edges[i], &root, compare_edge_key);
+	double tsearch_build_ms = elapsed_ms(&begin);
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	size_t found = 0;
+	for(int i = 0; i < NUM_EDGES; ++i) found += (NULL != tfind(&edges[(i * 7919) % NUM_EDGES], &root, compare_edge_key));
+	double tsearch_find_ms = elapsed_ms(&begin);
+	assert(found == NUM_EDGES);
+	tdestroy(root, free_nothing);
+	
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	clib_hashmap_init(map, sizeof(struct edge_key), 0, NULL);
+	for(int i = 0; i < NUM_EDGES; ++i) map->set(map, &edges[i], &edges[i]);
+	double hashmap_build_ms = elapsed_ms(&begin);
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	found = 0;
+	for(int i = 0; i < NUM_EDGES; ++i) found += (NULL != map->find(map, &edges[(i * 7919) % NUM_EDGES]));
+	double hashmap_find_ms = elapsed_ms(&begin);
+	assert(found == NUM_EDGES);
+	clib_hashmap_cleanup(map);
+	free(edges);
+	
+	printf("  %d edges, build / find: tsearch %.2f / %.2f ms, hashmap %.2f / %.2f ms\n", NUM_EDGES,
+		tsearch_build_ms, tsearch_find_ms, hashmap_build_ms, hashmap_find_ms);
+}
+
 int main(int argc, char ** argv)
 {
 	if(0) test_slist_reverse();
@@ -226,6 +627,12 @@ int main(int argc, char ** argv)
 	if(0) test_stack();
 	if(0) test_circular_array();
 	if(1) test_sorted_list();
+	if(1) test_mempool();
+	if(1) test_allocator();
+	if(1) test_deque();
+	if(1) test_vector();
+	if(1) test_btree();
+	if(1) test_hashmap();
 	return 0;
 }
 #endif
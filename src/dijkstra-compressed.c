@@ -0,0 +1,526 @@
+/*
+ * dijkstra-compressed.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <stdint.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "dijkstra-compressed.h"
+
+/************************************
+ * encoder
+************************************/
+struct byte_buffer
+{
+	size_t length;
+	size_t size;
+	uint8_t * data;
+};
+
+static void byte_buffer_write_varint(struct byte_buffer * buf, uint64_t value)
+{
+	if(buf->length + 10 > buf->size) {
+		size_t new_size = buf->size?(buf->size * 2):4096;
+		buf->data = realloc(buf->data, new_size);
+		assert(buf->data);
+		buf->size = new_size;
+	}
+	uint8_t * p = buf->data + buf->length;
+	while(value >= 0x80) {
+		*p++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (uint8_t)value;
+	buf->length = p - buf->data;
+}
+
+static inline uint64_t quantize_weight(int64_t weight, int weight_shift)
+{
+	assert(weight >= 0);
+	if(0 == weight_shift) return weight;
+	return ((uint64_t)weight + ((uint64_t)1 << (weight_shift - 1))) >> weight_shift;
+}
+
+static int compare_edges(const void * _a, const void * _b)
+{
+	const struct dijkstra_compressed_edge * a = _a;
+	const struct dijkstra_compressed_edge * b = _b;
+	if(a->src_id != b->src_id) return (a->src_id < b->src_id)?-1:1;
+	return (a->dst_id < b->dst_id)?-1:(a->dst_id > b->dst_id);
+}
+
+static void byte_buffer_append(struct byte_buffer * buf, const struct byte_buffer * src)
+{
+	if(buf->length + src->length > buf->size) {
+		size_t new_size = buf->size?buf->size:4096;
+		while(new_size < buf->length + src->length) new_size *= 2;
+		buf->data = realloc(buf->data, new_size);
+		assert(buf->data);
+		buf->size = new_size;
+	}
+	memcpy(buf->data + buf->length, src->data, src->length);
+	buf->length += src->length;
+}
+
+// edges[]: the edges of src_id, order by dst_id; scratch: holds the encoded edges until their length is known
+static void encode_vertex(struct dijkstra_compressed_graph * graph, struct byte_buffer * buf, struct byte_buffer * scratch,
+	uint32_t src_id, const struct dijkstra_compressed_edge * edges, size_t count)
+{
+	if(0 == src_id % DIJKSTRA_COMPRESSED_BLOCK_SIZE) graph->block_offsets[src_id / DIJKSTRA_COMPRESSED_BLOCK_SIZE] = buf->length;
+	
+	byte_buffer_write_varint(buf, count);
+	if(0 == count) return;
+	
+	scratch->length = 0;
+	uint32_t prev_id = src_id;
+	for(size_t i = 0; i < count; ++i) {
+		assert(edges[i].src_id == src_id);
+		assert(edges[i].dst_id < graph->num_vertices);
+		if(0 == i) {
+			int64_t delta = (int64_t)edges[i].dst_id - (int64_t)src_id;
+			byte_buffer_write_varint(scratch, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+		}else {
+			byte_buffer_write_varint(scratch, edges[i].dst_id - prev_id);
+		}
+		prev_id = edges[i].dst_id;
+		byte_buffer_write_varint(scratch, quantize_weight(edges[i].weight, graph->weight_shift));
+	}
+	byte_buffer_write_varint(buf, scratch->length);
+	byte_buffer_append(buf, scratch);
+	graph->num_edges += count;
+}
+
+static struct dijkstra_compressed_graph * compressed_graph_new(struct dijkstra_compressed_graph * graph, 
+	uint32_t num_vertices, int weight_shift)
+{
+	assert(num_vertices > 0);
+	assert(weight_shift >= 0 && weight_shift < 63);
+	if(NULL == graph) graph = calloc(1, sizeof(*graph));
+	else memset(graph, 0, sizeof(*graph));
+	assert(graph);
+	
+	graph->num_vertices = num_vertices;
+	graph->weight_shift = weight_shift;
+	graph->num_blocks = (num_vertices + DIJKSTRA_COMPRESSED_BLOCK_SIZE - 1) / DIJKSTRA_COMPRESSED_BLOCK_SIZE;
+	graph->block_offsets = calloc(graph->num_blocks, sizeof(*graph->block_offsets));
+	assert(graph->block_offsets);
+	return graph;
+}
+
+static void compressed_graph_finish(struct dijkstra_compressed_graph * graph, struct byte_buffer * buf)
+{
+	graph->num_bytes = buf->length;
+	graph->data = realloc(buf->data, buf->length?buf->length:1);	// shrink to fit
+	assert(graph->data);
+}
+
+struct dijkstra_compressed_graph * dijkstra_compressed_graph_init(struct dijkstra_compressed_graph * graph,
+	const struct dijkstra_edges * _edges, int weight_shift)
+{
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)_edges;
+	assert(edges && edges->is_sparse_matrix);
+	graph = compressed_graph_new(graph, edges->num_vertices, weight_shift);
+	
+	struct byte_buffer buf = { 0 };
+	struct byte_buffer scratch = { 0 };
+	size_t max_edges = 64;
+	struct dijkstra_compressed_edge * vertex_edges = malloc(max_edges * sizeof(*vertex_edges));
+	assert(vertex_edges);
+	for(uint32_t src_id = 0; src_id < graph->num_vertices; ++src_id) {
+		size_t count = 0;
+		const struct clib_slist * list = NULL;
+		if(edges->get_vertex_sparse_edges(edges, src_id, &list) > 0) {
+			clib_list_iterator_t iter;
+			memset(&iter, 0, sizeof(iter));
+			clib_slist_iter_clear((struct clib_slist *)list);
+			while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+				const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+				if(count >= max_edges) {
+					max_edges *= 2;
+					vertex_edges = realloc(vertex_edges, max_edges * sizeof(*vertex_edges));
+					assert(vertex_edges);
+				}
+				vertex_edges[count++] = (struct dijkstra_compressed_edge){ edge->src_id, edge->dst_id, edge->weight };
+			}
+			qsort(vertex_edges, count, sizeof(*vertex_edges), compare_edges);
+		}
+		encode_vertex(graph, &buf, &scratch, src_id, vertex_edges, count);
+	}
+	free(vertex_edges);
+	free(scratch.data);
+	compressed_graph_finish(graph, &buf);
+	return graph;
+}
+
+struct dijkstra_compressed_graph * dijkstra_compressed_graph_init_from_list(struct dijkstra_compressed_graph * graph,
+	uint32_t num_vertices, struct dijkstra_compressed_edge * edges, size_t num_edges, int weight_shift)
+{
+	assert(edges || 0 == num_edges);
+	graph = compressed_graph_new(graph, num_vertices, weight_shift);
+	if(num_edges > 0) qsort(edges, num_edges, sizeof(*edges), compare_edges);
+	
+	struct byte_buffer buf = { 0 };
+	struct byte_buffer scratch = { 0 };
+	size_t begin = 0;
+	for(uint32_t src_id = 0; src_id < num_vertices; ++src_id) {
+		size_t end = begin;
+		while(end < num_edges && edges[end].src_id == src_id) ++end;
+		encode_vertex(graph, &buf, &scratch, src_id, edges + begin, end - begin);
+		begin = end;
+	}
+	assert(begin == num_edges);	// src_id < num_vertices
+	free(scratch.data);
+	compressed_graph_finish(graph, &buf);
+	return graph;
+}
+
+void dijkstra_compressed_graph_cleanup(struct dijkstra_compressed_graph * graph)
+{
+	if(NULL == graph) return;
+	free(graph->data);
+	free(graph->block_offsets);
+	memset(graph, 0, sizeof(*graph));
+}
+
+size_t dijkstra_compressed_graph_memory_usage(const struct dijkstra_compressed_graph * graph)
+{
+	if(NULL == graph) return 0;
+	return graph->num_bytes + graph->num_blocks * sizeof(*graph->block_offsets);
+}
+
+/************************************
+ * dijkstra_compressed_context
+************************************/
+static int64_t compressed_shortest_path(struct dijkstra_compressed_context * dijkstra,
+	uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path)
+{
+	const struct dijkstra_compressed_graph * graph = dijkstra->graph;
+	assert(src_id < graph->num_vertices);
+	assert(dst_id < graph->num_vertices);
+	
+	// a new stamp invalidates the distances of the previous search
+	if(0 == ++dijkstra->stamp) {
+		memset(dijkstra->stamps, 0, graph->num_vertices * sizeof(*dijkstra->stamps));
+		dijkstra->stamp = 1;
+	}
+	const uint32_t stamp = dijkstra->stamp;
+	int64_t * distances = dijkstra->distances;
+	uint32_t * parents = dijkstra->parents;
+	uint32_t * stamps = dijkstra->stamps;
+	struct clib_dary_heap * heap = dijkstra->heap;
+	clib_dary_heap_clear(heap);
+	dijkstra->vertices_settled = 0;
+	dijkstra->edges_scanned = 0;
+	
+	stamps[src_id] = stamp;
+	distances[src_id] = 0;
+	parents[src_id] = src_id;
+	heap->push(heap, src_id, 0);
+	
+	int found = 0;
+	uint32_t current_id = 0;
+	int64_t weight = 0;
+	while(0 == heap->pop(heap, &current_id, &weight)) {
+		++dijkstra->vertices_settled;
+		if(current_id == dst_id) {
+			found = 1;
+			break;
+		}
+		
+		struct dijkstra_compressed_iterator iter;
+		dijkstra_compressed_iter_begin(graph, current_id, &iter);
+		while(dijkstra_compressed_iter_next(&iter)) {
+			++dijkstra->edges_scanned;
+			const uint32_t next_id = iter.dst_id;
+			const int64_t next_weight = weight + iter.weight;
+			if(stamps[next_id] != stamp) {
+				stamps[next_id] = stamp;
+				distances[next_id] = next_weight;
+				parents[next_id] = current_id;
+				heap->push(heap, next_id, next_weight);
+			}else if(next_weight < distances[next_id]) {	// a settled vertex can not be improved (non-negative weights)
+				distances[next_id] = next_weight;
+				parents[next_id] = current_id;
+				heap->decrease_key(heap, next_id, next_weight);
+			}
+		}
+	}
+	
+	if(path) {
+		clib_u32_vec_clear(path);
+		if(found) {
+			for(uint32_t id = dst_id; ; id = parents[id]) {
+				clib_u32_vec_push(path, id);
+				if(id == src_id) break;
+			}
+			uint32_t * ids = clib_u32_vec_data(path);
+			for(size_t i = 0, j = path->length - 1; i < j; ++i, --j) {
+				uint32_t id = ids[i];
+				ids[i] = ids[j];
+				ids[j] = id;
+			}
+		}
+	}
+	return found?distances[dst_id]:-1;
+}
+
+struct dijkstra_compressed_context * dijkstra_compressed_context_init(struct dijkstra_compressed_context * dijkstra,
+	const struct dijkstra_compressed_graph * graph)
+{
+	assert(graph && graph->num_vertices > 0);
+	if(NULL == dijkstra) dijkstra = calloc(1, sizeof(*dijkstra));
+	else memset(dijkstra, 0, sizeof(*dijkstra));
+	assert(dijkstra);
+	
+	dijkstra->graph = graph;
+	dijkstra->distances = malloc(graph->num_vertices * sizeof(*dijkstra->distances));
+	dijkstra->parents = malloc(graph->num_vertices * sizeof(*dijkstra->parents));
+	dijkstra->stamps = calloc(graph->num_vertices, sizeof(*dijkstra->stamps));
+	assert(dijkstra->distances && dijkstra->parents && dijkstra->stamps);
+	clib_dary_heap_init(dijkstra->heap, 4, graph->num_vertices, NULL);
+	
+	dijkstra->shortest_path = compressed_shortest_path;
+	return dijkstra;
+}
+
+void dijkstra_compressed_context_cleanup(struct dijkstra_compressed_context * dijkstra)
+{
+	if(NULL == dijkstra) return;
+	clib_dary_heap_cleanup(dijkstra->heap);
+	free(dijkstra->distances);
+	free(dijkstra->parents);
+	free(dijkstra->stamps);
+	dijkstra->distances = NULL;
+	dijkstra->parents = NULL;
+	dijkstra->stamps = NULL;
+}
+
+
+/****************************************************
+ * TEST_MODULE::dijkstra-compressed
+ * build: 
+ *   tests/make.sh dijkstra-compressed
+****************************************************/
+#if defined(TEST_DIJKSTRA_COMPRESSED) && defined(ALGORITHMS_C_STAND_ALONE)
+
+#define NUM_VERTICES (3000)
+#define DEGREE (6)
+#define NUM_QUERIES (300)
+
+static uint64_t s_seed = 20221001;
+static uint32_t rand_u32(uint32_t n)
+{
+	s_seed = s_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t)((s_seed >> 33) % n);
+}
+
+static int64_t path_weight(struct dijkstra_edges * edges, const struct clib_u32_vec * path)
+{
+	int64_t weight = 0;
+	for(size_t i = 0; i + 1 < path->length; ++i) {
+		const struct dijkstra_sparse_edge * edge = edges->find(edges, *clib_u32_vec_at(path, i), *clib_u32_vec_at(path, i + 1));
+		assert(edge);
+		weight += edge->weight;
+	}
+	return weight;
+}
+
+static void test_varint(void)
+{
+	// extreme deltas and weights
+	struct dijkstra_compressed_edge edges[] = {
+		{ 0, 4, 1LL << 40 }, { 0, 0, 0 }, { 0, 9, 127 },
+		{ 5, 0, 128 }, { 5, 9, INT64_MAX >> 1 },
+		{ 9, 0, 16383 }, { 9, 1, 16384 }, 
+	};
+	const size_t num_edges = sizeof(edges) / sizeof(edges[0]);
+	struct dijkstra_compressed_graph graph[1];
+	dijkstra_compressed_graph_init_from_list(graph, 10, edges, num_edges, 0);
+	assert(graph->num_edges == num_edges);
+	
+	size_t count = 0;
+	for(uint32_t v = 0; v < graph->num_vertices; ++v) {
+		struct dijkstra_compressed_iterator iter;
+		dijkstra_compressed_iter_begin(graph, v, &iter);
+		while(dijkstra_compressed_iter_next(&iter)) {
+			// edges[] has been sorted by (src_id, dst_id)
+			assert(edges[count].src_id == v && edges[count].dst_id == iter.dst_id && edges[count].weight == iter.weight);
+			++count;
+		}
+	}
+	assert(count == num_edges);
+	dijkstra_compressed_graph_cleanup(graph);
+}
+
+/*
+ * a hub shares its block with low-degree vertices:
+ * the lookups after the hub skip its edges by their byte length (not decoded), the lengths need 3-byte varints
+ */
+static void test_hub_block(void)
+{
+	const uint32_t num_vertices = 100000;
+	const uint32_t hub_id = 1;	// block 0: [0, DIJKSTRA_COMPRESSED_BLOCK_SIZE)
+	const size_t hub_degree = num_vertices - 1;
+	size_t max_edges = hub_degree + 2 * num_vertices;
+	struct dijkstra_compressed_edge * edges = malloc(max_edges * sizeof(*edges));
+	assert(edges);
+	size_t num_edges = 0;
+	for(uint32_t v = 0; v < num_vertices; ++v) {
+		if(v != hub_id) edges[num_edges++] = (struct dijkstra_compressed_edge){ hub_id, v, 1 + v % 1000 };
+	}
+	for(uint32_t v = 0; v < num_vertices; ++v) {	// each vertex <-> hub, and v -> v + 1
+		if(v != hub_id) edges[num_edges++] = (struct dijkstra_compressed_edge){ v, hub_id, 7 };
+		if(v + 1 < num_vertices && v != hub_id) edges[num_edges++] = (struct dijkstra_compressed_edge){ v, v + 1, 3 };
+	}
+	struct dijkstra_compressed_graph graph[1];
+	dijkstra_compressed_graph_init_from_list(graph, num_vertices, edges, num_edges, 0);
+	assert(graph->num_edges == num_edges);
+	
+	// every vertex of block 0 is found two varints per earlier vertex from the block offset
+	for(uint32_t v = 0; v < DIJKSTRA_COMPRESSED_BLOCK_SIZE; ++v) {
+		struct dijkstra_compressed_iterator iter;
+		dijkstra_compressed_iter_begin(graph, v, &iter);
+		assert(iter.degree == ((v == hub_id)?hub_degree:2));
+		uint32_t first_id = (v == hub_id)?0:hub_id;
+		assert(dijkstra_compressed_iter_next(&iter) && iter.dst_id == first_id);
+		if(v != hub_id) {
+			assert(iter.weight == 7);
+			assert(dijkstra_compressed_iter_next(&iter) && iter.dst_id == v + 1 && iter.weight == 3);
+		}
+	}
+	struct dijkstra_compressed_context dijkstra[1];
+	dijkstra_compressed_context_init(dijkstra, graph);
+	assert(dijkstra->shortest_path(dijkstra, 2, 4, NULL) == 2 * 3);	// not [2 -> 1 -> 4] = 7 + 5
+	assert(dijkstra->shortest_path(dijkstra, 0, num_vertices - 1, NULL) == 3 + 1 + (num_vertices - 1) % 1000);	// [0 -> 1 -> n - 1]
+	dijkstra_compressed_context_cleanup(dijkstra);
+	dijkstra_compressed_graph_cleanup(graph);
+	free(edges);
+}
+
+int main(int argc, char **argv)
+{
+	test_varint();
+	test_hub_block();
+	
+	// random graph, the neighbours are mostly close by ids (small deltas), some are not
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, NUM_VERTICES);
+	struct dijkstra_compressed_edge * edge_list = malloc(NUM_VERTICES * DEGREE * sizeof(*edge_list));
+	size_t num_edges = 0;
+	for(uint32_t v = 0; v < NUM_VERTICES; ++v) {
+		for(int k = 0; k < DEGREE; ++k) {
+			uint32_t u = (k == 0)?rand_u32(NUM_VERTICES):((v + NUM_VERTICES - 50 + rand_u32(100)) % NUM_VERTICES);
+			if(u == v || edges->find(edges, v, u)) continue;
+			int64_t weight = 1 + rand_u32(1000);
+			edges->update(edges, v, u, weight);
+			edge_list[num_edges++] = (struct dijkstra_compressed_edge){ v, u, weight };
+		}
+	}
+	
+	struct dijkstra_compressed_graph graph[1], list_graph[1], quantized[1];
+	dijkstra_compressed_graph_init(graph, edges, 0);
+	dijkstra_compressed_graph_init_from_list(list_graph, NUM_VERTICES, edge_list, num_edges, 0);
+	dijkstra_compressed_graph_init(quantized, edges, 4);
+	assert(graph->num_edges == num_edges);
+	assert(graph->num_bytes == list_graph->num_bytes && 0 == memcmp(graph->data, list_graph->data, graph->num_bytes));
+	printf("edges=%zu, compressed: %zu bytes (%.2f bytes/edge), quantized(shift=4): %.2f bytes/edge, dijkstra_edges: %.2f bytes/edge\n",
+		num_edges, dijkstra_compressed_graph_memory_usage(graph), 
+		(double)dijkstra_compressed_graph_memory_usage(graph) / num_edges,
+		(double)dijkstra_compressed_graph_memory_usage(quantized) / num_edges,
+		(double)dijkstra_edges_memory_usage(edges, NULL) / num_edges);
+	assert(dijkstra_compressed_graph_memory_usage(graph) < 4 * num_edges);
+	
+	// the iterator returns every edge
+	size_t count = 0;
+	for(uint32_t v = 0; v < NUM_VERTICES; ++v) {
+		struct dijkstra_compressed_iterator iter;
+		dijkstra_compressed_iter_begin(graph, v, &iter);
+		uint32_t prev_id = 0;
+		while(dijkstra_compressed_iter_next(&iter)) {
+			const struct dijkstra_sparse_edge * edge = edges->find(edges, v, iter.dst_id);
+			assert(edge && edge->weight == iter.weight);
+			assert(iter.remaining + 1 == iter.degree || iter.dst_id > prev_id);
+			prev_id = iter.dst_id;
+			++count;
+		}
+	}
+	assert(count == num_edges);
+	
+	// the same weights as dijkstra_context
+	struct dijkstra_graph dgraph[1] = {{ .num_vertices = NUM_VERTICES, .edges = edges }};
+	struct dijkstra_context dijkstra[1];
+	dijkstra_context_init(dijkstra, dgraph, NULL);
+	struct dijkstra_compressed_context compressed[1], compressed_q[1];
+	dijkstra_compressed_context_init(compressed, graph);
+	dijkstra_compressed_context_init(compressed_q, quantized);
+	
+	struct clib_u32_vec path[1];
+	clib_u32_vec_init(path, NULL);
+	uint64_t settled = 0;
+	for(int q = 0; q < NUM_QUERIES; ++q) {
+		uint32_t src_id = rand_u32(NUM_VERTICES), dst_id = rand_u32(NUM_VERTICES);
+		int64_t weight = dijkstra->shortest_path(dijkstra, src_id, dst_id, NULL);
+		int64_t compressed_weight = compressed->shortest_path(compressed, src_id, dst_id, path);
+		settled += compressed->vertices_settled;
+		assert(weight == compressed_weight);
+		if(weight < 0) {
+			assert(path->length == 0);
+			continue;
+		}
+		assert(*clib_u32_vec_at(path, 0) == src_id && *clib_u32_vec_at(path, path->length - 1) == dst_id);
+		assert(path_weight(edges, path) == weight);
+		
+		// quantized: the path found is valid, its true weight is close to the optimum
+		// (each edge weight is off by at most 2^(4 - 1) = 8)
+		int64_t hops = path->length - 1;
+		int64_t quantized_weight = compressed_q->shortest_path(compressed_q, src_id, dst_id, path);
+		assert(quantized_weight >= 0);
+		int64_t quantized_hops = path->length - 1;
+		int64_t true_weight = path_weight(edges, path);
+		assert(quantized_weight >= true_weight - quantized_hops * 8 && quantized_weight <= true_weight + quantized_hops * 8);
+		assert(true_weight <= weight + (hops + quantized_hops) * 8);
+	}
+	printf("queries=%d, settled=%.1f per query\n", NUM_QUERIES, (double)settled / NUM_QUERIES);
+	
+	clib_u32_vec_cleanup(path);
+	dijkstra_compressed_context_cleanup(compressed_q);
+	dijkstra_compressed_context_cleanup(compressed);
+	dijkstra_context_cleanup(dijkstra);
+	dijkstra_compressed_graph_cleanup(quantized);
+	dijkstra_compressed_graph_cleanup(list_graph);
+	dijkstra_compressed_graph_cleanup(graph);
+	dijkstra_edges_cleanup(edges);
+	free(edge_list);
+	return 0;
+}
+#endif
@@ -0,0 +1,677 @@
+/*
+ * dijkstra-pareto.c
+ *
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <stdint.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "dijkstra-pareto.h"
+
+/************************************
+ * pareto labels
+************************************/
+struct pareto_label
+{
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA];
+	int64_t amount;	// the amount to be forwarded by this vertex
+	uint32_t vertex_id;
+	uint32_t parent;	// index of the parent label, UINT32_MAX for src
+	int hops;
+	int deleted;	// dominated by a newer label before being settled
+};
+
+// the non-dominated labels of a vertex
+struct pareto_label_set
+{
+	int count;
+	int max_size;
+	uint32_t * ids;
+};
+
+struct pareto_search
+{
+	int num_criteria;
+	int check_hops;	// max_hops > 0: the hop count is one more dominance dimension
+	size_t num_labels;
+	size_t max_labels;
+	struct pareto_label * labels;
+	struct pareto_label_set * label_sets;
+	size_t num_dropped_labels;	// non-dominated, but their vertex was full
+
+	// binary heap of label indexes, order by costs (lexicographic)
+	size_t heap_length;
+	size_t heap_size;
+	uint32_t * heap;
+};
+
+/*
+ * returns 1 if every cost of a is less than or equal to the cost of b.
+ * equal labels count as dominated, so a zero-cost cycle can not create a new label.
+ */
+static inline int costs_dominate(const int64_t * a, const int64_t * b, int num_criteria)
+{
+	for(int i = 0; i < num_criteria; ++i) if(a[i] > b[i]) return 0;
+	return 1;
+}
+
+static inline int costs_compare(const int64_t * a, const int64_t * b, int num_criteria)
+{
+	for(int i = 0; i < num_criteria; ++i) {
+		if(a[i] != b[i]) return (a[i] < b[i])?-1:1;
+	}
+	return 0;
+}
+
+/*
+ * label a dominates (costs, hops) if its costs dominate and, with a hop limit, it has no more hops:
+ * a cheaper label with more hops can not replace a label which may still reach dst within max_hops.
+ */
+static inline int label_dominates(const struct pareto_search * search, const struct pareto_label * a, 
+	const int64_t * costs, int hops)
+{
+	if(search->check_hops && a->hops > hops) return 0;
+	return costs_dominate(a->costs, costs, search->num_criteria);
+}
+
+static inline int label_less(const struct pareto_search * search, uint32_t a, uint32_t b)
+{
+	return costs_compare(search->labels[a].costs, search->labels[b].costs, search->num_criteria) < 0;
+}
+
+static void heap_push(struct pareto_search * search, uint32_t id)
+{
+	if(search->heap_length >= search->heap_size) {
+		search->heap_size = search->heap_size?(search->heap_size * 2):64;
+		search->heap = realloc(search->heap, search->heap_size * sizeof(*search->heap));
+		assert(search->heap);
+	}
+	size_t pos = search->heap_length++;
+	while(pos > 0) {
+		size_t parent = (pos - 1) / 2;
+		if(!label_less(search, id, search->heap[parent])) break;
+		search->heap[pos] = search->heap[parent];
+		pos = parent;
+	}
+	search->heap[pos] = id;
+}
+
+static int heap_pop(struct pareto_search * search, uint32_t * p_id)
+{
+	if(search->heap_length == 0) return -1;
+	*p_id = search->heap[0];
+
+	uint32_t last = search->heap[--search->heap_length];
+	size_t pos = 0;
+	while(1) {
+		size_t child = pos * 2 + 1;
+		if(child >= search->heap_length) break;
+		if(child + 1 < search->heap_length && label_less(search, search->heap[child + 1], search->heap[child])) ++child;
+		if(!label_less(search, search->heap[child], last)) break;
+		search->heap[pos] = search->heap[child];
+		pos = child;
+	}
+	if(search->heap_length > 0) search->heap[pos] = last;
+	return 0;
+}
+
+static uint32_t pareto_search_new_label(struct pareto_search * search)
+{
+	if(search->num_labels >= search->max_labels) {
+		search->max_labels = search->max_labels?(search->max_labels * 2):1024;
+		search->labels = realloc(search->labels, search->max_labels * sizeof(*search->labels));
+		assert(search->labels);
+	}
+	uint32_t id = search->num_labels++;
+	memset(&search->labels[id], 0, sizeof(search->labels[id]));
+	return id;
+}
+
+static int label_set_is_dominated(const struct pareto_search * search, const struct pareto_label_set * set, 
+	const int64_t * costs, int hops)
+{
+	for(int i = 0; i < set->count; ++i) {
+		if(label_dominates(search, &search->labels[set->ids[i]], costs, hops)) return 1;
+	}
+	return 0;
+}
+
+// remove (and mark as deleted) the labels dominated by (costs, hops)
+static void label_set_remove_dominated(struct pareto_search * search, struct pareto_label_set * set, 
+	const int64_t * costs, int hops)
+{
+	for(int i = 0; i < set->count; ) {
+		struct pareto_label * label = &search->labels[set->ids[i]];
+		if(costs_dominate(costs, label->costs, search->num_criteria) && (!search->check_hops || hops <= label->hops)) {
+			label->deleted = 1;
+			set->ids[i] = set->ids[--set->count];
+			continue;
+		}
+		++i;
+	}
+}
+
+static void label_set_add(struct pareto_label_set * set, uint32_t id)
+{
+	if(set->count >= set->max_size) {
+		set->max_size = set->max_size?(set->max_size * 2):4;
+		set->ids = realloc(set->ids, set->max_size * sizeof(*set->ids));
+		assert(set->ids);
+	}
+	set->ids[set->count++] = id;
+}
+
+static void pareto_search_cleanup(struct pareto_search * search, size_t num_vertices)
+{
+	if(search->label_sets) {
+		for(size_t i = 0; i < num_vertices; ++i) free(search->label_sets[i].ids);
+		free(search->label_sets);
+	}
+	free(search->labels);
+	free(search->heap);
+	memset(search, 0, sizeof(*search));
+}
+
+static int label_id_compare(const void * _a, const void * _b, void * _search)
+{
+	const struct pareto_search * search = _search;
+	uint32_t a = *(const uint32_t *)_a;
+	uint32_t b = *(const uint32_t *)_b;
+	return costs_compare(search->labels[a].costs, search->labels[b].costs, search->num_criteria);
+}
+
+/************************************
+ * dijkstra_pareto_context
+************************************/
+static int default_get_costs(const struct dijkstra_sparse_edge * edge, int64_t amount,
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA], void * user_data)
+{
+	costs[0] = edge->weight;
+	return 0;
+}
+
+static ssize_t dijkstra_pareto_search(struct dijkstra_pareto_context * pareto,
+	uint32_t src_id, uint32_t dst_id,
+	struct dijkstra_pareto_result * result)
+{
+	assert(pareto && pareto->graph);
+	const struct dijkstra_graph * graph = pareto->graph;
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
+	assert(edges->is_sparse_matrix);
+	assert(src_id < graph->num_vertices && dst_id < graph->num_vertices);
+
+	const int num_criteria = pareto->num_criteria;
+	assert(num_criteria > 0 && num_criteria <= DIJKSTRA_PARETO_MAX_CRITERIA);
+	const int max_labels = (pareto->max_labels > 0)?pareto->max_labels:DIJKSTRA_PARETO_DEFAULT_MAX_LABELS;
+	const int check_capacity = (pareto->amount > 0);
+
+	struct pareto_search search[1];
+	memset(search, 0, sizeof(search));
+	search->num_criteria = num_criteria;
+	search->check_hops = (pareto->max_hops > 0);
+	search->label_sets = calloc(graph->num_vertices, sizeof(*search->label_sets));
+	assert(search->label_sets);
+	struct pareto_label_set * dst_set = &search->label_sets[dst_id];
+
+	// step 1. push the label of src_id
+	uint32_t id = pareto_search_new_label(search);
+	struct pareto_label * label = &search->labels[id];
+	label->vertex_id = src_id;
+	label->parent = UINT32_MAX;
+	label->amount = pareto->amount;
+	label_set_add(&search->label_sets[src_id], id);
+	heap_push(search, id);
+
+	// step 2. settle the labels in lexicographic order
+	while(0 == heap_pop(search, &id)) {
+		struct pareto_label current = search->labels[id]; // copy: labels[] may be relocated
+		if(current.deleted) continue;
+		if(current.vertex_id == dst_id) continue;
+
+		// pruned by a (better) label of dst_id, the paths through current have at least current.hops + 1 hops
+		if(label_set_is_dominated(search, dst_set, current.costs, current.hops + 1)) continue;
+		if(pareto->max_hops > 0 && current.hops >= pareto->max_hops) continue;
+
+		struct clib_slist * vertex_edges = NULL;
+		ssize_t count = 0;
+		if(check_capacity) count = edges->get_vertex_capacity_edges(edges, current.vertex_id, (const struct clib_slist **)&vertex_edges);
+		else count = edges->get_vertex_sparse_edges(edges, current.vertex_id, (const struct clib_slist **)&vertex_edges);
+		if(count <= 0) continue;
+
+		clib_list_iterator_t iter;
+		memset(&iter, 0, sizeof(iter));
+		clib_slist_iter_clear(vertex_edges);
+		while(clib_slist_iter_next(vertex_edges, &iter)) {
+			struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			assert(edge);
+			assert(edge->dst_id < graph->num_vertices);
+			if(check_capacity) {
+				if(edge->capacity < current.amount) break; // all the remaining edges have less capacity
+				if(!dijkstra_sparse_edge_can_forward(edge, current.amount)) continue;
+			}
+
+			int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA] = { 0 };
+			if(pareto->get_costs(edge, current.amount, costs, pareto->user_data)) continue;
+			for(int i = 0; i < num_criteria; ++i) {
+				assert(costs[i] >= 0);
+				costs[i] += current.costs[i];
+			}
+
+			// step 3. dominance checks
+			const int hops = current.hops + 1;
+			if(label_set_is_dominated(search, dst_set, costs, hops)) continue;
+			struct pareto_label_set * set = &search->label_sets[edge->dst_id];
+			if(label_set_is_dominated(search, set, costs, hops)) continue;
+			label_set_remove_dominated(search, set, costs, hops);
+			if(set->count >= max_labels) {
+				++search->num_dropped_labels;
+				continue;
+			}
+
+			// step 4. add a new label
+			uint32_t new_id = pareto_search_new_label(search);
+			label = &search->labels[new_id];
+			memcpy(label->costs, costs, sizeof(label->costs));
+			label->vertex_id = edge->dst_id;
+			label->parent = id;
+			label->hops = hops;
+			label->amount = pareto->calc_amount?pareto->calc_amount(current.amount, edge->user_data):current.amount;
+			label_set_add(set, new_id);
+			heap_push(search, new_id);
+		}
+	}
+
+	// step 5. with a hop limit, dst_id may keep a costlier label with fewer hops, only return the pareto-optimal costs
+	if(search->check_hops) {
+		for(int i = 0; i < dst_set->count; ) {
+			const struct pareto_label * label = &search->labels[dst_set->ids[i]];
+			int dominated = 0;
+			for(int k = 0; k < dst_set->count && !dominated; ++k) {
+				const struct pareto_label * other = &search->labels[dst_set->ids[k]];
+				if(k != i && costs_dominate(other->costs, label->costs, num_criteria)) {
+					// equal costs: keep the label with fewer hops
+					dominated = costs_compare(other->costs, label->costs, num_criteria) || other->hops <= label->hops;
+				}
+			}
+			if(dominated) {
+				dst_set->ids[i] = dst_set->ids[--dst_set->count];
+				continue;
+			}
+			++i;
+		}
+	}
+	
+	// step 6. get paths
+	ssize_t num_paths = dst_set->count;
+	if(result) {
+		dijkstra_pareto_result_cleanup(result);
+		result->num_dropped_labels = search->num_dropped_labels;
+	}
+	if(result && num_paths > 0) {
+		qsort_r(dst_set->ids, num_paths, sizeof(*dst_set->ids), label_id_compare, search);
+
+		result->paths = calloc(num_paths, sizeof(*result->paths));
+		assert(result->paths);
+		result->num_paths = num_paths;
+		for(ssize_t i = 0; i < num_paths; ++i) {
+			struct dijkstra_pareto_path * path = &result->paths[i];
+			const struct pareto_label * dst_label = &search->labels[dst_set->ids[i]];
+			memcpy(path->costs, dst_label->costs, sizeof(path->costs));
+			path->amount = pareto->amount;
+			path->length = dst_label->hops + 1;
+			path->vertices = calloc(path->length, sizeof(*path->vertices));
+			assert(path->vertices);
+
+			size_t pos = path->length;
+			for(uint32_t index = dst_set->ids[i]; index != UINT32_MAX; index = search->labels[index].parent) {
+				assert(pos > 0);
+				path->vertices[--pos] = search->labels[index].vertex_id;
+			}
+			assert(pos == 0);
+		}
+	}
+	pareto_search_cleanup(search, graph->num_vertices);
+	return num_paths;
+}
+
+void dijkstra_pareto_result_cleanup(struct dijkstra_pareto_result * result)
+{
+	if(NULL == result) return;
+	for(size_t i = 0; i < result->num_paths; ++i) free(result->paths[i].vertices);
+	free(result->paths);
+	memset(result, 0, sizeof(*result));
+}
+
+struct dijkstra_pareto_context * dijkstra_pareto_context_init(struct dijkstra_pareto_context * pareto,
+	const struct dijkstra_graph * graph, int num_criteria,
+	void * user_data)
+{
+	assert(graph && graph->edges);
+	assert(num_criteria > 0 && num_criteria <= DIJKSTRA_PARETO_MAX_CRITERIA);
+
+	if(NULL == pareto) pareto = calloc(1, sizeof(*pareto));
+	else memset(pareto, 0, sizeof(*pareto));
+	assert(pareto);
+
+	pareto->user_data = user_data;
+	pareto->graph = graph;
+	pareto->num_criteria = num_criteria;
+	pareto->max_labels = DIJKSTRA_PARETO_DEFAULT_MAX_LABELS;
+
+	pareto->search = dijkstra_pareto_search;
+	pareto->get_costs = default_get_costs;
+	return pareto;
+}
+
+/* nothing to release: the labels are allocated and freed by each search() */
+void dijkstra_pareto_context_cleanup(struct dijkstra_pareto_context * pareto)
+{
+	(void)pareto;
+	return;
+}
+
+
+/****************************************************
+ * TEST_MODULE::dijkstra-pareto
+ * build:
+ *   tests/make.sh dijkstra-pareto
+****************************************************/
+#if defined(TEST_DIJKSTRA_PARETO) && defined(ALGORITHMS_C_STAND_ALONE)
+#include <math.h>
+
+struct channel_policy
+{
+	int64_t fee;
+	int64_t cltv_delta;
+	double success_probability;
+};
+
+static int channel_get_costs(const struct dijkstra_sparse_edge * edge, int64_t amount,
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA], void * user_data)
+{
+	const struct channel_policy * policy = edge->user_data;
+	assert(policy);
+	costs[0] = policy->fee;
+	costs[1] = policy->cltv_delta;
+	costs[2] = (int64_t)(-log(policy->success_probability) * 1000000.0 + 0.5);
+	return 0;
+}
+
+static void result_dump(const struct dijkstra_pareto_result * result, int num_criteria)
+{
+	for(size_t i = 0; i < result->num_paths; ++i) {
+		const struct dijkstra_pareto_path * path = &result->paths[i];
+		printf("  path[%d]: costs={", (int)i);
+		for(int k = 0; k < num_criteria; ++k) printf("%s%ld", k?", ":"", (long)path->costs[k]);
+		printf("}, vertices: ");
+		for(size_t j = 0; j < path->length; ++j) printf("%s%u", j?" ==> ":"", path->vertices[j]);
+		printf("\n");
+	}
+}
+
+/*
+ * brute force: enumerate all simple paths and keep the non-dominated costs
+ */
+#define RANDOM_VERTICES (9)
+static int64_t s_costs[RANDOM_VERTICES][RANDOM_VERTICES][2];
+static int64_t s_front[1024][2];
+static int s_front_count;
+static void enumerate_paths(uint32_t vertex, uint32_t dst_id, int64_t c0, int64_t c1, int visited)
+{
+	if(vertex == dst_id) {
+		int64_t costs[2] = { c0, c1 };
+		for(int i = 0; i < s_front_count; ++i) if(costs_dominate(s_front[i], costs, 2)) return;
+		for(int i = 0; i < s_front_count; ) {
+			if(costs_dominate(costs, s_front[i], 2)) {
+				s_front[i][0] = s_front[s_front_count - 1][0];
+				s_front[i][1] = s_front[--s_front_count][1];
+				continue;
+			}
+			++i;
+		}
+		assert(s_front_count < 1024);
+		s_front[s_front_count][0] = c0;
+		s_front[s_front_count++][1] = c1;
+		return;
+	}
+	for(uint32_t next = 0; next < RANDOM_VERTICES; ++next) {
+		if((visited & (1 << next)) || s_costs[vertex][next][0] < 0) continue;
+		enumerate_paths(next, dst_id, c0 + s_costs[vertex][next][0], c1 + s_costs[vertex][next][1], visited | (1 << next));
+	}
+}
+
+static int random_get_costs(const struct dijkstra_sparse_edge * edge, int64_t amount,
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA], void * user_data)
+{
+	costs[0] = s_costs[edge->src_id][edge->dst_id][0];
+	costs[1] = s_costs[edge->src_id][edge->dst_id][1];
+	return 0;
+}
+
+/*
+ * costs[0] = weight, costs[1] = 1: the pareto front holds the min weight for each number of hops
+ */
+static int hops_get_costs(const struct dijkstra_sparse_edge * edge, int64_t amount,
+	int64_t costs[DIJKSTRA_PARETO_MAX_CRITERIA], void * user_data)
+{
+	costs[0] = edge->weight;
+	costs[1] = 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	/// 1. fee / cltv / reliability trade-offs
+	// [0 -> 1 -> 5]: cheap, medium delay, medium reliability
+	// [0 -> 2 -> 5]: expensive, short delay, reliable
+	// [0 -> 3 -> 5]: cheapest, long delay, unreliable
+	// [0 -> 4 -> 5]: dominated by [0 -> 1 -> 5]
+	static const struct channel_policy policies[] = {
+		{ 2, 40, 0.90 }, { 5, 10, 0.99 }, { 1, 100, 0.50 }, { 6, 50, 0.80 },
+	};
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, 6);
+	for(uint32_t i = 1; i <= 4; ++i) {
+		edges->update(edges, 0, i, 1)->user_data = (void *)&policies[i - 1];
+		edges->update(edges, i, 5, 1)->user_data = (void *)&policies[i - 1];
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = 6, .edges = edges }};
+
+	struct dijkstra_pareto_context pareto[1];
+	dijkstra_pareto_context_init(pareto, graph, 3, NULL);
+	pareto->get_costs = channel_get_costs;
+
+	struct dijkstra_pareto_result result[1];
+	memset(result, 0, sizeof(result));
+	ssize_t num_paths = pareto->search(pareto, 0, 5, result);
+	printf("==== pareto paths: %d\n", (int)num_paths);
+	result_dump(result, 3);
+	assert(num_paths == 3);
+	assert(result->paths[0].vertices[1] == 3 && result->paths[0].costs[0] == 2);
+	assert(result->paths[1].vertices[1] == 1 && result->paths[1].costs[0] == 4);
+	assert(result->paths[2].vertices[1] == 2 && result->paths[2].costs[0] == 10);
+	assert(0 == result->num_dropped_labels);
+	
+	// a vertex holds at most max_labels labels: a truncated front is reported
+	pareto->max_labels = 2;
+	num_paths = pareto->search(pareto, 0, 5, result);
+	printf("==== max_labels=2: pareto paths: %d, dropped labels: %zu\n", (int)num_paths, result->num_dropped_labels);
+	assert(num_paths == 2 && result->num_dropped_labels > 0);
+	pareto->max_labels = DIJKSTRA_PARETO_DEFAULT_MAX_LABELS;
+	num_paths = pareto->search(pareto, 0, 5, result);
+	assert(num_paths == 3 && 0 == result->num_dropped_labels);
+	dijkstra_pareto_result_cleanup(result);
+	dijkstra_pareto_context_cleanup(pareto);
+	dijkstra_edges_cleanup(edges);
+
+	/// 2. random graphs, compare with brute force
+	for(unsigned int seed = 1; seed <= 50; ++seed) {
+		srand(seed);
+		dijkstra_edges_init(edges, 1, RANDOM_VERTICES);
+		for(uint32_t i = 0; i < RANDOM_VERTICES; ++i) {
+			for(uint32_t j = 0; j < RANDOM_VERTICES; ++j) {
+				s_costs[i][j][0] = s_costs[i][j][1] = -1;
+				if(i == j || (rand() % 3)) continue;
+				s_costs[i][j][0] = rand() % 20;
+				s_costs[i][j][1] = rand() % 20;
+				edges->update(edges, i, j, s_costs[i][j][0]);
+			}
+		}
+		graph->num_vertices = RANDOM_VERTICES;
+		dijkstra_pareto_context_init(pareto, graph, 2, NULL);
+		pareto->get_costs = random_get_costs;
+		pareto->max_labels = 1024;
+
+		uint32_t dst_id = RANDOM_VERTICES - 1;
+		s_front_count = 0;
+		enumerate_paths(0, dst_id, 0, 0, 1);
+		num_paths = pareto->search(pareto, 0, dst_id, result);
+		assert(num_paths == s_front_count);
+		for(ssize_t i = 0; i < num_paths; ++i) {
+			int matched = 0;
+			for(int k = 0; k < s_front_count; ++k) {
+				if(s_front[k][0] == result->paths[i].costs[0] && s_front[k][1] == result->paths[i].costs[1]) matched = 1;
+			}
+			assert(matched);
+		}
+
+		// single criterion: the same min_weight as the dijkstra search
+		struct dijkstra_context dijkstra[1];
+		dijkstra_context_init(dijkstra, graph, NULL);
+		int64_t min_weight = dijkstra->shortest_path(dijkstra, 0, dst_id, NULL);
+		dijkstra_pareto_context_init(pareto, graph, 1, NULL);
+		num_paths = pareto->search(pareto, 0, dst_id, result);
+		assert((min_weight < 0 && num_paths == 0) || (num_paths == 1 && result->paths[0].costs[0] == min_weight));
+
+		dijkstra_context_cleanup(dijkstra);
+		dijkstra_pareto_result_cleanup(result);
+		dijkstra_edges_cleanup(edges);
+	}
+	printf("==== random graphs: OK\n");
+
+	/// 3. hop limit: the cheapest path to 3 uses 3 hops, it must not evict [0 -> 3] (1 hop)
+	// [0 -> 1 -> 2 -> 3 -> 4] = 4 (4 hops), [0 -> 3 -> 4] = 11 (2 hops)
+	dijkstra_edges_init(edges, 1, 5);
+	edges->update(edges, 0, 1, 1);
+	edges->update(edges, 1, 2, 1);
+	edges->update(edges, 2, 3, 1);
+	edges->update(edges, 3, 4, 1);
+	edges->update(edges, 0, 3, 10);
+	graph->num_vertices = 5;
+	dijkstra_pareto_context_init(pareto, graph, 1, NULL);
+	num_paths = pareto->search(pareto, 0, 4, result);
+	assert(num_paths == 1 && result->paths[0].costs[0] == 4 && result->paths[0].length == 5);
+	pareto->max_hops = 3;
+	num_paths = pareto->search(pareto, 0, 4, result);
+	printf("==== max_hops=3: %d path(s)\n", (int)num_paths);
+	result_dump(result, 1);
+	assert(num_paths == 1 && result->paths[0].costs[0] == 11 && result->paths[0].length == 3);
+	
+	// no path: the paths of the previous search are not returned again
+	pareto->max_hops = 1;
+	num_paths = pareto->search(pareto, 0, 4, result);
+	assert(num_paths == 0 && result->num_paths == 0 && result->paths == NULL);
+	dijkstra_pareto_result_cleanup(result);
+	dijkstra_edges_cleanup(edges);
+
+	/// 4. large random graph: (weight, hops) fronts against the single-criterion searches
+	{
+		const uint32_t num_vertices = 20000;
+		srand(12345);
+		dijkstra_edges_init(edges, 1, num_vertices);
+		for(uint32_t i = 0; i < num_vertices * 4; ++i) {
+			uint32_t src_id = rand() % num_vertices;
+			uint32_t dst_id = rand() % num_vertices;
+			if(src_id != dst_id) edges->update(edges, src_id, dst_id, 1 + rand() % 100);
+		}
+		graph->num_vertices = num_vertices;
+		struct dijkstra_context dijkstra[1];
+		dijkstra_context_init(dijkstra, graph, NULL);
+		
+		struct dijkstra_pareto_context hops_pareto[1];
+		dijkstra_pareto_context_init(hops_pareto, graph, 2, NULL);
+		hops_pareto->get_costs = hops_get_costs;
+		hops_pareto->max_labels = 1024;
+		dijkstra_pareto_context_init(pareto, graph, 1, NULL);
+		pareto->max_labels = 1024;
+		
+		for(int query = 0; query < 5; ++query) {
+			uint32_t src_id = rand() % num_vertices;
+			uint32_t dst_id = rand() % num_vertices;
+			if(src_id == dst_id) continue;
+			int64_t min_weight = dijkstra->shortest_path(dijkstra, src_id, dst_id, NULL);
+			num_paths = hops_pareto->search(hops_pareto, src_id, dst_id, result);
+			printf("==== [%u -> %u]: min_weight=%ld, %d (weight, hops) path(s)\n", 
+				src_id, dst_id, (long)min_weight, (int)num_paths);
+			assert((min_weight < 0) == (num_paths == 0));
+			if(num_paths == 0) continue;
+			assert(result->paths[0].costs[0] == min_weight);
+			
+			// each path is valid and the cheapest one within its hop count
+			for(ssize_t i = 0; i < num_paths; ++i) {
+				const struct dijkstra_pareto_path * path = &result->paths[i];
+				assert(path->vertices[0] == src_id && path->vertices[path->length - 1] == dst_id);
+				assert(path->costs[1] == (int64_t)path->length - 1);
+				int64_t weight = 0;
+				for(size_t k = 1; k < path->length; ++k) {
+					const struct dijkstra_sparse_edge * edge = edges->find(edges, path->vertices[k - 1], path->vertices[k]);
+					assert(edge);
+					weight += edge->weight;
+				}
+				assert(weight == path->costs[0]);
+				assert(dijkstra->shortest_path_hop_limited(dijkstra, src_id, dst_id, (int)path->costs[1], NULL) == weight);
+			}
+			
+			// every hop limit: the front and the single-criterion searches agree
+			struct dijkstra_pareto_result limited[1];
+			memset(limited, 0, sizeof(limited));
+			for(int max_hops = 1; max_hops <= result->paths[0].costs[1]; ++max_hops) {
+				int64_t expected = -1;
+				for(ssize_t i = 0; i < num_paths; ++i) {
+					if(result->paths[i].costs[1] <= max_hops) { expected = result->paths[i].costs[0]; break; }
+				}
+				assert(dijkstra->shortest_path_hop_limited(dijkstra, src_id, dst_id, max_hops, NULL) == expected);
+				pareto->max_hops = max_hops;
+				ssize_t count = pareto->search(pareto, src_id, dst_id, limited);
+				assert((expected < 0 && count == 0) || (count == 1 && limited->paths[0].costs[0] == expected));
+			}
+			dijkstra_pareto_result_cleanup(limited);
+		}
+		dijkstra_context_cleanup(dijkstra);
+		dijkstra_pareto_result_cleanup(result);
+		dijkstra_edges_cleanup(edges);
+		printf("==== large random graph: OK\n");
+	}
+	dijkstra_pareto_context_cleanup(pareto);
+	return 0;
+}
+#endif
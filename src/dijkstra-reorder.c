@@ -0,0 +1,499 @@
+/*
+ * dijkstra-reorder.c
+ * 
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ * 
+ * The MIT License (MIT)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal 
+ * in the Software without restriction, including without limitation the rights 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+ * IN THE SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <stdint.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "dijkstra-reorder.h"
+
+/************************************
+ * undirected adjacency (CSR): neighbors[offsets[v] .. offsets[v + 1])
+************************************/
+struct reorder_adjacency
+{
+	uint32_t num_vertices;
+	uint32_t * offsets;
+	uint32_t * neighbors;
+};
+
+static void reorder_adjacency_add_list(struct reorder_adjacency * adj, const struct clib_slist * list, int use_dst, uint32_t * p_count)
+{
+	clib_list_iterator_t iter;
+	memset(&iter, 0, sizeof(iter));
+	clib_slist_iter_clear((struct clib_slist *)list);
+	while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+		const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+		if(adj->neighbors) adj->neighbors[*p_count] = use_dst?edge->dst_id:edge->src_id;
+		++*p_count;
+	}
+}
+
+static int reorder_adjacency_init(struct reorder_adjacency * adj, const struct dijkstra_edges * _edges)
+{
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)_edges;
+	const uint32_t num_vertices = edges->num_vertices;
+	memset(adj, 0, sizeof(*adj));
+	adj->num_vertices = num_vertices;
+	adj->offsets = calloc(num_vertices + 1, sizeof(*adj->offsets));
+	if(NULL == adj->offsets) return -1;
+	
+	// pass 1: count, pass 2: fill
+	for(int pass = 0; pass < 2; ++pass) {
+		uint32_t count = 0;
+		for(uint32_t v = 0; v < num_vertices; ++v) {
+			adj->offsets[v] = count;
+			const struct clib_slist * list = NULL;
+			if(edges->get_vertex_sparse_edges(edges, v, &list) > 0) reorder_adjacency_add_list(adj, list, 1, &count);
+			if(edges->get_vertex_incoming_edges(edges, v, &list) > 0) reorder_adjacency_add_list(adj, list, 0, &count);
+		}
+		adj->offsets[num_vertices] = count;
+		if(pass == 0) {
+			adj->neighbors = malloc((count?count:1) * sizeof(*adj->neighbors));
+			if(NULL == adj->neighbors) return -1;
+		}
+	}
+	return 0;
+}
+
+static void reorder_adjacency_cleanup(struct reorder_adjacency * adj)
+{
+	free(adj->offsets);
+	free(adj->neighbors);
+	memset(adj, 0, sizeof(*adj));
+}
+
+static inline uint32_t reorder_adjacency_degree(const struct reorder_adjacency * adj, uint32_t v)
+{
+	return adj->offsets[v + 1] - adj->offsets[v];
+}
+
+// by degree, then by id
+struct degree_compare_context
+{
+	const struct reorder_adjacency * adj;
+	int descending;
+};
+static int degree_compare(const void * _a, const void * _b, void * user_data)
+{
+	const struct degree_compare_context * ctx = user_data;
+	uint32_t a = *(const uint32_t *)_a;
+	uint32_t b = *(const uint32_t *)_b;
+	uint32_t degree_a = reorder_adjacency_degree(ctx->adj, a);
+	uint32_t degree_b = reorder_adjacency_degree(ctx->adj, b);
+	if(degree_a != degree_b) {
+		int rc = (degree_a < degree_b)?-1:1;
+		return ctx->descending?-rc:rc;
+	}
+	return (a < b)?-1:(a > b);
+}
+
+/*
+ * breadth-first numbering, each unvisited vertex of seeds[] starts a new component.
+ * sort_by_degree: the neighbours of a vertex are numbered by degree (ascending), Cuthill-McKee
+ */
+static void reorder_bfs(const struct reorder_adjacency * adj, const uint32_t * seeds, int sort_by_degree, uint32_t * order)
+{
+	const uint32_t num_vertices = adj->num_vertices;
+	unsigned char * visited = calloc(num_vertices, 1);
+	assert(visited);
+	struct degree_compare_context ctx = { .adj = adj, .descending = 0 };
+	
+	uint32_t head = 0, tail = 0;
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		uint32_t seed = seeds?seeds[i]:i;
+		if(visited[seed]) continue;
+		visited[seed] = 1;
+		order[tail++] = seed;
+		
+		while(head < tail) {
+			uint32_t v = order[head++];
+			uint32_t begin = tail;
+			for(uint32_t k = adj->offsets[v]; k < adj->offsets[v + 1]; ++k) {
+				uint32_t u = adj->neighbors[k];
+				if(visited[u]) continue;
+				visited[u] = 1;
+				order[tail++] = u;
+			}
+			if(sort_by_degree && tail - begin > 1) qsort_r(order + begin, tail - begin, sizeof(*order), degree_compare, &ctx);
+		}
+	}
+	assert(tail == num_vertices);
+	free(visited);
+}
+
+int dijkstra_reorder_permutation(const struct dijkstra_edges * edges, enum dijkstra_reorder_method method, uint32_t * new_ids)
+{
+	assert(edges && edges->is_sparse_matrix);
+	assert(new_ids);
+	const uint32_t num_vertices = edges->num_vertices;
+	
+	struct reorder_adjacency adj[1];
+	if(reorder_adjacency_init(adj, edges)) {
+		reorder_adjacency_cleanup(adj);
+		return -1;
+	}
+	
+	uint32_t * order = malloc(num_vertices * sizeof(*order));	// new id ==> original id
+	uint32_t * seeds = NULL;
+	assert(order);
+	
+	int rc = 0;
+	switch(method) {
+	case DIJKSTRA_REORDER_BFS:
+		reorder_bfs(adj, NULL, 0, order);
+		break;
+	case DIJKSTRA_REORDER_RCM:
+		// start each component from a vertex with the min degree (an approximation of a peripheral vertex)
+		seeds = malloc(num_vertices * sizeof(*seeds));
+		assert(seeds);
+		for(uint32_t i = 0; i < num_vertices; ++i) seeds[i] = i;
+		qsort_r(seeds, num_vertices, sizeof(*seeds), degree_compare, &(struct degree_compare_context){ .adj = adj, .descending = 0 });
+		reorder_bfs(adj, seeds, 1, order);
+		for(uint32_t i = 0, j = num_vertices - 1; i < j; ++i, --j) {
+			uint32_t id = order[i];
+			order[i] = order[j];
+			order[j] = id;
+		}
+		break;
+	case DIJKSTRA_REORDER_DEGREE:
+		for(uint32_t i = 0; i < num_vertices; ++i) order[i] = i;
+		qsort_r(order, num_vertices, sizeof(*order), degree_compare, &(struct degree_compare_context){ .adj = adj, .descending = 1 });
+		break;
+	default:
+		rc = -1;
+		break;
+	}
+	
+	if(0 == rc) {
+		for(uint32_t i = 0; i < num_vertices; ++i) new_ids[order[i]] = i;
+	}
+	free(seeds);
+	free(order);
+	reorder_adjacency_cleanup(adj);
+	return rc;
+}
+
+/************************************
+ * dijkstra_reordered_graph
+************************************/
+static int64_t reordered_search(struct dijkstra_reordered_graph * reordered, struct dijkstra_context * dijkstra,
+	uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path, int reverse)
+{
+	assert(reordered && dijkstra);
+	assert(dijkstra->graph == reordered->graph);
+	
+	struct clib_pointer_array candidates[1];
+	memset(candidates, 0, sizeof(candidates));
+	uint32_t new_src_id = dijkstra_reordered_new_id(reordered, src_id);
+	uint32_t new_dst_id = dijkstra_reordered_new_id(reordered, dst_id);
+	
+	int64_t weight = reverse?
+		dijkstra->shortest_path_reverse(dijkstra, new_src_id, new_dst_id, path?candidates:NULL):
+		dijkstra->shortest_path(dijkstra, new_src_id, new_dst_id, path?candidates:NULL);
+	if(path) {
+		clib_u32_vec_clear(path);
+		if(weight >= 0) {
+			for(size_t i = 0; i < candidates->length; ++i) {
+				const struct dijkstra_vertex_status * status = candidates->data_ptrs[i];
+				clib_u32_vec_push(path, reordered->old_ids[status->id]);
+			}
+		}
+	}
+	clib_pointer_array_cleanup(candidates, NULL);
+	return weight;
+}
+
+static int64_t reordered_shortest_path(struct dijkstra_reordered_graph * reordered, struct dijkstra_context * dijkstra,
+	uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path)
+{
+	return reordered_search(reordered, dijkstra, src_id, dst_id, path, 0);
+}
+
+static int64_t reordered_shortest_path_reverse(struct dijkstra_reordered_graph * reordered, struct dijkstra_context * dijkstra,
+	uint32_t src_id, uint32_t dst_id, struct clib_u32_vec * path)
+{
+	return reordered_search(reordered, dijkstra, src_id, dst_id, path, 1);
+}
+
+struct dijkstra_reordered_graph * dijkstra_reordered_graph_init(struct dijkstra_reordered_graph * reordered,
+	const struct dijkstra_graph * graph, enum dijkstra_reorder_method method)
+{
+	assert(graph && graph->edges);
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
+	assert(edges->is_sparse_matrix);
+	assert(graph->num_vertices == edges->num_vertices);
+	
+	if(NULL == reordered) reordered = calloc(1, sizeof(*reordered));
+	else memset(reordered, 0, sizeof(*reordered));
+	assert(reordered);
+	
+	const uint32_t num_vertices = edges->num_vertices;
+	reordered->method = method;
+	reordered->num_vertices = num_vertices;
+	reordered->new_ids = malloc(num_vertices * sizeof(*reordered->new_ids));
+	reordered->old_ids = malloc(num_vertices * sizeof(*reordered->old_ids));
+	assert(reordered->new_ids && reordered->old_ids);
+	
+	int rc = dijkstra_reorder_permutation(edges, method, reordered->new_ids);
+	assert(0 == rc);
+	for(uint32_t i = 0; i < num_vertices; ++i) reordered->old_ids[reordered->new_ids[i]] = i;
+	
+	if(graph->vertices) {
+		reordered->vertices = calloc(num_vertices, sizeof(*reordered->vertices));
+		assert(reordered->vertices);
+		for(uint32_t i = 0; i < num_vertices; ++i) {
+			reordered->vertices[i].id = i;
+			reordered->vertices[i].data = graph->vertices[reordered->old_ids[i]].data;
+		}
+	}
+	
+	// insert the edges by the new src_id, so that the edges and list nodes of a vertex and its neighbours share slabs
+	struct dijkstra_edges * new_edges = dijkstra_edges_init_ex(reordered->edges, 1, num_vertices, edges->allocator);
+	for(uint32_t new_src_id = 0; new_src_id < num_vertices; ++new_src_id) {
+		const struct clib_slist * list = NULL;
+		if(edges->get_vertex_sparse_edges(edges, reordered->old_ids[new_src_id], &list) <= 0) continue;
+		
+		clib_list_iterator_t iter;
+		memset(&iter, 0, sizeof(iter));
+		clib_slist_iter_clear((struct clib_slist *)list);
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			uint32_t new_dst_id = reordered->new_ids[edge->dst_id];
+			struct dijkstra_sparse_edge * new_edge = new_edges->update(new_edges, new_src_id, new_dst_id, edge->weight);
+			assert(new_edge);
+			new_edge->user_data = edge->user_data;
+			if(edge->capacity != DIJKSTRA_CAPACITY_UNLIMITED || edge->htlc_min != 0 || edge->htlc_max != DIJKSTRA_CAPACITY_UNLIMITED) {
+				new_edges->set_capacity(new_edges, new_src_id, new_dst_id, edge->capacity, edge->htlc_min, edge->htlc_max);
+			}
+		}
+	}
+	
+	reordered->graph->num_vertices = num_vertices;
+	reordered->graph->vertices = reordered->vertices;
+	reordered->graph->edges = new_edges;
+	
+	reordered->shortest_path = reordered_shortest_path;
+	reordered->shortest_path_reverse = reordered_shortest_path_reverse;
+	return reordered;
+}
+
+void dijkstra_reordered_graph_cleanup(struct dijkstra_reordered_graph * reordered)
+{
+	if(NULL == reordered) return;
+	dijkstra_edges_cleanup(reordered->edges);
+	free(reordered->vertices);
+	free(reordered->new_ids);
+	free(reordered->old_ids);
+	reordered->vertices = NULL;
+	reordered->new_ids = NULL;
+	reordered->old_ids = NULL;
+	reordered->num_vertices = 0;
+}
+
+
+/****************************************************
+ * TEST_MODULE::dijkstra-reorder
+ * build: 
+ *   tests/make.sh dijkstra-reorder
+****************************************************/
+#if defined(TEST_DIJKSTRA_REORDER) && defined(ALGORITHMS_C_STAND_ALONE)
+#include <time.h>
+
+#define GRID_SIZE (40)
+#define NUM_VERTICES (GRID_SIZE * GRID_SIZE)
+#define NUM_QUERIES (300)
+
+static uint64_t s_seed = 20221001;
+static uint32_t rand_u32(uint32_t n)
+{
+	s_seed = s_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t)((s_seed >> 33) % n);
+}
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// max |id(src) - id(dst)| over all edges
+static uint32_t graph_bandwidth(struct dijkstra_edges * edges, const uint32_t * new_ids)
+{
+	uint32_t bandwidth = 0;
+	for(uint32_t v = 0; v < edges->num_vertices; ++v) {
+		const struct clib_slist * list = NULL;
+		if(edges->get_vertex_sparse_edges(edges, v, &list) <= 0) continue;
+		clib_list_iterator_t iter;
+		memset(&iter, 0, sizeof(iter));
+		clib_slist_iter_clear((struct clib_slist *)list);
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			uint32_t a = new_ids?new_ids[edge->src_id]:edge->src_id;
+			uint32_t b = new_ids?new_ids[edge->dst_id]:edge->dst_id;
+			uint32_t distance = (a > b)?(a - b):(b - a);
+			if(distance > bandwidth) bandwidth = distance;
+		}
+	}
+	return bandwidth;
+}
+
+static int64_t path_weight(struct dijkstra_edges * edges, const struct clib_u32_vec * path)
+{
+	int64_t weight = 0;
+	for(size_t i = 0; i + 1 < path->length; ++i) {
+		const struct dijkstra_sparse_edge * edge = edges->find(edges, *clib_u32_vec_at(path, i), *clib_u32_vec_at(path, i + 1));
+		assert(edge);
+		weight += edge->weight;
+	}
+	return weight;
+}
+
+int main(int argc, char **argv)
+{
+	// a grid with random ids
+	uint32_t * shuffled = malloc(NUM_VERTICES * sizeof(*shuffled));
+	for(uint32_t i = 0; i < NUM_VERTICES; ++i) shuffled[i] = i;
+	for(uint32_t i = NUM_VERTICES - 1; i > 0; --i) {
+		uint32_t j = rand_u32(i + 1);
+		uint32_t id = shuffled[i];
+		shuffled[i] = shuffled[j];
+		shuffled[j] = id;
+	}
+	
+	static int s_user_data[NUM_VERTICES];
+	struct dijkstra_vertex vertices[NUM_VERTICES];
+	for(uint32_t i = 0; i < NUM_VERTICES; ++i) vertices[i] = (struct dijkstra_vertex){ .id = i, .data = &s_user_data[i] };
+	
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, NUM_VERTICES);
+	for(uint32_t row = 0; row < GRID_SIZE; ++row) {
+		for(uint32_t col = 0; col < GRID_SIZE; ++col) {
+			uint32_t v = shuffled[row * GRID_SIZE + col];
+			if(col + 1 < GRID_SIZE) {
+				uint32_t u = shuffled[row * GRID_SIZE + col + 1];
+				edges->update(edges, v, u, 1 + rand_u32(100))->user_data = &s_user_data[v];
+				edges->update(edges, u, v, 1 + rand_u32(100));
+			}
+			if(row + 1 < GRID_SIZE) {
+				uint32_t u = shuffled[(row + 1) * GRID_SIZE + col];
+				edges->update(edges, v, u, 1 + rand_u32(100));
+				edges->update(edges, u, v, 1 + rand_u32(100));
+				edges->set_capacity(edges, u, v, 1000 + rand_u32(1000), 0, DIJKSTRA_CAPACITY_UNLIMITED);
+			}
+		}
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = NUM_VERTICES, .vertices = vertices, .edges = edges }};
+	struct dijkstra_context dijkstra[1];
+	dijkstra_context_init(dijkstra, graph, NULL);
+	
+	uint32_t queries[NUM_QUERIES][2];
+	for(int q = 0; q < NUM_QUERIES; ++q) {
+		queries[q][0] = rand_u32(NUM_VERTICES);
+		queries[q][1] = rand_u32(NUM_VERTICES);
+	}
+	
+	uint32_t bandwidth = graph_bandwidth(edges, NULL);
+	printf("original: bandwidth=%u\n", bandwidth);
+	
+	static const char * method_names[] = { "bfs", "rcm", "degree" };
+	struct clib_pointer_array candidates[1];
+	memset(candidates, 0, sizeof(candidates));
+	struct clib_u32_vec path[1];
+	clib_u32_vec_init(path, NULL);
+	for(int method = DIJKSTRA_REORDER_BFS; method <= DIJKSTRA_REORDER_DEGREE; ++method) {
+		struct dijkstra_reordered_graph reordered[1];
+		dijkstra_reordered_graph_init(reordered, graph, method);
+		
+		// a bijection
+		for(uint32_t i = 0; i < NUM_VERTICES; ++i) {
+			assert(reordered->new_ids[i] < NUM_VERTICES);
+			assert(reordered->old_ids[reordered->new_ids[i]] == i);
+			assert(reordered->vertices[reordered->new_ids[i]].data == vertices[i].data);
+		}
+		assert(reordered->edges->edge_pool->num_objects == edges->edge_pool->num_objects);
+		uint32_t new_bandwidth = graph_bandwidth(edges, reordered->new_ids);
+		
+		// the edge attributes are copied
+		uint32_t v = shuffled[0], u = shuffled[1], w = shuffled[GRID_SIZE];
+		const struct dijkstra_sparse_edge * edge = reordered->edges->find(reordered->edges, 
+			dijkstra_reordered_new_id(reordered, v), dijkstra_reordered_new_id(reordered, u));
+		assert(edge && edge->user_data == &s_user_data[v] && edge->weight == edges->find(edges, v, u)->weight);
+		edge = reordered->edges->find(reordered->edges, dijkstra_reordered_new_id(reordered, w), dijkstra_reordered_new_id(reordered, v));
+		assert(edge && edge->capacity == edges->find(edges, w, v)->capacity);
+		
+		// the same weights with the original ids
+		struct dijkstra_context reordered_dijkstra[1];
+		dijkstra_context_init(reordered_dijkstra, reordered->graph, NULL);
+		int64_t original_ns = 0, reordered_ns = 0;
+		for(int q = 0; q < NUM_QUERIES; ++q) {
+			uint32_t src_id = queries[q][0], dst_id = queries[q][1];
+			dijkstra->amount = reordered_dijkstra->amount = (q & 1)?1500:0;
+			int reverse = (q % 4 == 3);
+			
+			int64_t begin = now_ns();
+			int64_t weight = reverse?dijkstra->shortest_path_reverse(dijkstra, src_id, dst_id, candidates)
+				:dijkstra->shortest_path(dijkstra, src_id, dst_id, candidates);
+			original_ns += now_ns() - begin;
+			
+			begin = now_ns();
+			int64_t new_weight = reverse?reordered->shortest_path_reverse(reordered, reordered_dijkstra, src_id, dst_id, path)
+				:reordered->shortest_path(reordered, reordered_dijkstra, src_id, dst_id, path);
+			reordered_ns += now_ns() - begin;
+			
+			assert(weight == new_weight);
+			if(weight < 0) {
+				assert(path->length == 0);
+				continue;
+			}
+			assert(path->length > 0);
+			assert(*clib_u32_vec_at(path, 0) == src_id && *clib_u32_vec_at(path, path->length - 1) == dst_id);
+			assert(path_weight(edges, path) == weight);
+		}
+		printf("%-6s: bandwidth=%u, queries: original=%.3fms, reordered=%.3fms\n", method_names[method], new_bandwidth,
+			original_ns / 1000000.0, reordered_ns / 1000000.0);
+		if(method == DIJKSTRA_REORDER_RCM) assert(new_bandwidth <= 2 * GRID_SIZE);
+		
+		dijkstra_context_cleanup(reordered_dijkstra);
+		dijkstra_reordered_graph_cleanup(reordered);
+	}
+	
+	clib_u32_vec_cleanup(path);
+	clib_pointer_array_cleanup(candidates, NULL);
+	dijkstra_context_cleanup(dijkstra);
+	dijkstra_edges_cleanup(edges);
+	free(shuffled);
+	return 0;
+}
+#endif
@@ -31,29 +31,124 @@
 #include <string.h>
 #include <assert.h>
 
-#include <search.h>
 
 #include <stdint.h>
+#include <pthread.h>
 #include "algorithms-c-common.h"
 
 #include "dijkstra.h"
 
+/*
+ * per-query counters (dijkstra->stats), compiled out unless DIJKSTRA_ENABLE_STATS is defined
+ *   STATS_BEGIN() resets the counters and starts the init phase,
+ *   STATS_PHASE_END() adds the time since the previous phase boundary to a phase field.
+ */
+#ifdef DIJKSTRA_ENABLE_STATS
+#include <time.h>
+static inline int64_t stats_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#define STATS_BEGIN(dijkstra) \
+	memset(&(dijkstra)->stats, 0, sizeof((dijkstra)->stats)); \
+	int64_t stats_phase_ns = stats_now_ns()
+#define STATS_ADD(dijkstra, field, n) do { (dijkstra)->stats.field += (n); } while(0)
+#define STATS_MAX(dijkstra, field, value) do { \
+		if((uint64_t)(value) > (dijkstra)->stats.field) (dijkstra)->stats.field = (value); \
+	} while(0)
+#define STATS_PHASE_END(dijkstra, field) do { \
+		int64_t now = stats_now_ns(); \
+		(dijkstra)->stats.field += now - stats_phase_ns; \
+		stats_phase_ns = now; \
+	} while(0)
+#else
+#define STATS_BEGIN(dijkstra) do { } while(0)
+#define STATS_ADD(dijkstra, field, n) do { } while(0)
+#define STATS_MAX(dijkstra, field, value) do { } while(0)
+#define STATS_PHASE_END(dijkstra, field) do { } while(0)
+#endif
+
+/*
+ * process-wide metrics (clib_metrics), registered on the first use after clib_metrics_enable(1)
+ */
+static struct
+{
+	int shortest_path;
+	int shortest_path_reverse;
+	int shortest_path_hop_limited;
+	int edges_init;
+	int edges_update;
+	int edges_remove;
+	int edges_inserted;
+	int edges_updated;
+	int edges_removed;
+} s_metrics = { -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+static pthread_once_t s_metrics_once = PTHREAD_ONCE_INIT;
+
+static void register_metrics(void)
+{
+	s_metrics.shortest_path = clib_metrics_register("dijkstra_shortest_path_seconds", 
+		"latency of dijkstra_context::shortest_path()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.shortest_path_reverse = clib_metrics_register("dijkstra_shortest_path_reverse_seconds", 
+		"latency of dijkstra_context::shortest_path_reverse()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.shortest_path_hop_limited = clib_metrics_register("dijkstra_shortest_path_hop_limited_seconds", 
+		"latency of dijkstra_context::shortest_path_hop_limited()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.edges_init = clib_metrics_register("dijkstra_edges_init_seconds", 
+		"latency of dijkstra_edges_init_ex()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.edges_update = clib_metrics_register("dijkstra_edges_update_seconds", 
+		"latency of dijkstra_edges::update()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.edges_remove = clib_metrics_register("dijkstra_edges_remove_seconds", 
+		"latency of dijkstra_edges::remove()", CLIB_METRICS_HISTOGRAM);
+	s_metrics.edges_inserted = clib_metrics_register("dijkstra_edges_inserted_total", 
+		"number of new edges added by dijkstra_edges::update()", CLIB_METRICS_COUNTER);
+	s_metrics.edges_updated = clib_metrics_register("dijkstra_edges_updated_total", 
+		"number of existing edges re-weighted by dijkstra_edges::update()", CLIB_METRICS_COUNTER);
+	s_metrics.edges_removed = clib_metrics_register("dijkstra_edges_removed_total", 
+		"number of edges removed by dijkstra_edges::remove()", CLIB_METRICS_COUNTER);
+}
+
+/*
+ * USDT probes (provider: dijkstra), see CLIB_PROBE*() in algorithms-c-common.h
+ *   query_start(mode, src_id, dst_id, amount)
+ *   query_end(mode, src_id, dst_id, min_weight)	// min_weight: -1 if no path found
+ *   vertex_settle(vertex_id, min_weight)
+ *   edge_relax(from_id, to_id, min_weight)	// from_id is the vertex being settled
+ *   edge_update(src_id, dst_id, weight)
+ *   edge_remove(src_id, dst_id)
+ * mode: 0 = shortest_path, 1 = shortest_path_reverse, 2 = shortest_path_hop_limited
+ */
+enum dijkstra_probe_mode
+{
+	dijkstra_probe_mode_forward,
+	dijkstra_probe_mode_reverse,
+	dijkstra_probe_mode_hop_limited,
+};
+
+// @return 0 if the metrics are disabled
+static inline int64_t metrics_begin(void)
+{
+	if(!clib_metrics_register_once(&s_metrics_once, register_metrics)) return 0;
+	return clib_metrics_now_ns();
+}
 
 /************************************
  * dijkstra_sparse_edge
 ************************************/
 
 /* use <src_id | dst_id> as key */
-static int dijkstra_sparse_edge_compare(const void * _a, const void * _b)
+// the key of edges->edge_index
+struct sparse_edge_key
 {
-	const struct dijkstra_sparse_edge * a = _a;
-	const struct dijkstra_sparse_edge * b = _b;
-
-	if(a->src_id > b->src_id) return 1;
-	if(a->src_id < b->src_id) return -1;
-	if(a->dst_id > b->dst_id) return 1;
-	if(a->dst_id < b->dst_id) return -1;
-	return 0;
+	uint32_t src_id;
+	uint32_t dst_id;
+};
+static inline struct dijkstra_sparse_edge * sparse_edges_lookup(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id)
+{
+	struct sparse_edge_key key = { .src_id = src_id, .dst_id = dst_id };
+	void ** p_edge = edges->edge_index->find(edges->edge_index, &key);
+	return p_edge?*p_edge:NULL;
 }
 
 /**
@@ -61,6 +156,8 @@ static int dijkstra_sparse_edge_compare(const void * _a, const void * _b)
  * 
  *   @param row : rows[vertex.id]
  *   @param edge: an edge belongs to the vertex
+ *   @param compare: the order of the list, (by weight or by capacity)
+ *   @param node_pool: allocate the list nodes from this pool
  * 
  *  @return the pointer of row_edges_array[vertex.id]
 **/
@@ -71,13 +168,23 @@ static int sparse_edges_compare_weight(const void *_a, const void *_b)
 	
 	return (a->weight > b->weight)?1:(a->weight < b->weight)?-1:0;
 }
-static struct clib_sorted_list * sparse_edges_list_add(struct clib_sorted_list * list, const struct dijkstra_sparse_edge * edge)
+static int sparse_edges_compare_capacity(const void *_a, const void *_b)
+{
+	const struct dijkstra_sparse_edge * a = (const struct dijkstra_sparse_edge *)_a;
+	const struct dijkstra_sparse_edge * b = (const struct dijkstra_sparse_edge *)_b;
+	
+	// descending order
+	return (a->capacity < b->capacity)?1:(a->capacity > b->capacity)?-1:0;
+}
+static struct clib_sorted_list * sparse_edges_list_add(struct clib_sorted_list * list, const struct dijkstra_sparse_edge * edge, 
+	int (*compare)(const void *, const void *), struct clib_mempool * node_pool)
 {
 	assert(edge);
 	if(NULL == list) {
 		// create a new list
-		list = clib_sorted_list_init(NULL, sparse_edges_compare_weight, NULL);  
+		list = clib_sorted_list_init_ex(NULL, compare, NULL, node_pool->allocator);  
 		assert(list);
+		list->base->node_pool = node_pool;
 	}
 
 	int rc = list->add(list, (void *)edge);
@@ -88,17 +195,15 @@ static struct clib_sorted_list * sparse_edges_list_add(struct clib_sorted_list *
 /**
  * function sparse_edges_list_remove()
  * 
- *   @param row : list = vertex_edges_array[vertex.id]
+ *   @param row : list = vertex_edges_array[vertex.id] (or vertex_in_edges_array[vertex.id])
  *   @param edge: an edge belongs to the vertex
  * 
  *  @return 0 on success, -1 on failure.
 **/
-static int sparse_edges_compare_dst_id(const void *_a, const void *_b)
+static int sparse_edges_compare_pointer(const void *a, const void *b)
 {
-	const struct dijkstra_sparse_edge * a = (const struct dijkstra_sparse_edge *)_a;
-	const struct dijkstra_sparse_edge * b = (const struct dijkstra_sparse_edge *)_b;
-	
-	return (a->dst_id > b->dst_id)?1:(a->dst_id < b->dst_id)?-1:0;
+	// each edge appears only once in a list
+	return (a == b)?0:1;
 }
 static int sparse_edges_list_remove(struct clib_sorted_list * list, const struct dijkstra_sparse_edge * edge)
 {
@@ -106,7 +211,7 @@ static int sparse_edges_list_remove(struct clib_sorted_list * list, const struct
 	if(NULL == list) return -1;
 	
 	clib_list_iterator_t iter;
-	ssize_t count = list->find(list, edge, &iter, sparse_edges_compare_dst_id);
+	ssize_t count = list->find(list, edge, &iter, sparse_edges_compare_pointer);
 	if(count <= 0) return -1;
 	void * data = list->remove(list, &iter);
 	assert(data == (void *)edge);
@@ -135,18 +240,50 @@ static ssize_t get_vertex_sparse_edges(struct dijkstra_edges * edges, uint32_t v
 	return 0;
 }
 
-/**
- * function dijkstra_edges_update(): addnew or update an edge
- *   @param edges:  [IN] a dijkstra_edges object,
- *   @param src_id  [IN] the id of the start vertex
- *   @param dst_id  [IN] the id of the end vertex
- *   @param weight  [IN] weigth of this edge
- *  @return 
- *     0 on success, -1 on failure.
- * 
-**/
-static struct dijkstra_sparse_edge * dijkstra_edges_update(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, int64_t weight)
+static ssize_t get_vertex_incoming_edges(struct dijkstra_edges * edges, uint32_t vertex_id, const struct clib_slist ** p_edges)
 {
+	assert(edges->is_sparse_matrix);
+	assert(vertex_id < edges->num_vertices);
+	assert(p_edges);
+	assert(edges->vertex_in_edges_array);
+	
+	*p_edges = edges->vertex_in_edges_array->data_ptrs[vertex_id];
+	if(*p_edges) return (*p_edges)->length;
+	return 0;
+}
+
+static ssize_t get_vertex_capacity_edges(struct dijkstra_edges * edges, uint32_t vertex_id, const struct clib_slist ** p_edges)
+{
+	assert(edges->is_sparse_matrix);
+	assert(vertex_id < edges->num_vertices);
+	assert(p_edges);
+	assert(edges->vertex_capacity_array);
+	
+	*p_edges = edges->vertex_capacity_array->data_ptrs[vertex_id];
+	if(*p_edges) return (*p_edges)->length;
+	return 0;
+}
+
+static inline void dijkstra_edges_bump_version(struct dijkstra_edges * edges, uint32_t src_id)
+{
+	assert(src_id < edges->num_vertices);
+	edges->vertex_versions[src_id] = ++edges->version;
+}
+
+static inline void dijkstra_edges_release_removed(struct dijkstra_edges * edges)
+{
+	if(edges->removed_edge) {
+		clib_mempool_free(edges->edge_pool, edges->removed_edge);
+		edges->removed_edge = NULL;
+	}
+}
+
+static struct dijkstra_sparse_edge * sparse_edges_update(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, int64_t weight, 
+	int64_t metrics_begin_ns)
+{
+	dijkstra_edges_bump_version(edges, src_id);
+	if(weight < edges->min_edge_weight) edges->min_edge_weight = weight;
+	if(weight > edges->max_edge_weight) edges->max_edge_weight = weight;
 	if(!edges->is_sparse_matrix) 
 	{
 		assert(src_id < edges->num_vertices);
@@ -156,32 +293,57 @@ static struct dijkstra_sparse_edge * dijkstra_edges_update(struct dijkstra_edges
 		return NULL;
 	}
 	
-	struct dijkstra_sparse_edge * edge = calloc(1, sizeof(*edge));
+	dijkstra_edges_release_removed(edges);
+	struct clib_pointer_array * vertex_edges_array = edges->vertex_edges_array;
+	struct clib_pointer_array * vertex_capacity_array = edges->vertex_capacity_array;
+	
+	struct dijkstra_sparse_edge * edge = sparse_edges_lookup(edges, src_id, dst_id);
+	if(edge) { // already exists, ==> update weight only
+		if(metrics_begin_ns) clib_metrics_count(s_metrics.edges_updated, 1);
+		// re-order the edge by its new weight
+		sparse_edges_list_remove(vertex_edges_array->data_ptrs[src_id], edge);
+		edge->weight = weight;
+		vertex_edges_array->data_ptrs[src_id] = sparse_edges_list_add(vertex_edges_array->data_ptrs[src_id], edge, sparse_edges_compare_weight, edges->node_pool);
+		return edge;
+	}
+	
+	edge = clib_mempool_alloc(edges->edge_pool);
 	assert(edge);
+	if(metrics_begin_ns) clib_metrics_count(s_metrics.edges_inserted, 1);
 	edge->src_id = src_id;
 	edge->dst_id = dst_id;
-	
-	struct dijkstra_sparse_edge ** p_node = tsearch(edge, &edges->search_root, dijkstra_sparse_edge_compare);
-	assert(p_node);
-	if(*p_node != edge) { // already exists, ==> update weight only
-		free(edge);
-		edge = *p_node;
-	}
 	edge->weight = weight;
+	edge->capacity = DIJKSTRA_CAPACITY_UNLIMITED;
+	edge->htlc_min = 0;
+	edge->htlc_max = DIJKSTRA_CAPACITY_UNLIMITED;
 	
-	// append to row_edges array
-	struct clib_pointer_array * vertex_edges_array = edges->vertex_edges_array;
+	struct sparse_edge_key key = { .src_id = src_id, .dst_id = dst_id };
+	edges->edge_index->set(edges->edge_index, &key, edge);
 	
+	// append to row_edges array
 	clib_pointer_array_resize(vertex_edges_array, src_id + 1);
 	struct clib_sorted_list * list = vertex_edges_array->data_ptrs[src_id];
-	vertex_edges_array->data_ptrs[src_id] = sparse_edges_list_add(list, edge);
+	vertex_edges_array->data_ptrs[src_id] = sparse_edges_list_add(list, edge, sparse_edges_compare_weight, edges->node_pool);
 	if(vertex_edges_array->length <= src_id) vertex_edges_array->length = src_id + 1;
 	
+	// append to capacity index
+	clib_pointer_array_resize(vertex_capacity_array, src_id + 1);
+	list = vertex_capacity_array->data_ptrs[src_id];
+	vertex_capacity_array->data_ptrs[src_id] = sparse_edges_list_add(list, edge, sparse_edges_compare_capacity, edges->node_pool);
+	if(vertex_capacity_array->length <= src_id) vertex_capacity_array->length = src_id + 1;
+	
+	// append to incoming-edges index
+	struct clib_pointer_array * vertex_in_edges_array = edges->vertex_in_edges_array;
+	clib_pointer_array_resize(vertex_in_edges_array, dst_id + 1);
+	list = vertex_in_edges_array->data_ptrs[dst_id];
+	vertex_in_edges_array->data_ptrs[dst_id] = sparse_edges_list_add(list, edge, sparse_edges_compare_capacity, edges->node_pool);
+	if(vertex_in_edges_array->length <= dst_id) vertex_in_edges_array->length = dst_id + 1;
+	
 	return edge;
 }
 
 /**
- * function dijkstra_edges_remove():  remove an edge
+ * function dijkstra_edges_update(): addnew or update an edge
  *   @param edges:  [IN] a dijkstra_edges object,
  *   @param src_id  [IN] the id of the start vertex
  *   @param dst_id  [IN] the id of the end vertex
@@ -190,27 +352,98 @@ static struct dijkstra_sparse_edge * dijkstra_edges_update(struct dijkstra_edges
  *     0 on success, -1 on failure.
  * 
 **/
-static struct dijkstra_sparse_edge * dijkstra_edges_remove(struct dijkstra_edges * edges,  uint32_t src_id, uint32_t dst_id)
+static struct dijkstra_sparse_edge * dijkstra_edges_update(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, int64_t weight)
+{
+	CLIB_PROBE3(dijkstra, edge_update, src_id, dst_id, weight);
+	int64_t metrics_begin_ns = metrics_begin();
+	struct dijkstra_sparse_edge * edge = sparse_edges_update(edges, src_id, dst_id, weight, metrics_begin_ns);
+	clib_metrics_end(s_metrics.edges_update, metrics_begin_ns);
+	return edge;
+}
+
+/**
+ * function dijkstra_edges_set_capacity(): set capacity and htlc limits of an existing edge
+ *   @param edges:    [IN] a dijkstra_edges object,
+ *   @param src_id    [IN] the id of the start vertex
+ *   @param dst_id    [IN] the id of the end vertex
+ *   @param capacity  [IN] max amount can be sent through this edge
+ *   @param htlc_min  [IN] min amount per payment
+ *   @param htlc_max  [IN] max amount per payment
+ *  @return 
+ *     the edge on success, NULL on failure.
+ * 
+**/
+static struct dijkstra_sparse_edge * dijkstra_edges_set_capacity(struct dijkstra_edges * edges, uint32_t src_id, uint32_t dst_id, 
+	int64_t capacity, int64_t htlc_min, int64_t htlc_max)
+{
+	if(!edges->is_sparse_matrix) return NULL;
+	
+	struct dijkstra_sparse_edge * edge = sparse_edges_lookup(edges, src_id, dst_id);
+	if(NULL == edge) return NULL;
+	
+	struct clib_pointer_array * vertex_capacity_array = edges->vertex_capacity_array;
+	struct clib_pointer_array * vertex_in_edges_array = edges->vertex_in_edges_array;
+	dijkstra_edges_bump_version(edges, src_id);
+	
+	edge->htlc_min = htlc_min;
+	edge->htlc_max = htlc_max;
+	if(edge->capacity != capacity) { // re-order the edge by its new capacity
+		sparse_edges_list_remove(vertex_capacity_array->data_ptrs[src_id], edge);
+		sparse_edges_list_remove(vertex_in_edges_array->data_ptrs[dst_id], edge);
+		edge->capacity = capacity;
+		vertex_capacity_array->data_ptrs[src_id] = sparse_edges_list_add(vertex_capacity_array->data_ptrs[src_id], edge, sparse_edges_compare_capacity, edges->node_pool);
+		vertex_in_edges_array->data_ptrs[dst_id] = sparse_edges_list_add(vertex_in_edges_array->data_ptrs[dst_id], edge, sparse_edges_compare_capacity, edges->node_pool);
+	}
+	return edge;
+}
+
+static struct dijkstra_sparse_edge * sparse_edges_remove(struct dijkstra_edges * edges,  uint32_t src_id, uint32_t dst_id)
 {
+	dijkstra_edges_bump_version(edges, src_id);
 	if(!edges->is_sparse_matrix) {
 		assert(src_id < edges->num_vertices);
 		assert(dst_id < edges->num_vertices);
 		edges->weights[src_id * edges->num_vertices + dst_id] = -1;
 		return NULL;
 	}
-	struct dijkstra_sparse_edge pattern = {
-		.src_id = src_id,
-		.dst_id = dst_id
-	};
-	struct dijkstra_sparse_edge ** p_node = tfind(&pattern, &edges->search_root, dijkstra_sparse_edge_compare);
-	if(NULL == p_node) return NULL;
+	dijkstra_edges_release_removed(edges);
+	struct sparse_edge_key key = { .src_id = src_id, .dst_id = dst_id };
+	struct dijkstra_sparse_edge * edge = NULL;
+	if(edges->edge_index->remove(edges->edge_index, &key, (void **)&edge)) return NULL;
 	
-	struct dijkstra_sparse_edge * edge = *p_node;
-	tdelete(&pattern, &edges->search_root, dijkstra_sparse_edge_compare);
 	sparse_edges_list_remove(edges->vertex_edges_array->data_ptrs[src_id], edge);
+	sparse_edges_list_remove(edges->vertex_capacity_array->data_ptrs[src_id], edge);
+	sparse_edges_list_remove(edges->vertex_in_edges_array->data_ptrs[dst_id], edge);
+	edges->removed_edge = edge;
+	return edge;
+}
+
+/**
+ * function dijkstra_edges_remove():  remove an edge
+ *   @param edges:  [IN] a dijkstra_edges object,
+ *   @param src_id  [IN] the id of the start vertex
+ *   @param dst_id  [IN] the id of the end vertex
+ *   @param weight  [IN] weigth of this edge
+ *  @return 
+ *     0 on success, -1 on failure.
+ * 
+**/
+static struct dijkstra_sparse_edge * dijkstra_edges_remove(struct dijkstra_edges * edges,  uint32_t src_id, uint32_t dst_id)
+{
+	CLIB_PROBE2(dijkstra, edge_remove, src_id, dst_id);
+	int64_t metrics_begin_ns = metrics_begin();
+	struct dijkstra_sparse_edge * edge = sparse_edges_remove(edges, src_id, dst_id);
+	if(metrics_begin_ns && edge) clib_metrics_count(s_metrics.edges_removed, 1);
+	clib_metrics_end(s_metrics.edges_remove, metrics_begin_ns);
 	return edge;
 }
 
+static struct dijkstra_sparse_edge * dijkstra_edges_find(struct dijkstra_edges * edges,  uint32_t src_id, uint32_t dst_id)
+{
+	if(!edges->is_sparse_matrix) return NULL;
+	return sparse_edges_lookup(edges, src_id, dst_id);
+}
+
 static int64_t dijkstra_edges_get_weight(struct dijkstra_edges * edges,  uint32_t src_id, uint32_t dst_id)
 {
 	int64_t weight = -1;
@@ -221,15 +454,8 @@ static int64_t dijkstra_edges_get_weight(struct dijkstra_edges * edges,  uint32_
 		return weight;
 	}
 	
-	struct dijkstra_sparse_edge pattern = {
-		.src_id = src_id,
-		.dst_id = dst_id
-	};
-	struct dijkstra_sparse_edge ** p_node = tfind(&pattern, &edges->search_root, dijkstra_sparse_edge_compare);
-	if(NULL == p_node) return -1;
-	
-	struct dijkstra_sparse_edge * edge = *p_node;
-	assert(edge);
+	struct dijkstra_sparse_edge * edge = sparse_edges_lookup(edges, src_id, dst_id);
+	if(NULL == edge) return -1;
 	weight = edge->weight;
 	
 	return weight;
@@ -237,8 +463,16 @@ static int64_t dijkstra_edges_get_weight(struct dijkstra_edges * edges,  uint32_
 
 struct dijkstra_edges * dijkstra_edges_init(struct dijkstra_edges * edges, int is_sparse_matrix, uint32_t num_vertices)
 {
+	return dijkstra_edges_init_ex(edges, is_sparse_matrix, num_vertices, NULL);
+}
+
+struct dijkstra_edges * dijkstra_edges_init_ex(struct dijkstra_edges * edges, int is_sparse_matrix, uint32_t num_vertices, 
+	struct clib_allocator * allocator)
+{
+	int64_t metrics_begin_ns = metrics_begin();
 	if(NULL == edges) edges = calloc(1, sizeof(*edges));
 	else memset(edges, 0, sizeof(*edges));
+	edges->allocator = allocator;
 	
 	edges->is_sparse_matrix = is_sparse_matrix;
 	edges->num_vertices = num_vertices;
@@ -247,28 +481,50 @@ struct dijkstra_edges * dijkstra_edges_init(struct dijkstra_edges * edges, int i
 	edges->remove = dijkstra_edges_remove;
 	edges->get_weight = dijkstra_edges_get_weight;
 	edges->get_vertex_sparse_edges = get_vertex_sparse_edges;
+	edges->set_capacity = dijkstra_edges_set_capacity;
+	edges->get_vertex_capacity_edges = get_vertex_capacity_edges;
+	edges->get_vertex_incoming_edges = get_vertex_incoming_edges;
+	edges->find = dijkstra_edges_find;
+	
+	assert(num_vertices > 0);
+	edges->vertex_versions = clib_alloc(allocator, num_vertices * sizeof(*edges->vertex_versions));
+	assert(edges->vertex_versions);
 	
 	if(is_sparse_matrix) {
 		assert(num_vertices > 0);
-		clib_pointer_array_init(edges->vertex_edges_array, num_vertices);
+		clib_pointer_array_init_ex(edges->vertex_edges_array, num_vertices, allocator);
 		assert(edges->vertex_edges_array->data_ptrs);
+		clib_pointer_array_init_ex(edges->vertex_capacity_array, num_vertices, allocator);
+		assert(edges->vertex_capacity_array->data_ptrs);
+		clib_pointer_array_init_ex(edges->vertex_in_edges_array, num_vertices, allocator);
+		assert(edges->vertex_in_edges_array->data_ptrs);
+		
+		clib_mempool_init_ex(edges->edge_pool, sizeof(struct dijkstra_sparse_edge), 1024, allocator);
+		clib_hashmap_init(edges->edge_index, sizeof(struct sparse_edge_key), 0, allocator);
+		clib_mempool_init_ex(edges->node_pool, sizeof(struct clib_slist_node), 4096, allocator);
 	}
 	
+	clib_metrics_end(s_metrics.edges_init, metrics_begin_ns);
 	return edges;
 }
 
 
-static void free_sorted_list(void * list)
+static void free_sorted_list(void * _list)
 {
+	struct clib_sorted_list * list = _list;
+	if(NULL == list) return; // vertex without edges
 	clib_sorted_list_clear(list);
-	free(list);
+	clib_free(list->base->allocator, list);
 }
 
 void dijkstra_edges_cleanup(struct dijkstra_edges * edges)
 {
 	if(NULL == edges) return;
+	clib_free(edges->allocator, edges->vertex_versions);
+	edges->vertex_versions = NULL;
+	
 	if(!edges->is_sparse_matrix) {
-		free(edges->weights);
+		clib_free(edges->allocator, edges->weights);
 		edges->weights = NULL;
 	}else {
 		assert(edges->num_vertices <= edges->vertex_edges_array->max_size);
@@ -276,12 +532,159 @@ void dijkstra_edges_cleanup(struct dijkstra_edges * edges)
 		edges->vertex_edges_array->length = edges->num_vertices;
 		clib_pointer_array_cleanup(edges->vertex_edges_array, free_sorted_list);
 		
-		tdestroy(edges->search_root, free);
-		edges->search_root = NULL;
+		assert(edges->num_vertices <= edges->vertex_capacity_array->max_size);
+		edges->vertex_capacity_array->length = edges->num_vertices;
+		clib_pointer_array_cleanup(edges->vertex_capacity_array, free_sorted_list);
+		
+		assert(edges->num_vertices <= edges->vertex_in_edges_array->max_size);
+		edges->vertex_in_edges_array->length = edges->num_vertices;
+		clib_pointer_array_cleanup(edges->vertex_in_edges_array, free_sorted_list);
+		
+		clib_hashmap_cleanup(edges->edge_index);	// the edges are owned by edges->edge_pool
+		
+		// bulk release
+		clib_mempool_cleanup(edges->edge_pool);
+		clib_mempool_cleanup(edges->node_pool);
+		edges->removed_edge = NULL;
 	}
 	return;
 }
 
+static size_t vertex_rows_memory_usage(const struct clib_pointer_array * rows, size_t * p_num_lists)
+{
+	size_t num_lists = 0;
+	for(size_t i = 0; i < rows->length; ++i) if(rows->data_ptrs[i]) ++num_lists;
+	*p_num_lists += num_lists;
+	return rows->max_size * sizeof(*rows->data_ptrs);
+}
+
+size_t dijkstra_edges_memory_usage(const struct dijkstra_edges * edges, struct dijkstra_edges_memory_usage * usage)
+{
+	assert(edges);
+	struct dijkstra_edges_memory_usage local_usage;
+	if(NULL == usage) usage = &local_usage;
+	memset(usage, 0, sizeof(*usage));
+	
+	if(edges->vertex_versions) usage->vertex_versions = edges->num_vertices * sizeof(*edges->vertex_versions);
+	if(!edges->is_sparse_matrix) {
+		if(edges->weights) usage->weights = (size_t)edges->num_vertices * edges->num_vertices * sizeof(*edges->weights);
+	}else {
+		usage->edges = clib_mempool_memory_usage(edges->edge_pool);
+		usage->num_edges = edges->edge_pool->num_objects;
+		usage->edge_index = clib_hashmap_memory_usage(edges->edge_index);
+		usage->vertex_arrays = vertex_rows_memory_usage(edges->vertex_edges_array, &usage->num_lists)
+			+ vertex_rows_memory_usage(edges->vertex_capacity_array, &usage->num_lists)
+			+ vertex_rows_memory_usage(edges->vertex_in_edges_array, &usage->num_lists);
+		usage->vertex_lists = usage->num_lists * sizeof(struct clib_sorted_list);
+		usage->list_nodes = clib_mempool_memory_usage(edges->node_pool);
+	}
+	
+	usage->total = usage->edges + usage->edge_index + usage->vertex_arrays + usage->vertex_lists 
+		+ usage->list_nodes + usage->vertex_versions + usage->weights;
+	return usage->total;
+}
+
+/************************************
+ * dijkstra_search_state
+************************************/
+static void dijkstra_search_state_cleanup(struct dijkstra_context * dijkstra)
+{
+	struct dijkstra_search_state * state = dijkstra->search;
+	void * arrays[] = { state->dist64, state->dist32, state->parent, state->depth, state->amount, state->flags };
+	for(size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i) {
+		if(arrays[i]) clib_free(dijkstra->allocator, arrays[i]);
+	}
+	clib_u32_vec_cleanup(state->exported);
+	
+	state->num_vertices = 0;
+	state->distance_bits = 0;
+	state->dist64 = NULL;
+	state->dist32 = NULL;
+	state->parent = NULL;
+	state->depth = NULL;
+	state->amount = NULL;
+	state->flags = NULL;
+}
+
+/*
+ * allocates the arrays on first use, then resets the distances and the flags,
+ * dist32[] is selected if the path weights can not reach DIJKSTRA_DIST32_UNSET.
+ */
+static void dijkstra_search_state_reset(struct dijkstra_context * dijkstra)
+{
+	const struct dijkstra_graph * graph = dijkstra->graph;
+	const struct dijkstra_edges * edges = graph->edges;
+	struct dijkstra_search_state * state = dijkstra->search;
+	struct clib_allocator * allocator = dijkstra->allocator;
+	const size_t num_vertices = graph->num_vertices;
+	const size_t num_flag_words = (num_vertices + 31) / 32;
+	
+	if(0 == state->num_vertices) {
+		state->parent = clib_alloc(allocator, num_vertices * sizeof(*state->parent));
+		state->depth = clib_alloc(allocator, num_vertices * sizeof(*state->depth));
+		state->flags = clib_alloc(allocator, num_flag_words * sizeof(*state->flags));
+		assert(state->parent && state->depth && state->flags);
+		state->num_vertices = num_vertices;
+		STATS_ADD(dijkstra, allocations, 3);
+	}
+	assert(state->num_vertices == num_vertices);
+	
+	int distance_bits = 64;
+	if(dijkstra->distance_bits != 64 && NULL == dijkstra->calc_weight && edges->min_edge_weight >= 0) {
+		if(num_vertices <= 1 || edges->max_edge_weight <= (int64_t)((DIJKSTRA_DIST32_UNSET - 1) / (num_vertices - 1))) {
+			distance_bits = 32;
+		}
+	}
+	state->distance_bits = distance_bits;
+	if(32 == distance_bits) {
+		if(NULL == state->dist32) {
+			state->dist32 = clib_alloc(allocator, num_vertices * sizeof(*state->dist32));
+			assert(state->dist32);
+			STATS_ADD(dijkstra, allocations, 1);
+		}
+		memset(state->dist32, 0xff, num_vertices * sizeof(*state->dist32));	// DIJKSTRA_DIST32_UNSET
+	}else {
+		if(NULL == state->dist64) {
+			state->dist64 = clib_alloc(allocator, num_vertices * sizeof(*state->dist64));
+			assert(state->dist64);
+			STATS_ADD(dijkstra, allocations, 1);
+		}
+		for(size_t i = 0; i < num_vertices; ++i) state->dist64[i] = DIJKSTRA_WEIGHT_UNSET;
+	}
+	if(dijkstra->calc_amount && NULL == state->amount) {
+		state->amount = clib_alloc(allocator, num_vertices * sizeof(*state->amount));
+		assert(state->amount);
+		STATS_ADD(dijkstra, allocations, 1);
+	}
+	memset(state->flags, 0, num_flag_words * sizeof(*state->flags));
+}
+
+static inline int64_t search_get_dist(const struct dijkstra_search_state * state, uint32_t id)
+{
+	if(32 == state->distance_bits) {
+		uint32_t dist = state->dist32[id];
+		return (dist == DIJKSTRA_DIST32_UNSET)?DIJKSTRA_WEIGHT_UNSET:(int64_t)dist;
+	}
+	return state->dist64[id];
+}
+static inline void search_set_dist(struct dijkstra_search_state * state, uint32_t id, int64_t weight)
+{
+	if(32 == state->distance_bits) {
+		assert(weight >= 0 && weight < DIJKSTRA_DIST32_UNSET);
+		state->dist32[id] = (uint32_t)weight;
+	}else {
+		state->dist64[id] = weight;
+	}
+}
+static inline void search_set_flags(struct dijkstra_search_state * state, uint32_t id, int flags)
+{
+	state->flags[id / 32] |= (uint64_t)flags << ((id % 32) * 2);
+}
+static inline void search_clear_flags(struct dijkstra_search_state * state, uint32_t id, int flags)
+{
+	state->flags[id / 32] &= ~((uint64_t)flags << ((id % 32) * 2));
+}
+
 /************************************
  * dijkstra_vertex_status
 ************************************/
@@ -292,33 +695,155 @@ void dijkstra_clear_status_array(struct dijkstra_context * dijkstra)
 		assert(dijkstra->graph != NULL);
 		for(size_t i = 0; i < dijkstra->graph->num_vertices; ++i) {
 			struct dijkstra_vertex_status * status = &dijkstra->status_array[i];
-			clib_pointer_array_cleanup(status->parent_candidates, NULL);
+			clib_u32_vec_cleanup(status->parent_candidates);
 		}
-		free(dijkstra->status_array);
+		clib_free(dijkstra->allocator, dijkstra->status_array);
 		dijkstra->status_array = NULL;
 	}
+	dijkstra_search_state_cleanup(dijkstra);
 }
 
 void dijkstra_vertex_status_dump(const struct dijkstra_vertex_status * status)
 {
 	assert(status);
-	const struct dijkstra_vertex_status * parent = NULL;
-	if(status->parent_candidates->length > 0) parent = status->parent_candidates->data_ptrs[0];
+	int parent_id = -1;
+	if(status->parent_candidates->length > 0) parent_id = *clib_u32_vec_at(status->parent_candidates, 0);
 	
 	printf("vertex.id=%u, min_weight=%ld, amount=%ld, "
 		"visited=%d, is_processing=%d, depth=%d, parent_id=%d\n",
 		status->id, (long)status->min_weight, (long)status->amount,
 		status->visited, status->is_processing,
 		(int)status->depth,
-		parent?(int)parent->id:-1);
+		parent_id);
 }
 
-static int vertex_status_compare_by_depth(const void * _a, const void * _b)
+static inline void vertex_status_reset(struct dijkstra_vertex_status * status)
 {
-	const struct dijkstra_vertex_status *a = *(const struct dijkstra_vertex_status **)_a;
-	const struct dijkstra_vertex_status *b = *(const struct dijkstra_vertex_status **)_b;
-	assert(a && b);
-	return (a->depth - b->depth);
+	status->min_weight = DIJKSTRA_WEIGHT_UNSET;
+	status->amount = INT64_MAX;
+	status->visited = 0;
+	status->is_processing = 0;
+	status->depth = 0;
+	clib_u32_vec_clear(status->parent_candidates);
+}
+
+/*
+ * status_array is allocated and initialized once, 
+ * then only the entries filled by the previous search are reset.
+ */
+static struct dijkstra_vertex_status * dijkstra_reset_status_array(struct dijkstra_context * dijkstra)
+{
+	const struct dijkstra_graph * graph = dijkstra->graph;
+	struct clib_u32_vec * exported = dijkstra->search->exported;
+	struct dijkstra_vertex_status * status_array = dijkstra->status_array;
+	if(NULL == status_array) {
+		status_array = clib_alloc(dijkstra->allocator, graph->num_vertices * sizeof(*status_array));
+		assert(status_array);
+		STATS_ADD(dijkstra, allocations, 1);
+		for(uint32_t i = 0; i < graph->num_vertices; ++i) {
+			struct dijkstra_vertex_status *status = &status_array[i];
+			status->vertex = &graph->vertices[i];
+			status->id = i;
+			clib_u32_vec_init(status->parent_candidates, dijkstra->allocator);
+			vertex_status_reset(status);
+		}
+		dijkstra->status_array = status_array;
+	}else {
+		const uint32_t * ids = clib_u32_vec_data(exported);
+		for(size_t i = 0; i < exported->length; ++i) vertex_status_reset(&status_array[ids[i]]);
+	}
+	clib_u32_vec_clear(exported);
+	return status_array;
+}
+
+static inline void parent_candidates_push(struct dijkstra_context * dijkstra, struct clib_u32_vec * parent_candidates, uint32_t id)
+{
+#ifdef DIJKSTRA_ENABLE_STATS
+	size_t capacity = parent_candidates->capacity;
+	clib_u32_vec_push(parent_candidates, id);
+	if(parent_candidates->capacity != capacity) ++dijkstra->stats.allocations;
+#else
+	clib_u32_vec_push(parent_candidates, id);
+#endif
+}
+
+/*
+ * fill the result view of a vertex on the path
+ *  @param parent_id: UINT32_MAX for the first vertex of the chain
+ */
+static struct dijkstra_vertex_status * export_vertex_status(struct dijkstra_context * dijkstra, uint32_t id, 
+	int64_t min_weight, int64_t amount, int depth, int visited, uint32_t parent_id)
+{
+	struct dijkstra_vertex_status * status = &dijkstra->status_array[id];
+	status->min_weight = min_weight;
+	status->amount = amount;
+	status->depth = depth;
+	status->visited = visited;
+	clib_u32_vec_clear(status->parent_candidates);
+	if(parent_id != UINT32_MAX) parent_candidates_push(dijkstra, status->parent_candidates, parent_id);
+	clib_u32_vec_push(dijkstra->search->exported, id);
+	return status;
+}
+
+/*
+ * the work queue holds vertex ids, stored as (id + 1): pop_front() returns NULL when the queue is empty
+ */
+static inline void work_queue_push(struct dijkstra_context * dijkstra, struct clib_deque * queue, uint32_t id)
+{
+	void * item = (void *)((uintptr_t)id + 1);
+#ifdef DIJKSTRA_ENABLE_STATS
+	size_t size = queue->size;
+	queue->push_back(queue, item);
+	if(queue->size != size) ++dijkstra->stats.allocations;
+	++dijkstra->stats.vertices_enqueued;
+	STATS_MAX(dijkstra, queue_high_water, queue->length);
+#else
+	queue->push_back(queue, item);
+#endif
+}
+static inline uint32_t work_queue_id(void * item)
+{
+	return (uint32_t)((uintptr_t)item - 1);
+}
+
+/*
+ * export the chain of parents from first_id to last_id (the last one has no parent) into status_array,
+ * the forward search follows it from dst_id, the reverse search from src_id.
+ *  @return the length of the chain
+ */
+static size_t export_search_path(struct dijkstra_context * dijkstra, uint32_t first_id, uint32_t last_id,
+	struct dijkstra_vertex_status ** path, size_t length)
+{
+	const struct dijkstra_search_state * state = dijkstra->search;
+	size_t count = 0;
+	for(uint32_t id = first_id; ; id = state->parent[id]) {
+		const uint32_t parent_id = (id == last_id)?UINT32_MAX:state->parent[id];
+		const int64_t amount = dijkstra->calc_amount?state->amount[id]:dijkstra->amount;
+		const int visited = (dijkstra_search_state_get_flags(state, id) & DIJKSTRA_VERTEX_VISITED) != 0;
+		struct dijkstra_vertex_status * status = export_vertex_status(dijkstra, id, 
+			search_get_dist(state, id), amount, (int)state->depth[id], visited, parent_id);
+		if(path) {
+			assert(count < length);
+			path[count] = status;
+		}
+		++count;
+		if(parent_id == UINT32_MAX) break;
+	}
+	return count;
+}
+
+/*
+ * the number of vertices from id to last_id (included) along the parents, 
+ * the depth decreases strictly along this chain
+ */
+static size_t search_path_length(const struct dijkstra_search_state * state, uint32_t id, uint32_t last_id)
+{
+	size_t length = 1;
+	for(; id != last_id; id = state->parent[id]) {
+		assert(state->depth[state->parent[id]] < state->depth[id]);
+		++length;
+	}
+	return length;
 }
 
 ssize_t dijkstra_shortest_path(
@@ -329,141 +854,476 @@ ssize_t dijkstra_shortest_path(
 	assert(dijkstra && dijkstra->graph);
 	assert(src_id < dijkstra->graph->num_vertices);
 	assert(dst_id < dijkstra->graph->num_vertices);
+	STATS_BEGIN(dijkstra);
+	int64_t metrics_begin_ns = metrics_begin();
+	CLIB_PROBE4(dijkstra, query_start, dijkstra_probe_mode_forward, src_id, dst_id, dijkstra->amount);
 	
 	const struct dijkstra_graph * graph = dijkstra->graph;
 	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
 
-	struct clib_queue queue[1];
-	clib_queue_init(queue);
+	struct clib_deque * queue = dijkstra->work_queue;
+	clib_deque_clear(queue, NULL);
 	
-	// step 0. init status_array
-	dijkstra_clear_status_array(dijkstra);
-	struct dijkstra_vertex_status * status_array = calloc(graph->num_vertices, sizeof(*status_array));
-	for(uint32_t i = 0; i < graph->num_vertices; ++i) {
-		struct dijkstra_vertex_status *status = &status_array[i];
-		status->vertex = &graph->vertices[i];
-		status->id = i;
-		status->min_weight = DIJKSTRA_WEIGHT_UNSET;
-		status->amount = INT64_MAX;
-		
-		status->visited = 0;
-		status->is_processing = 0;
-		
-		clib_pointer_array_init(status->parent_candidates, 0);
-	}
-	dijkstra->status_array = status_array;
-	struct dijkstra_vertex_status * dst_status = &status_array[dst_id];
+	// step 0. reset the search state and the result view
+	struct dijkstra_search_state * state = dijkstra->search;
+	dijkstra_search_state_reset(dijkstra);
+	dijkstra_reset_status_array(dijkstra);
+	STATS_PHASE_END(dijkstra, init_ns);
 	
 	// step 1. push vertices[src_id] to working queue
-	struct dijkstra_vertex_status * vertex = &status_array[src_id];
-	vertex->amount = dijkstra->amount;
-	vertex->min_weight = 0;
-	queue->enter(queue, vertex);
-	vertex->is_processing = 1;
+	int64_t * amounts = dijkstra->calc_amount?state->amount:NULL;
+	search_set_dist(state, src_id, 0);
+	state->depth[src_id] = 0;
+	if(amounts) amounts[src_id] = dijkstra->amount;
+	work_queue_push(dijkstra, queue, src_id);
+	search_set_flags(state, src_id, DIJKSTRA_VERTEX_QUEUED);
 
 	int found = 0;
-	struct dijkstra_vertex_status * current = NULL;
-	while((current = queue->leave(queue)))
+	const int check_capacity = (dijkstra->amount > 0);
+	void * item = NULL;
+	while((item = queue->pop_front(queue)))
 	{
-		if(current->id == dst_id) {	// found a path
+		const uint32_t current_id = work_queue_id(item);
+		search_clear_flags(state, current_id, DIJKSTRA_VERTEX_QUEUED);
+		if(current_id == dst_id) {	// found a path
 			found = 1;
 			continue;
 		}
-		debug_printf("====  current: "); dijkstra_vertex_status_dump(current);
-		if(found && current->min_weight > dst_status->min_weight) {
-			debug_printf("  --> skipped [%u], min_weight=%ld\n", current->id, (long)current->min_weight);
+		const int64_t current_weight = search_get_dist(state, current_id);
+		debug_printf("====  current: [%u], min_weight=%ld\n", current_id, (long)current_weight);
+		if(found && current_weight > search_get_dist(state, dst_id)) {
+			debug_printf("  --> skipped [%u], min_weight=%ld\n", current_id, (long)current_weight);
 			continue;
 		}
+		STATS_ADD(dijkstra, vertices_settled, 1);
+		CLIB_PROBE2(dijkstra, vertex_settle, current_id, current_weight);
+		const int64_t current_amount = amounts?amounts[current_id]:dijkstra->amount;
+		const uint32_t next_depth = state->depth[current_id] + 1;
 		
-		// step 2. get all edges belong to the current vertex
+		// step 2. get all edges belong to the current vertex, 
+		// when an amount is given, use the capacity index to skip the edges which can not forward the amount
 		struct clib_slist * vertex_edges = NULL;
-		ssize_t count = edges->get_vertex_sparse_edges(edges, current->id, (const struct clib_slist **)&vertex_edges);
+		ssize_t count = 0;
+		if(check_capacity) count = edges->get_vertex_capacity_edges(edges, current_id, (const struct clib_slist **)&vertex_edges);
+		else count = edges->get_vertex_sparse_edges(edges, current_id, (const struct clib_slist **)&vertex_edges);
 		debug_printf("  -- edges-count=%d\n", (int)count);
-		if(count <= 0) continue;
+		if(count <= 0) {
+			search_set_flags(state, current_id, DIJKSTRA_VERTEX_VISITED);
+			continue;
+		}
 		
 		// step 3. update min_weight
 		clib_list_iterator_t iter;
 		memset(&iter, 0, sizeof(iter));
-		//~ _Bool ok = clib_slist_iter_begin(vertex_edges, &iter);
 		clib_slist_iter_clear(vertex_edges);
 		
 		while(clib_slist_iter_next(vertex_edges, &iter)) {
 			struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
 			assert(edge);
 			assert(edge->dst_id < edges->num_vertices);
-			vertex = &status_array[edge->dst_id];
-			if(vertex->visited) continue;
+			if(check_capacity) {
+				if(edge->capacity < current_amount) break; // all the remaining edges have less capacity
+				if(!dijkstra_sparse_edge_can_forward(edge, current_amount)) continue;
+			}
 			
-			if(vertex->id == dst_id) found = 1; 
+			const uint32_t id = edge->dst_id;
+			if(id == dst_id) found = 1; 
+			STATS_ADD(dijkstra, edges_scanned, 1);
 			int64_t weight = INT64_MAX;
 			if(dijkstra->calc_weight) {
-				weight = current->min_weight + dijkstra->calc_weight(current->amount, edge->user_data);
+				STATS_ADD(dijkstra, callbacks, 1);
+				weight = current_weight + dijkstra->calc_weight(current_amount, edge->user_data);
 			}else {
-				weight = current->min_weight + edge->weight;
+				weight = current_weight + edge->weight;
 			}
-			if(weight <= vertex->min_weight) {
-				vertex->min_weight = weight;
-				vertex->depth = current->depth + 1;
-				
-				struct clib_pointer_array * parent_candidates = vertex->parent_candidates;
-				if(weight < vertex->min_weight) { // found a new candidate, clear old candidates list
-					clib_pointer_array_set_length(parent_candidates, 1);
-				}else { // found a candidate with the same min_weight
-					clib_pointer_array_set_length(parent_candidates, parent_candidates->length + 1);
+			const int64_t min_weight = search_get_dist(state, id);
+			int improved = (weight < min_weight);
+			if(weight <= min_weight) {
+				// a new min_weight, or a candidate with the same min_weight and fewer hops
+				if(improved || next_depth < state->depth[id]) {
+					int64_t amount = 0;
+					if(amounts) {
+						STATS_ADD(dijkstra, callbacks, 1);
+						amount = dijkstra->calc_amount(current_amount, edge->user_data);
+					}
+					// a tie does not re-queue id, its out-edges were checked against the old amount:
+					// switch the parent only if the amount stays the same
+					if(improved || NULL == amounts || amount == amounts[id]) {
+						search_set_dist(state, id, weight);
+						state->parent[id] = current_id;
+						state->depth[id] = next_depth;
+						if(amounts) amounts[id] = amount;
+					}
 				}
-				parent_candidates->data_ptrs[parent_candidates->length - 1] = current;
-				if(dijkstra->calc_amount) vertex->amount = dijkstra->calc_amount(current->amount, edge->user_data);
-				
-				debug_printf("    \e[32m-- next possible hop: \e[39m"); dijkstra_vertex_status_dump(vertex);
+				STATS_ADD(dijkstra, edges_relaxed, 1);
+				CLIB_PROBE3(dijkstra, edge_relax, current_id, id, weight);
+				debug_printf("    \e[32m-- next possible hop: \e[39m[%u], min_weight=%ld\n", id, (long)weight);
 			}else {
-				debug_printf("    \e[33m-- skipped: \e[39m"); dijkstra_vertex_status_dump(vertex);
+				debug_printf("    \e[33m-- skipped: \e[39m[%u], min_weight=%ld\n", id, (long)min_weight);
 			}
 			
-			// step 4. push unprocessed vertex into queue
-			if(!vertex->is_processing) {
-				vertex->is_processing = 1;
-				debug_printf("\e[32m         ==> push [%d]\e[39m\n", (int)vertex->id);
-				queue->enter(queue, vertex);
+			// step 4. push the improved vertex into queue (again if it has been visited)
+			if(improved && !(dijkstra_search_state_get_flags(state, id) & DIJKSTRA_VERTEX_QUEUED)) {
+				search_set_flags(state, id, DIJKSTRA_VERTEX_QUEUED);
+				debug_printf("\e[32m         ==> push [%d]\e[39m\n", (int)id);
+				work_queue_push(dijkstra, queue, id);
 			}
 		}
-		current->visited = 1;
+		search_set_flags(state, current_id, DIJKSTRA_VERTEX_VISITED);
 	}
 	
-	clib_queue_clear(queue, NULL);
+	clib_deque_clear(queue, NULL);
+	STATS_PHASE_END(dijkstra, search_ns);
+	
+	// get path: export the vertices on the path to status_array
+	int64_t min_weight = found?search_get_dist(state, dst_id):-1;
+	if(found)
+	{
+		size_t length = search_path_length(state, dst_id, src_id);
+		struct dijkstra_vertex_status ** path = NULL;
+		if(candidates) {
+			clib_pointer_array_clear(candidates, NULL);
+			clib_pointer_array_set_length(candidates, length);
+			path = (struct dijkstra_vertex_status **)candidates->data_ptrs;
+		}
+		export_search_path(dijkstra, dst_id, src_id, path, length);
+		
+		// [src_id, ..., dst_id]
+		for(size_t i = 0; path && i < length / 2; ++i) {
+			struct dijkstra_vertex_status * status = path[i];
+			path[i] = path[length - 1 - i];
+			path[length - 1 - i] = status;
+		}
+		assert(NULL == path || path[0]->id == src_id);
+	}
+	STATS_PHASE_END(dijkstra, path_ns);
+	clib_metrics_end(s_metrics.shortest_path, metrics_begin_ns);
+	CLIB_PROBE4(dijkstra, query_end, dijkstra_probe_mode_forward, src_id, dst_id, min_weight);
+	return min_weight;
+}
+
+/**
+ * function dijkstra_shortest_path_reverse(): 
+ *   search from dst_id to src_id over the incoming edges.
+ *   dijkstra->amount is the amount received by dst_id, 
+ *   the fees (calc_weight) and the forwarded amount (calc_amount) of each hop are 
+ *   calculated with the exact amount the edge must carry.
+ * 
+ *   depth is the number of hops to dst_id, 
+ *   parent is the next hop (toward dst_id).
+ *  @return min_weight on success, -1 if no path found.
+**/
+ssize_t dijkstra_shortest_path_reverse(
+	struct dijkstra_context * dijkstra, 
+	uint32_t src_id, uint32_t dst_id,
+	struct clib_pointer_array * candidates)
+{
+	assert(dijkstra && dijkstra->graph);
+	assert(src_id < dijkstra->graph->num_vertices);
+	assert(dst_id < dijkstra->graph->num_vertices);
+	STATS_BEGIN(dijkstra);
+	int64_t metrics_begin_ns = metrics_begin();
+	CLIB_PROBE4(dijkstra, query_start, dijkstra_probe_mode_reverse, src_id, dst_id, dijkstra->amount);
+	
+	const struct dijkstra_graph * graph = dijkstra->graph;
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
+	assert(edges->is_sparse_matrix);
+
+	struct clib_deque * queue = dijkstra->work_queue;
+	clib_deque_clear(queue, NULL);
 	
-	// get path
-	if(found && candidates)
+	// step 0. reset the search state and the result view
+	struct dijkstra_search_state * state = dijkstra->search;
+	dijkstra_search_state_reset(dijkstra);
+	dijkstra_reset_status_array(dijkstra);
+	STATS_PHASE_END(dijkstra, init_ns);
+	
+	// step 1. push vertices[dst_id] to working queue
+	int64_t * amounts = dijkstra->calc_amount?state->amount:NULL;
+	search_set_dist(state, dst_id, 0);
+	state->depth[dst_id] = 0;
+	if(amounts) amounts[dst_id] = dijkstra->amount;
+	work_queue_push(dijkstra, queue, dst_id);
+	search_set_flags(state, dst_id, DIJKSTRA_VERTEX_QUEUED);
+	
+	int found = 0;
+	const int check_capacity = (dijkstra->amount > 0);
+	void * item = NULL;
+	while((item = queue->pop_front(queue)))
 	{
-		struct dijkstra_vertex_status * vertex = dst_status;
-		assert(dst_status->depth >= 0);
-		clib_pointer_array_clear(candidates, NULL);
+		const uint32_t current_id = work_queue_id(item);
+		search_clear_flags(state, current_id, DIJKSTRA_VERTEX_QUEUED);
+		if(current_id == src_id) {	// found a path
+			found = 1;
+			continue;
+		}
+		const int64_t current_weight = search_get_dist(state, current_id);
+		if(found && current_weight > search_get_dist(state, src_id)) continue;
+		STATS_ADD(dijkstra, vertices_settled, 1);
+		CLIB_PROBE2(dijkstra, vertex_settle, current_id, current_weight);
+		const int64_t current_amount = amounts?amounts[current_id]:dijkstra->amount;
+		const uint32_t next_depth = state->depth[current_id] + 1;
+		
+		// step 2. get all incoming edges of the current vertex, order by capacity (descending)
+		struct clib_slist * vertex_edges = NULL;
+		ssize_t count = edges->get_vertex_incoming_edges(edges, current_id, (const struct clib_slist **)&vertex_edges);
+		if(count <= 0) {
+			search_set_flags(state, current_id, DIJKSTRA_VERTEX_VISITED);
+			continue;
+		}
 		
-		size_t length = dst_status->depth + 1;
-		clib_pointer_array_set_length(candidates, length);
-		do {
-			debug_printf("[%d] <== ", (int)vertex->id);
-			assert(vertex->depth >= 0 && vertex->depth < length);
+		// step 3. update min_weight of the previous hops
+		clib_list_iterator_t iter;
+		memset(&iter, 0, sizeof(iter));
+		clib_slist_iter_clear(vertex_edges);
+		
+		while(clib_slist_iter_next(vertex_edges, &iter)) {
+			struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			assert(edge);
+			assert(edge->src_id < edges->num_vertices);
 			
-			candidates->data_ptrs[vertex->depth] = vertex;
+			// the edge must carry current_amount
+			if(check_capacity) {
+				if(edge->capacity < current_amount) break; // all the remaining edges have less capacity
+				if(!dijkstra_sparse_edge_can_forward(edge, current_amount)) continue;
+			}
 			
-			struct clib_pointer_array * parent_candidates = vertex->parent_candidates;
-			assert(parent_candidates->length > 0);
+			const uint32_t id = edge->src_id;
+			if(id == src_id) found = 1;
+			STATS_ADD(dijkstra, edges_scanned, 1);
+			int64_t weight = INT64_MAX;
+			if(dijkstra->calc_weight) {
+				STATS_ADD(dijkstra, callbacks, 1);
+				weight = current_weight + dijkstra->calc_weight(current_amount, edge->user_data);
+			}else {
+				weight = current_weight + edge->weight;
+			}
+			const int64_t min_weight = search_get_dist(state, id);
+			int improved = (weight < min_weight);
+			if(weight <= min_weight) {
+				// a new min_weight, or a next hop with the same min_weight and fewer hops
+				if(improved || next_depth < state->depth[id]) {
+					// the amount the previous hop must send (including the fees of this hop)
+					int64_t amount = 0;
+					if(amounts) {
+						STATS_ADD(dijkstra, callbacks, 1);
+						amount = dijkstra->calc_amount(current_amount, edge->user_data);
+					}
+					// a tie does not re-queue id, its in-edges were checked against the old amount:
+					// switch the next hop only if the amount stays the same
+					if(improved || NULL == amounts || amount == amounts[id]) {
+						search_set_dist(state, id, weight);
+						state->parent[id] = current_id;
+						state->depth[id] = next_depth;
+						if(amounts) amounts[id] = amount;
+					}
+				}
+				STATS_ADD(dijkstra, edges_relaxed, 1);
+				CLIB_PROBE3(dijkstra, edge_relax, current_id, id, weight);
+			}
 			
-			// sort by depth
-			qsort(parent_candidates->data_ptrs, 
-				parent_candidates->length, sizeof(struct dijkstra_vertex_status *), 
-				vertex_status_compare_by_depth);
-			struct dijkstra_vertex_status * parent = parent_candidates->data_ptrs[0];
-			assert(parent->depth == (vertex->depth - 1));
-			vertex = parent;
-		}while(vertex && vertex->id != src_id);
+			// step 4. push the improved vertex into queue (again if it has been visited)
+			if(improved && !(dijkstra_search_state_get_flags(state, id) & DIJKSTRA_VERTEX_QUEUED)) {
+				search_set_flags(state, id, DIJKSTRA_VERTEX_QUEUED);
+				work_queue_push(dijkstra, queue, id);
+			}
+		}
+		search_set_flags(state, current_id, DIJKSTRA_VERTEX_VISITED);
+	}
+	
+	clib_deque_clear(queue, NULL);
+	STATS_PHASE_END(dijkstra, search_ns);
+	
+	// get path: [src_id, ..., dst_id]
+	int64_t min_weight = found?search_get_dist(state, src_id):-1;
+	if(found)
+	{
+		size_t length = search_path_length(state, src_id, dst_id);
+		struct dijkstra_vertex_status ** path = NULL;
+		if(candidates) {
+			clib_pointer_array_clear(candidates, NULL);
+			clib_pointer_array_set_length(candidates, length);
+			path = (struct dijkstra_vertex_status **)candidates->data_ptrs;
+		}
+		export_search_path(dijkstra, src_id, dst_id, path, length);
+		assert(NULL == path || path[length - 1]->id == dst_id);
+	}
+	STATS_PHASE_END(dijkstra, path_ns);
+	clib_metrics_end(s_metrics.shortest_path_reverse, metrics_begin_ns);
+	CLIB_PROBE4(dijkstra, query_end, dijkstra_probe_mode_reverse, src_id, dst_id, min_weight);
+	return min_weight;
+}
+
+/**
+ * function dijkstra_shortest_path_hop_limited(): 
+ *   layered Bellman-Ford over (vertex, hops) labels, 
+ *   finds the cheapest path from src_id to dst_id with at most max_hops edges.
+ * 
+ *   a label (v, h) is only created if it is cheaper than every label of v with fewer hops (dominance),
+ *   and a label is not expanded if it can not be cheaper than the best label of dst_id found so far,
+ *   so the cost is O(max_hops * E) in the worst case, but only the improved vertices are expanded in each layer.
+ * 
+ *   only the vertices on the path have their status (min_weight, amount, depth, parent) filled.
+ *  @return min_weight on success, -1 if no path found within max_hops.
+**/
+struct hop_label
+{
+	uint32_t vertex_id;
+	uint32_t parent;	// index of the parent label, UINT32_MAX for src
+	int64_t weight;
+	int64_t amount;
+};
+
+ssize_t dijkstra_shortest_path_hop_limited(
+	struct dijkstra_context * dijkstra, 
+	uint32_t src_id, uint32_t dst_id, int max_hops,
+	struct clib_pointer_array * candidates)
+{
+	assert(dijkstra && dijkstra->graph);
+	assert(src_id < dijkstra->graph->num_vertices);
+	assert(dst_id < dijkstra->graph->num_vertices);
+	assert(max_hops >= 0);
+	STATS_BEGIN(dijkstra);
+	int64_t metrics_begin_ns = metrics_begin();
+	CLIB_PROBE4(dijkstra, query_start, dijkstra_probe_mode_hop_limited, src_id, dst_id, dijkstra->amount);
+	
+	const struct dijkstra_graph * graph = dijkstra->graph;
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
+	assert(edges->is_sparse_matrix);
+	
+	const size_t num_vertices = graph->num_vertices;
+	
+	// best_weights[v]: min weight of all labels of v created so far (with fewer or equal hops)
+	// layer_slots[v]: index of the label of v in the layer being built (valid if layer_stamps[v] == hops)
+	struct clib_allocator * allocator = dijkstra->allocator;
+	int64_t * best_weights = clib_alloc(allocator, num_vertices * sizeof(*best_weights));
+	uint32_t * layer_slots = clib_alloc(allocator, num_vertices * sizeof(*layer_slots));
+	int * layer_stamps = clib_alloc(allocator, num_vertices * sizeof(*layer_stamps));
+	assert(best_weights && layer_slots && layer_stamps);
+	for(size_t i = 0; i < num_vertices; ++i) {
+		best_weights[i] = DIJKSTRA_WEIGHT_UNSET;
+		layer_stamps[i] = -1;
+	}
+	
+	size_t max_labels = 64;
+	size_t num_labels = 0;
+	struct hop_label * labels = clib_alloc(allocator, max_labels * sizeof(*labels));
+	assert(labels);
+	STATS_ADD(dijkstra, allocations, 4);
+	STATS_PHASE_END(dijkstra, init_ns);
+	
+	// layer 0: src
+	labels[num_labels++] = (struct hop_label){ .vertex_id = src_id, .parent = UINT32_MAX, .weight = 0, .amount = dijkstra->amount };
+	best_weights[src_id] = 0;
+	
+	int64_t dst_weight = (src_id == dst_id)?0:DIJKSTRA_WEIGHT_UNSET;
+	uint32_t dst_label = (src_id == dst_id)?0:UINT32_MAX;
+	
+	const int check_capacity = (dijkstra->amount > 0);
+	size_t layer_begin = 0, layer_end = num_labels;
+	for(int hops = 1; hops <= max_hops && layer_begin < layer_end; ++hops) {
+		for(size_t index = layer_begin; index < layer_end; ++index) {
+			// labels may be relocated by realloc, reload the current label on each iteration
+			const uint32_t current_id = labels[index].vertex_id;
+			if(current_id == dst_id) continue;
+			if(labels[index].weight >= dst_weight) continue; // can not improve dst
+			STATS_ADD(dijkstra, vertices_settled, 1);
+			CLIB_PROBE2(dijkstra, vertex_settle, current_id, labels[index].weight);
+			
+			struct clib_slist * vertex_edges = NULL;
+			ssize_t count = 0;
+			if(check_capacity) count = edges->get_vertex_capacity_edges(edges, current_id, (const struct clib_slist **)&vertex_edges);
+			else count = edges->get_vertex_sparse_edges(edges, current_id, (const struct clib_slist **)&vertex_edges);
+			if(count <= 0) continue;
+			
+			clib_list_iterator_t iter;
+			memset(&iter, 0, sizeof(iter));
+			clib_slist_iter_clear(vertex_edges);
+			while(clib_slist_iter_next(vertex_edges, &iter)) {
+				struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+				assert(edge);
+				assert(edge->dst_id < num_vertices);
+				
+				const int64_t amount = labels[index].amount;
+				if(check_capacity) {
+					if(edge->capacity < amount) break; // all the remaining edges have less capacity
+					if(!dijkstra_sparse_edge_can_forward(edge, amount)) continue;
+				}
+				
+				STATS_ADD(dijkstra, edges_scanned, 1);
+				int64_t weight = labels[index].weight;
+				STATS_ADD(dijkstra, callbacks, (NULL != dijkstra->calc_weight));
+				if(dijkstra->calc_weight) weight += dijkstra->calc_weight(amount, edge->user_data);
+				else weight += edge->weight;
+				
+				// dominated by a label with fewer (or the same) hops, or can not improve dst
+				if(weight >= best_weights[edge->dst_id] || weight >= dst_weight) continue;
+				best_weights[edge->dst_id] = weight;
+				STATS_ADD(dijkstra, edges_relaxed, 1);
+				CLIB_PROBE3(dijkstra, edge_relax, current_id, edge->dst_id, weight);
+				
+				struct hop_label * label = NULL;
+				if(layer_stamps[edge->dst_id] == hops) { // improve the label in the current layer
+					label = &labels[layer_slots[edge->dst_id]];
+				}else {
+					if(num_labels >= max_labels) {
+						max_labels *= 2;
+						labels = clib_realloc(allocator, labels, max_labels * sizeof(*labels));
+						assert(labels);
+						STATS_ADD(dijkstra, allocations, 1);
+					}
+					layer_slots[edge->dst_id] = num_labels;
+					layer_stamps[edge->dst_id] = hops;
+					label = &labels[num_labels++];
+					label->vertex_id = edge->dst_id;
+					STATS_ADD(dijkstra, vertices_enqueued, 1);
+					STATS_MAX(dijkstra, queue_high_water, num_labels);
+				}
+				label->parent = index;
+				label->weight = weight;
+				STATS_ADD(dijkstra, callbacks, (NULL != dijkstra->calc_amount));
+				label->amount = dijkstra->calc_amount?dijkstra->calc_amount(amount, edge->user_data):amount;
+				
+				if(edge->dst_id == dst_id) {
+					dst_weight = weight;
+					dst_label = label - labels;
+				}
+			}
+		}
+		layer_begin = layer_end;
+		layer_end = num_labels;
+	}
+	clib_free(allocator, layer_stamps);
+	clib_free(allocator, layer_slots);
+	clib_free(allocator, best_weights);
+	STATS_PHASE_END(dijkstra, search_ns);
+	
+	// export the path to status_array
+	dijkstra_reset_status_array(dijkstra);
+	int found = (dst_label != UINT32_MAX);
+	if(found) {
+		int depth = 0;
+		for(uint32_t index = dst_label; labels[index].parent != UINT32_MAX; index = labels[index].parent) ++depth;
 		
-		assert(vertex->id == src_id);
-		vertex = &status_array[src_id];
-		debug_printf("[%d]\n", (int)vertex->id);
-		candidates->data_ptrs[0] = vertex;
+		if(candidates) {
+			clib_pointer_array_clear(candidates, NULL);
+			clib_pointer_array_set_length(candidates, depth + 1);
+		}
+		struct dijkstra_vertex_status * status = NULL;
+		for(uint32_t index = dst_label; index != UINT32_MAX; index = labels[index].parent) {
+			const uint32_t parent = labels[index].parent;
+			status = export_vertex_status(dijkstra, labels[index].vertex_id, labels[index].weight, labels[index].amount, 
+				depth, 1, (parent == UINT32_MAX)?UINT32_MAX:labels[parent].vertex_id);
+			if(candidates) candidates->data_ptrs[depth] = status;
+			--depth;
+		}
+		assert(depth == -1 && status->id == src_id);
 	}
-	return found?dst_status->min_weight:-1;
+	clib_free(allocator, labels);
+	STATS_PHASE_END(dijkstra, path_ns);
+	clib_metrics_end(s_metrics.shortest_path_hop_limited, metrics_begin_ns);
+	CLIB_PROBE4(dijkstra, query_end, dijkstra_probe_mode_hop_limited, src_id, dst_id, found?dst_weight:-1);
+	return found?dst_weight:-1;
 }
 
 /************************************
@@ -472,6 +1332,14 @@ ssize_t dijkstra_shortest_path(
 struct dijkstra_context * dijkstra_context_init(struct dijkstra_context * dijkstra, 
 	const struct dijkstra_graph * graph,
 	void * user_data)
+{
+	return dijkstra_context_init_ex(dijkstra, graph, user_data, NULL);
+}
+
+struct dijkstra_context * dijkstra_context_init_ex(struct dijkstra_context * dijkstra, 
+	const struct dijkstra_graph * graph,
+	void * user_data,
+	struct clib_allocator * allocator)
 {
 	assert(graph);
 	//~ assert(graph->vertices);
@@ -484,7 +1352,14 @@ struct dijkstra_context * dijkstra_context_init(struct dijkstra_context * dijkst
 	
 	dijkstra->graph = graph;
 	dijkstra->user_data = user_data;
+	dijkstra->allocator = allocator;
+	
+	// the working queue is reused across searches, so it always comes from libc
+	clib_deque_init(dijkstra->work_queue, graph->num_vertices);
+	clib_u32_vec_init(dijkstra->search->exported, allocator);
 	dijkstra->shortest_path = dijkstra_shortest_path;
+	dijkstra->shortest_path_reverse = dijkstra_shortest_path_reverse;
+	dijkstra->shortest_path_hop_limited = dijkstra_shortest_path_hop_limited;
 	
 	
 	return dijkstra;
@@ -494,9 +1369,40 @@ void dijkstra_context_cleanup(struct dijkstra_context * dijkstra)
 {
 	if(NULL == dijkstra) return;
 	dijkstra_clear_status_array(dijkstra);
+	clib_deque_cleanup(dijkstra->work_queue, NULL);
 	return;
 }
 
+size_t dijkstra_context_memory_usage(const struct dijkstra_context * dijkstra, struct dijkstra_context_memory_usage * usage)
+{
+	assert(dijkstra && dijkstra->graph);
+	struct dijkstra_context_memory_usage local_usage;
+	if(NULL == usage) usage = &local_usage;
+	memset(usage, 0, sizeof(*usage));
+	
+	if(dijkstra->status_array) {
+		usage->status_array = dijkstra->graph->num_vertices * sizeof(*dijkstra->status_array);
+		for(size_t i = 0; i < dijkstra->graph->num_vertices; ++i) {
+			const struct clib_u32_vec * vec = dijkstra->status_array[i].parent_candidates;
+			if(vec->capacity > CLIB_VECTOR_INLINE_COUNT(uint32_t)) usage->parent_candidates += vec->capacity * sizeof(uint32_t);
+		}
+	}
+	
+	const struct dijkstra_search_state * state = dijkstra->search;
+	const size_t num_vertices = state->num_vertices;
+	if(state->dist64) usage->search_state += num_vertices * sizeof(*state->dist64);
+	if(state->dist32) usage->search_state += num_vertices * sizeof(*state->dist32);
+	if(state->parent) usage->search_state += num_vertices * sizeof(*state->parent);
+	if(state->depth) usage->search_state += num_vertices * sizeof(*state->depth);
+	if(state->amount) usage->search_state += num_vertices * sizeof(*state->amount);
+	if(state->flags) usage->search_state += (num_vertices + 31) / 32 * sizeof(*state->flags);
+	if(state->exported->capacity > CLIB_VECTOR_INLINE_COUNT(uint32_t)) usage->search_state += state->exported->capacity * sizeof(uint32_t);
+	
+	usage->work_queue = dijkstra->work_queue->size * sizeof(void *);
+	usage->total = usage->status_array + usage->parent_candidates + usage->search_state + usage->work_queue;
+	return usage->total;
+}
+
 
 /****************************************************
  * TEST_MODULE::dijkstra-shortest-path
@@ -520,22 +1426,12 @@ static int64_t s_edges[NUM_VERTEXES][NUM_VERTEXES] = {
 	{-1,  -1,   2,  -1,  -1,  -1,   6, 	 7,  -1}	// 8
 };
 
-static void print_edge(const void * p_node, VISIT which, int depth)
+static void sparse_edges_dump(struct dijkstra_edges * edges)
 {
-	const struct dijkstra_sparse_edge * edge;
-	switch(which) {
-	case preorder: case endorder: break;
-	case postorder: case leaf:
-		edge = *(struct dijkstra_sparse_edge **)p_node;
+	for(size_t i = 0; i < edges->edge_index->count; ++i) {
+		const struct dijkstra_sparse_edge * edge = clib_hashmap_value_at(edges->edge_index, i);
 		printf("edge[%u -> %u]: weight=%ld\n", edge->src_id, edge->dst_id, (long)edge->weight);
-		break;
 	}
-	return;
-}
-
-static void sparse_edges_dump(struct dijkstra_edges * edges)
-{
-	twalk(edges->search_root, print_edge);
 }
 
 static void sparse_edges_list_dump(struct dijkstra_edges * edges)
@@ -565,6 +1461,71 @@ static void sparse_edges_list_dump(struct dijkstra_edges * edges)
 	
 }
 
+static void path_dump(const struct clib_pointer_array * path)
+{
+	printf("==== path: hops=%d ====\n", (int)(path->length - 1));
+	for(size_t i = 0; i < path->length; ++i) {
+		const struct dijkstra_vertex_status * status = path->data_ptrs[i];
+		assert(status);
+		if(i == 0) printf("\e[34mvertices[%d](min_weight=%d)\e[39m", (int)status->id, (int)status->min_weight);
+		else printf("vertices[%d](min_weight=%d)", (int)status->id, (int)status->min_weight);
+		if(i < (path->length - 1)) printf(" ==> ");
+	}
+	printf("\n");
+}
+
+/*
+ * the path is made of existing edges, its weight is min_weight, 
+ * and each vertex exports exactly one parent (the previous hop, or the next hop for the reverse search)
+ * with the weight from src_id (to dst_id for the reverse search)
+ */
+static void path_check(struct dijkstra_edges * edges, const struct clib_pointer_array * path, 
+	uint32_t src_id, uint32_t dst_id, int64_t min_weight, int reverse)
+{
+	const struct dijkstra_vertex_status ** vertices = (const struct dijkstra_vertex_status **)path->data_ptrs;
+	assert(path->length > 0);
+	assert(vertices[0]->id == src_id && vertices[path->length - 1]->id == dst_id);
+	int64_t weight = 0;
+	for(size_t i = 0; i < path->length; ++i) {
+		const struct dijkstra_vertex_status * status = vertices[i];
+		if(i > 0) weight += edges->get_weight(edges, vertices[i - 1]->id, status->id);
+		int64_t expected = reverse?(min_weight - weight):weight;
+		assert(status->min_weight == expected);
+		
+		const struct dijkstra_vertex_status * parent = NULL;
+		if(reverse) parent = (i + 1 < path->length)?vertices[i + 1]:NULL;
+		else parent = (i > 0)?vertices[i - 1]:NULL;
+		assert(status->parent_candidates->length == (parent?1:0));
+		assert(NULL == parent || *clib_u32_vec_at(status->parent_candidates, 0) == parent->id);
+	}
+	assert(weight == min_weight);
+}
+
+// amount + fee, the fee of each edge is kept in edge->user_data
+static int64_t fee_calc_amount(int64_t amount, void * user_data)
+{
+	return amount + (intptr_t)user_data;
+}
+
+/*
+ * each hop forwards the amount of its upstream vertex: 
+ * status->amount == calc_amount(upstream amount) and the edge can carry the upstream amount
+ */
+static void path_amount_check(struct dijkstra_edges * edges, const struct clib_pointer_array * path, int reverse)
+{
+	const struct dijkstra_vertex_status ** vertices = (const struct dijkstra_vertex_status **)path->data_ptrs;
+	for(size_t i = 1; i < path->length; ++i) {
+		const struct dijkstra_vertex_status * prev = vertices[i - 1];
+		const struct dijkstra_vertex_status * next = vertices[i];
+		const struct dijkstra_sparse_edge * edge = edges->find(edges, prev->id, next->id);
+		assert(edge);
+		const struct dijkstra_vertex_status * upstream = reverse?next:prev;
+		const struct dijkstra_vertex_status * downstream = reverse?prev:next;
+		assert(downstream->amount == fee_calc_amount(upstream->amount, edge->user_data));
+		assert(edge->capacity >= upstream->amount);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	uint32_t src_id = 0;
@@ -610,16 +1571,7 @@ int main(int argc, char **argv)
 	printf("min_weight: %ld\n", (long)min_weight);
 	
 	// print path
-	
-	printf("==== path: hops=%d ====\n", (int)(first_candidates->length - 1));
-	for(size_t i = 0; i < first_candidates->length; ++i) {
-		const struct dijkstra_vertex_status * status = first_candidates->data_ptrs[i];
-		assert(status);
-		if(i == 0) printf("\e[34mvertices[%d](min_weight=%d)\e[39m", (int)status->id, (int)status->min_weight);
-		else printf("vertices[%d](min_weight=%d)", (int)status->id, (int)status->min_weight);
-		if(i < (first_candidates->length - 1)) printf(" ==> ");
-	}
-	printf("\n");
+	path_dump(first_candidates);
 	
 	clib_pointer_array_clear(first_candidates, NULL);
 	
@@ -628,16 +1580,319 @@ int main(int argc, char **argv)
 	printf("min_weight: %ld\n", (long)min_weight);
 	
 	// print path
+	path_dump(first_candidates);
 	
-	printf("==== path: hops=%d ====\n", (int)(first_candidates->length - 1));
-	for(size_t i = 0; i < first_candidates->length; ++i) {
+	/// reverse search, (the sample graph is symmetric, so the min_weight should be the same)
+	int64_t forward_weight = min_weight;
+	clib_pointer_array_clear(first_candidates, NULL);
+	min_weight = dijkstra->shortest_path_reverse(dijkstra, src_id, dst_id, first_candidates);
+	printf("min_weight(reverse): %ld\n", (long)min_weight);
+	path_dump(first_candidates);
+	assert(min_weight == forward_weight);
+
+	/// hop-limited search: without a real limit it must agree with the forward search
+	for(uint32_t i = 0; i < NUM_VERTEXES; ++i) {
+		for(uint32_t j = 0; j < NUM_VERTEXES; ++j) {
+			int64_t expected = dijkstra_shortest_path(dijkstra, i, j, NULL);
+			min_weight = dijkstra->shortest_path_hop_limited(dijkstra, i, j, NUM_VERTEXES - 1, NULL);
+			assert(min_weight == expected);
+		}
+	}
+	// [7 -> 6 -> 5 -> 2 -> 3] = 14 (4 hops), [7 -> 6 -> 3] = 15 (2 hops)
+	clib_pointer_array_clear(first_candidates, NULL);
+	min_weight = dijkstra->shortest_path_hop_limited(dijkstra, 7, 3, 4, first_candidates);
+	assert(min_weight == 14 && first_candidates->length == 5);
+	clib_pointer_array_clear(first_candidates, NULL);
+	min_weight = dijkstra->shortest_path_hop_limited(dijkstra, 7, 3, 3, first_candidates);
+	printf("min_weight(max_hops=3): %ld\n", (long)min_weight);
+	path_dump(first_candidates);
+	assert(min_weight == 15 && first_candidates->length == 3);
+	// no path from [0] to [4] within 3 hops
+	assert(dijkstra->shortest_path_hop_limited(dijkstra, 0, 4, 3, NULL) == -1);
+	assert(dijkstra->shortest_path_hop_limited(dijkstra, 0, 4, 4, NULL) == 21);
+
+	/// FIFO label-correcting: a vertex is queued again whenever its weight improves, even after it has been visited,
+	/// and the parent of the first (worse) weight is dropped.
+	// [0 -> 2] = 10 is found first, [0 -> 1 -> 3 -> 2] = 3 improves [2] after it has been visited
+	{
+		struct dijkstra_edges fifo_edges[1];
+		dijkstra_edges_init(fifo_edges, 1, 5);
+		fifo_edges->update(fifo_edges, 0, 1, 1);
+		fifo_edges->update(fifo_edges, 0, 2, 10);
+		fifo_edges->update(fifo_edges, 1, 3, 1);
+		fifo_edges->update(fifo_edges, 3, 2, 1);
+		fifo_edges->update(fifo_edges, 2, 4, 1);
+		struct dijkstra_graph fifo_graph[1] = {{ .num_vertices = 5, .edges = fifo_edges }};
+		struct dijkstra_context fifo_dijkstra[1];
+		dijkstra_context_init(fifo_dijkstra, fifo_graph, NULL);
+		
+		clib_pointer_array_clear(first_candidates, NULL);
+		min_weight = fifo_dijkstra->shortest_path(fifo_dijkstra, 0, 4, first_candidates);
+		path_dump(first_candidates);
+		assert(min_weight == 4 && first_candidates->length == 5);
+		path_check(fifo_edges, first_candidates, 0, 4, min_weight, 0);
+		
+		clib_pointer_array_clear(first_candidates, NULL);
+		min_weight = fifo_dijkstra->shortest_path_reverse(fifo_dijkstra, 0, 4, first_candidates);
+		assert(min_weight == 4 && first_candidates->length == 5);
+		path_check(fifo_edges, first_candidates, 0, 4, min_weight, 1);
+		
+		// equal weights: the path with fewer hops is exported, [0 -> 2 -> 4] = [0 -> 1 -> 3 -> 2 -> 4] = 4
+		fifo_edges->update(fifo_edges, 0, 2, 3);
+		clib_pointer_array_clear(first_candidates, NULL);
+		min_weight = fifo_dijkstra->shortest_path(fifo_dijkstra, 0, 4, first_candidates);
+		assert(min_weight == 4 && first_candidates->length == 3);
+		path_check(fifo_edges, first_candidates, 0, 4, min_weight, 0);
+		
+		dijkstra_context_cleanup(fifo_dijkstra);
+		dijkstra_edges_cleanup(fifo_edges);
+	}
+	
+	// an equal-weight tie with fewer hops must not change the amount of a visited vertex:
+	//   [3] is visited with the amount of [0 -> 1 -> 2 -> 3] (100), and [3 -> 5] (capacity 105) is relaxed with it,
+	//   then [0 -> 4 -> 3] ties with fewer hops but adds a fee of 10, the parent of [3] is kept.
+	// the reverse search runs on the mirrored graph.
+	for(int reverse = 0; reverse < 2; ++reverse) {
+		static const struct { uint32_t src_id, dst_id; int64_t weight, capacity, fee; } s_tie_edges[] = {
+			{ 0, 1, 1, 1000, 0 }, { 0, 2, 3, 900, 0 }, { 0, 3, 50, 800, 0 }, { 0, 4, 10, 700, 0 },
+			{ 1, 2, 1, DIJKSTRA_CAPACITY_UNLIMITED, 0 }, { 2, 3, 8, DIJKSTRA_CAPACITY_UNLIMITED, 0 }, 
+			{ 4, 3, 0, DIJKSTRA_CAPACITY_UNLIMITED, 10 }, { 3, 5, 1, 105, 0 },
+		};
+		struct dijkstra_edges tie_edges[1];
+		dijkstra_edges_init(tie_edges, 1, 6);
+		for(size_t i = 0; i < sizeof(s_tie_edges) / sizeof(s_tie_edges[0]); ++i) {
+			uint32_t a = s_tie_edges[i].src_id, b = s_tie_edges[i].dst_id;
+			if(reverse) { a = s_tie_edges[i].dst_id; b = s_tie_edges[i].src_id; }
+			struct dijkstra_sparse_edge * edge = tie_edges->update(tie_edges, a, b, s_tie_edges[i].weight);
+			edge->user_data = (void *)(intptr_t)s_tie_edges[i].fee;
+			tie_edges->set_capacity(tie_edges, a, b, s_tie_edges[i].capacity, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+		}
+		struct dijkstra_graph tie_graph[1] = {{ .num_vertices = 6, .edges = tie_edges }};
+		struct dijkstra_context tie_dijkstra[1];
+		dijkstra_context_init(tie_dijkstra, tie_graph, NULL);
+		tie_dijkstra->amount = 100;
+		tie_dijkstra->calc_amount = fee_calc_amount;
+		
+		clib_pointer_array_clear(first_candidates, NULL);
+		if(reverse) min_weight = tie_dijkstra->shortest_path_reverse(tie_dijkstra, 5, 0, first_candidates);
+		else min_weight = tie_dijkstra->shortest_path(tie_dijkstra, 0, 5, first_candidates);
+		path_dump(first_candidates);
+		assert(min_weight == 11 && first_candidates->length == 5);	// [0 -> 1 -> 2 -> 3 -> 5]
+		path_check(tie_edges, first_candidates, reverse?5:0, reverse?0:5, min_weight, reverse);
+		path_amount_check(tie_edges, first_candidates, reverse);
+		
+		dijkstra_context_cleanup(tie_dijkstra);
+		dijkstra_edges_cleanup(tie_edges);
+	}
+	
+	// larger random graphs: the same weights as the hop-limited engine (without a real limit), valid exported paths
+	{
+		const uint32_t num_vertices = 10000;
+		srand(2024);
+		struct dijkstra_edges fifo_edges[1];
+		dijkstra_edges_init(fifo_edges, 1, num_vertices);
+		for(uint32_t i = 0; i < num_vertices * 4; ++i) {
+			uint32_t a = rand() % num_vertices, b = rand() % num_vertices;
+			if(a != b) fifo_edges->update(fifo_edges, a, b, rand() % 50);	// with zero weights
+		}
+		struct dijkstra_graph fifo_graph[1] = {{ .num_vertices = num_vertices, .edges = fifo_edges }};
+		struct dijkstra_context fifo_dijkstra[1];
+		dijkstra_context_init(fifo_dijkstra, fifo_graph, NULL);
+		for(int query = 0; query < 20; ++query) {
+			uint32_t a = rand() % num_vertices, b = rand() % num_vertices;
+			int64_t expected = fifo_dijkstra->shortest_path_hop_limited(fifo_dijkstra, a, b, num_vertices - 1, NULL);
+			clib_pointer_array_clear(first_candidates, NULL);
+			min_weight = fifo_dijkstra->shortest_path(fifo_dijkstra, a, b, first_candidates);
+			assert(min_weight == expected);
+			if(min_weight >= 0) path_check(fifo_edges, first_candidates, a, b, min_weight, 0);
+			clib_pointer_array_clear(first_candidates, NULL);
+			min_weight = fifo_dijkstra->shortest_path_reverse(fifo_dijkstra, a, b, first_candidates);
+			assert(min_weight == expected);
+			if(min_weight >= 0) path_check(fifo_edges, first_candidates, a, b, min_weight, 1);
+		}
+		dijkstra_context_cleanup(fifo_dijkstra);
+		dijkstra_edges_cleanup(fifo_edges);
+	}
+
+	/// random graphs (with zero weights): a vertex may be improved after it has been visited
+	for(unsigned int seed = 1; seed <= 20; ++seed) {
+		srand(seed);
+		struct dijkstra_edges random_edges[1];
+		dijkstra_edges_init(random_edges, 1, 40);
+		for(uint32_t i = 0; i < 40; ++i) {
+			for(uint32_t j = 0; j < 40; ++j) {
+				if(i != j && (rand() % 8) == 0) random_edges->update(random_edges, i, j, rand() % 30);
+			}
+		}
+		struct dijkstra_graph random_graph[1] = {{ .num_vertices = 40, .edges = random_edges }};
+		struct dijkstra_context random_dijkstra[1];
+		dijkstra_context_init(random_dijkstra, random_graph, NULL);
+		for(uint32_t j = 0; j < 40; ++j) {
+			int64_t expected = random_dijkstra->shortest_path_hop_limited(random_dijkstra, 0, j, 39, NULL);
+			clib_pointer_array_clear(first_candidates, NULL);
+			assert(random_dijkstra->shortest_path(random_dijkstra, 0, j, first_candidates) == expected);
+			assert(expected < 0 || ((const struct dijkstra_vertex_status *)first_candidates->data_ptrs[0])->id == 0);
+			assert(random_dijkstra->shortest_path_reverse(random_dijkstra, 0, j, NULL) == expected);
+		}
+		dijkstra_context_cleanup(random_dijkstra);
+		dijkstra_edges_cleanup(random_edges);
+	}
+
+	/// compact search state: 32-bit distances when the weights fit, the results do not depend on the width
+	struct dijkstra_context wide_dijkstra[1];
+	dijkstra_context_init(wide_dijkstra, graph, NULL);
+	wide_dijkstra->distance_bits = 64;
+	for(uint32_t i = 0; i < NUM_VERTEXES; ++i) {
+		for(uint32_t j = 0; j < NUM_VERTEXES; ++j) {
+			clib_pointer_array_clear(first_candidates, NULL);
+			min_weight = dijkstra->shortest_path(dijkstra, i, j, first_candidates);
+			assert(dijkstra->search->distance_bits == 32);
+			assert(wide_dijkstra->shortest_path_reverse(wide_dijkstra, i, j, NULL) == min_weight);
+			assert(wide_dijkstra->search->distance_bits == 64);
+			
+			// only the vertices on the path are exported to status_array
+			size_t exported = 0;
+			for(uint32_t k = 0; k < NUM_VERTEXES; ++k) exported += (dijkstra->status_array[k].min_weight != DIJKSTRA_WEIGHT_UNSET);
+			assert(exported == first_candidates->length);
+		}
+	}
+	dijkstra_context_cleanup(wide_dijkstra);
+	
+	// the path weights do not fit in 32 bits
+	struct dijkstra_edges heavy_edges[1];
+	dijkstra_edges_init(heavy_edges, 1, 3);
+	heavy_edges->update(heavy_edges, 0, 1, 3000000000LL);
+	heavy_edges->update(heavy_edges, 1, 2, 1);
+	struct dijkstra_graph heavy_graph[1] = {{ .num_vertices = 3, .edges = heavy_edges }};
+	struct dijkstra_context heavy_dijkstra[1];
+	dijkstra_context_init(heavy_dijkstra, heavy_graph, NULL);
+	assert(heavy_dijkstra->shortest_path(heavy_dijkstra, 0, 2, NULL) == 3000000001LL);
+	assert(heavy_dijkstra->search->distance_bits == 64);
+	assert(heavy_dijkstra->status_array[2].min_weight == 3000000001LL && heavy_dijkstra->status_array[2].depth == 2);
+	dijkstra_context_cleanup(heavy_dijkstra);
+	dijkstra_edges_cleanup(heavy_edges);
+
+	/// limit the capacity of edges [7 -> 6] and [6 -> 7], 
+	/// then an amount larger than the capacity should be routed through other edges
+	edges->set_capacity(edges, 7, 6, 1000, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->set_capacity(edges, 6, 7, 1000, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	sparse_edges_list_dump(edges);
+	
+	dijkstra->amount = 10000;
+	clib_pointer_array_clear(first_candidates, NULL);
+	min_weight = dijkstra_shortest_path(dijkstra, src_id, dst_id, first_candidates);
+	printf("min_weight(amount=%ld): %ld\n", (long)dijkstra->amount, (long)min_weight);
+	path_dump(first_candidates);
+	for(size_t i = 1; i < first_candidates->length; ++i) {
+		const struct dijkstra_vertex_status * prev = first_candidates->data_ptrs[i - 1];
 		const struct dijkstra_vertex_status * status = first_candidates->data_ptrs[i];
-		assert(status);
-		if(i == 0) printf("\e[34mvertices[%d](min_weight=%d)\e[39m", (int)status->id, (int)status->min_weight);
-		else printf("vertices[%d](min_weight=%d)", (int)status->id, (int)status->min_weight);
-		if(i < (first_candidates->length - 1)) printf(" ==> ");
+		assert(!(prev->id == 7 && status->id == 6));
+		assert(!(prev->id == 6 && status->id == 7));
 	}
-	printf("\n");
+	
+#ifdef DIJKSTRA_ENABLE_STATS
+	/// per-query counters
+	dijkstra->amount = 0;
+	assert(dijkstra->shortest_path(dijkstra, 7, 3, NULL) == 14);
+	const struct dijkstra_query_stats * stats = &dijkstra->stats;
+	printf("stats: settled=%lu, enqueued=%lu, scanned=%lu, relaxed=%lu, high_water=%lu, "
+		"callbacks=%lu, allocations=%lu, init=%ldns, search=%ldns, path=%ldns\n",
+		(unsigned long)stats->vertices_settled, (unsigned long)stats->vertices_enqueued, 
+		(unsigned long)stats->edges_scanned, (unsigned long)stats->edges_relaxed, 
+		(unsigned long)stats->queue_high_water, (unsigned long)stats->callbacks, (unsigned long)stats->allocations,
+		(long)stats->init_ns, (long)stats->search_ns, (long)stats->path_ns);
+	assert(stats->vertices_settled > 0 && stats->vertices_settled <= stats->vertices_enqueued);
+	assert(stats->edges_relaxed > 0 && stats->edges_relaxed <= stats->edges_scanned);
+	assert(stats->queue_high_water > 0 && stats->queue_high_water <= NUM_VERTEXES);
+	assert(stats->callbacks == 0);
+	assert(stats->allocations == 0);	// the search state and status_array are reused across searches
+	assert(stats->init_ns >= 0 && stats->search_ns > 0 && stats->path_ns >= 0);
+	
+	// the counters are reset by each search
+	uint64_t edges_scanned = stats->edges_scanned;
+	assert(dijkstra->shortest_path(dijkstra, 7, 3, NULL) == 14);
+	assert(stats->edges_scanned == edges_scanned);
+	assert(dijkstra->shortest_path_hop_limited(dijkstra, 7, 3, 3, NULL) == 15);
+	assert(stats->vertices_settled > 0 && stats->edges_scanned > 0 && stats->allocations >= 4);
+	assert(dijkstra->shortest_path_reverse(dijkstra, 7, 3, NULL) == 14);
+	assert(stats->vertices_settled > 0 && stats->edges_relaxed > 0);
+#endif
+	
+	/// process-wide metrics
+	clib_metrics_enable(1);
+	dijkstra->amount = 0;
+	assert(dijkstra->shortest_path(dijkstra, 7, 3, NULL) == 14);
+	assert(dijkstra->shortest_path(dijkstra, 3, 7, NULL) == 14);
+	edges->remove(edges, 7, 8);
+	edges->update(edges, 7, 8, 7);
+	edges->update(edges, 7, 8, 7);
+	assert(NULL == edges->remove(edges, 0, 5));	// no such edge
+	struct clib_histogram_summary summary;
+	clib_metrics_histogram_summary(clib_metrics_find("dijkstra_shortest_path_seconds"), &summary);
+	assert(summary.count == 2 && summary.min > 0 && summary.min <= summary.p50 && summary.p50 <= summary.max);
+	clib_metrics_histogram_summary(clib_metrics_find("dijkstra_edges_remove_seconds"), &summary);
+	assert(summary.count == 2);
+	assert(clib_metrics_counter_value(clib_metrics_find("dijkstra_edges_inserted_total")) == 1);
+	assert(clib_metrics_counter_value(clib_metrics_find("dijkstra_edges_updated_total")) == 1);
+	assert(clib_metrics_counter_value(clib_metrics_find("dijkstra_edges_removed_total")) == 1);
+	clib_metrics_dump(stdout, CLIB_METRICS_FORMAT_PROMETHEUS);
+	clib_metrics_enable(0);
+	
+	/// memory accounting, checked against the live allocations
+	struct clib_tracking_allocator tracker[1];
+	clib_tracking_allocator_init(tracker, NULL);
+	struct dijkstra_edges tracked_edges[1];
+	dijkstra_edges_init_ex(tracked_edges, 1, NUM_VERTEXES, tracker->base);
+	for(uint32_t i = 0; i < NUM_VERTEXES; ++i) {
+		for(uint32_t j = 0; j < NUM_VERTEXES; ++j) {
+			if(s_edges[i][j] > 0) tracked_edges->update(tracked_edges, i, j, s_edges[i][j]);
+		}
+	}
+	// the removed edge stays readable (and pooled) until the next update() / remove()
+	const struct dijkstra_sparse_edge * removed = tracked_edges->remove(tracked_edges, 7, 8);
+	assert(removed && removed == tracked_edges->removed_edge);
+	assert(removed->src_id == 7 && removed->dst_id == 8 && removed->weight == s_edges[7][8]);
+	assert(NULL == tracked_edges->find(tracked_edges, 7, 8));
+	struct dijkstra_edges_memory_usage edges_usage;
+	dijkstra_edges_memory_usage(tracked_edges, &edges_usage);
+	printf("edges memory: edges=%zu (%zu in use), edge_index=%zu, vertex_arrays=%zu, vertex_lists=%zu (%zu lists), "
+		"list_nodes=%zu, vertex_versions=%zu, total=%zu, tracked=%zu\n",
+		edges_usage.edges, edges_usage.num_edges, edges_usage.edge_index, edges_usage.vertex_arrays, 
+		edges_usage.vertex_lists, edges_usage.num_lists, edges_usage.list_nodes, edges_usage.vertex_versions, 
+		edges_usage.total, tracker->live_bytes);
+	assert(edges_usage.total == tracker->live_bytes);
+	assert(edges_usage.num_lists == 3 * NUM_VERTEXES);
+	
+	size_t edges_bytes = tracker->live_bytes;
+	struct dijkstra_graph tracked_graph[1] = {{ .num_vertices = NUM_VERTEXES, .vertices = vertices, .edges = tracked_edges }};
+	struct dijkstra_context tracked_dijkstra[1];
+	dijkstra_context_init_ex(tracked_dijkstra, tracked_graph, NULL, tracker->base);
+	assert(tracked_dijkstra->shortest_path(tracked_dijkstra, 7, 3, NULL) >= 14);
+	struct dijkstra_context_memory_usage context_usage;
+	dijkstra_context_memory_usage(tracked_dijkstra, &context_usage);
+	printf("context memory: status_array=%zu, parent_candidates=%zu, search_state=%zu, work_queue=%zu, total=%zu\n",
+		context_usage.status_array, context_usage.parent_candidates, context_usage.search_state, 
+		context_usage.work_queue, context_usage.total);
+	assert(context_usage.status_array + context_usage.parent_candidates + context_usage.search_state 
+		== tracker->live_bytes - edges_bytes);
+	dijkstra_context_cleanup(tracked_dijkstra);
+	dijkstra_edges_cleanup(tracked_edges);
+	assert(tracker->live_bytes == 0 && tracker->live_blocks == 0);
+	
+	/// per-query arena
+	struct clib_arena arena[1];
+	clib_arena_init(arena, 0);
+	struct dijkstra_context arena_dijkstra[1];
+	dijkstra_context_init_ex(arena_dijkstra, graph, NULL, arena->base);
+	for(int i = 0; i < 3; ++i) {
+		assert(arena_dijkstra->shortest_path(arena_dijkstra, 7, 3, NULL) == 14);
+		assert(arena_dijkstra->shortest_path_hop_limited(arena_dijkstra, 7, 3, 3, NULL) == 15);
+		printf("arena query[%d]: used_bytes=%zu, total_bytes=%zu\n", i, arena->used_bytes, arena->total_bytes);
+		dijkstra_clear_status_array(arena_dijkstra);
+		clib_arena_reset(arena);
+	}
+	dijkstra_context_cleanup(arena_dijkstra);
+	clib_arena_cleanup(arena);
 	
 	clib_pointer_array_cleanup(first_candidates, NULL);	
 	dijkstra_edges_cleanup(edges);
@@ -0,0 +1,897 @@
+/*
+ * max-flow.c
+ *
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <stdint.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "max-flow.h"
+
+/************************************
+ * flow network
+ *   arcs of a vertex are stored contiguously (CSR), each edge has a reverse arc.
+ *   an extra super source (id = graph->num_vertices) feeds src_id through a single arc
+ *   whose capacity is an upper bound of the max-flow, this keeps all the excesses in int64.
+************************************/
+struct flow_arc
+{
+	uint32_t dst_id;
+	uint32_t rev;		// index of the reverse arc
+	int64_t capacity;	// residual capacity
+};
+
+struct flow_network
+{
+	uint32_t num_vertices;	// graph->num_vertices + 1
+	uint32_t src_id;		// the super source
+	uint32_t dst_id;
+
+	size_t num_arcs;
+	size_t * first_arcs;	// [num_vertices + 1]
+	struct flow_arc * arcs;
+	const struct dijkstra_sparse_edge ** arc_edges;	// NULL for the reverse arcs and the super source arc
+
+	int64_t * excess;
+	uint32_t * labels;
+	uint32_t * queue;	// bfs queue
+};
+
+static inline int64_t saturating_add(int64_t a, int64_t b)
+{
+	return (a > INT64_MAX - b)?INT64_MAX:(a + b);
+}
+
+static int64_t get_default_capacity(const struct dijkstra_sparse_edge * edge, void * user_data)
+{
+	return edge->capacity;
+}
+
+static void flow_network_free(struct flow_network * network)
+{
+	if(NULL == network) return;
+	free(network->first_arcs);
+	free(network->arcs);
+	free(network->arc_edges);
+	free(network->excess);
+	free(network->labels);
+	free(network->queue);
+	free(network);
+}
+
+static struct flow_network * flow_network_new(struct max_flow_context * ctx, uint32_t src_id, uint32_t dst_id)
+{
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)ctx->graph->edges;
+	assert(edges && edges->is_sparse_matrix);
+	const uint32_t num_vertices = ctx->graph->num_vertices;
+
+	struct flow_network * network = calloc(1, sizeof(*network));
+	assert(network);
+	network->num_vertices = num_vertices + 1;
+	network->src_id = num_vertices;
+	network->dst_id = dst_id;
+	network->first_arcs = calloc(num_vertices + 2, sizeof(*network->first_arcs));
+	assert(network->first_arcs);
+
+	clib_list_iterator_t iter;
+	int64_t src_capacity = 0;
+	int64_t dst_capacity = 0;
+
+	// step 1. count arcs
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		const struct clib_slist * list = NULL;
+		ssize_t count = edges->get_vertex_sparse_edges(edges, i, &list);
+		if(count <= 0) continue;
+
+		memset(&iter, 0, sizeof(iter));
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			assert(edge->dst_id < num_vertices);
+			int64_t capacity = ctx->get_capacity(edge, ctx->user_data);
+			if(capacity <= 0 || edge->dst_id == i) continue;
+
+			++network->first_arcs[i + 1];
+			++network->first_arcs[edge->dst_id + 1];
+			if(i == src_id) src_capacity = saturating_add(src_capacity, capacity);
+			if(edge->dst_id == dst_id) dst_capacity = saturating_add(dst_capacity, capacity);
+		}
+	}
+	++network->first_arcs[network->src_id + 1];	// super source ==> src
+	++network->first_arcs[src_id + 1];
+	for(uint32_t i = 0; i < network->num_vertices; ++i) network->first_arcs[i + 1] += network->first_arcs[i];
+	network->num_arcs = network->first_arcs[network->num_vertices];
+
+	// step 2. fill arcs
+	network->arcs = calloc(network->num_arcs, sizeof(*network->arcs));
+	network->arc_edges = calloc(network->num_arcs, sizeof(*network->arc_edges));
+	size_t * next_arcs = calloc(network->num_vertices, sizeof(*next_arcs));
+	assert(network->arcs && network->arc_edges && next_arcs);
+	memcpy(next_arcs, network->first_arcs, network->num_vertices * sizeof(*next_arcs));
+
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		const struct clib_slist * list = NULL;
+		ssize_t count = edges->get_vertex_sparse_edges(edges, i, &list);
+		if(count <= 0) continue;
+
+		memset(&iter, 0, sizeof(iter));
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			int64_t capacity = ctx->get_capacity(edge, ctx->user_data);
+			if(capacity <= 0 || edge->dst_id == i) continue;
+
+			size_t fwd = next_arcs[i]++;
+			size_t rev = next_arcs[edge->dst_id]++;
+			network->arcs[fwd] = (struct flow_arc){ .dst_id = edge->dst_id, .rev = rev, .capacity = capacity };
+			network->arcs[rev] = (struct flow_arc){ .dst_id = i, .rev = fwd, .capacity = 0 };
+			network->arc_edges[fwd] = edge;
+		}
+	}
+
+	// the max-flow can not exceed min(out-capacity of src, in-capacity of dst)
+	int64_t bound = (src_capacity < dst_capacity)?src_capacity:dst_capacity;
+	size_t fwd = next_arcs[network->src_id]++;
+	size_t rev = next_arcs[src_id]++;
+	network->arcs[fwd] = (struct flow_arc){ .dst_id = src_id, .rev = rev, .capacity = bound };
+	network->arcs[rev] = (struct flow_arc){ .dst_id = network->src_id, .rev = fwd, .capacity = 0 };
+	free(next_arcs);
+
+	network->excess = calloc(network->num_vertices, sizeof(*network->excess));
+	network->labels = calloc(network->num_vertices, sizeof(*network->labels));
+	network->queue = calloc(network->num_vertices, sizeof(*network->queue));
+	assert(network->excess && network->labels && network->queue);
+	return network;
+}
+
+/* saturate the super source arc */
+static void flow_network_init_preflow(struct flow_network * network)
+{
+	uint32_t s = network->src_id;
+	for(size_t a = network->first_arcs[s]; a < network->first_arcs[s + 1]; ++a) {
+		struct flow_arc * arc = &network->arcs[a];
+		int64_t delta = arc->capacity;
+		arc->capacity = 0;
+		network->arcs[arc->rev].capacity += delta;
+		network->excess[arc->dst_id] += delta;
+		network->excess[s] -= delta;
+	}
+}
+
+/**
+ * function global_relabel():
+ *   sets labels to the exact distances to dst in the residual network (backward bfs),
+ *   vertices which can not reach dst get num_vertices.
+ *  @return the number of vertices reached
+**/
+static uint32_t global_relabel(struct flow_network * network)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	uint32_t * labels = network->labels;
+	uint32_t * queue = network->queue;
+	for(uint32_t i = 0; i < num_vertices; ++i) labels[i] = num_vertices;
+
+	uint32_t head = 0, tail = 0;
+	labels[network->dst_id] = 0;
+	queue[tail++] = network->dst_id;
+	while(head < tail) {
+		uint32_t w = queue[head++];
+		for(size_t a = network->first_arcs[w]; a < network->first_arcs[w + 1]; ++a) {
+			const struct flow_arc * arc = &network->arcs[a];
+			uint32_t v = arc->dst_id;
+			if(labels[v] < num_vertices || v == network->src_id) continue;
+			if(network->arcs[arc->rev].capacity <= 0) continue;	// v -> w is saturated
+			labels[v] = labels[w] + 1;
+			queue[tail++] = v;
+		}
+	}
+	return tail;
+}
+
+static void flow_network_get_min_cut(struct flow_network * network, struct max_flow_result * result)
+{
+	global_relabel(network);	// labels < num_vertices: the vertices which can still reach dst
+
+	size_t max_size = 0;
+	const uint32_t num_vertices = network->num_vertices;
+	for(uint32_t u = 0; u < num_vertices; ++u) {
+		if(network->labels[u] < num_vertices) continue;
+		for(size_t a = network->first_arcs[u]; a < network->first_arcs[u + 1]; ++a) {
+			const struct dijkstra_sparse_edge * edge = network->arc_edges[a];
+			if(NULL == edge || network->labels[network->arcs[a].dst_id] >= num_vertices) continue;
+			assert(network->arcs[a].capacity == 0);
+
+			if(result->num_cut_edges >= max_size) {
+				max_size = max_size?(max_size * 2):16;
+				result->cut_edges = realloc(result->cut_edges, max_size * sizeof(*result->cut_edges));
+				assert(result->cut_edges);
+			}
+			result->cut_edges[result->num_cut_edges++] = edge;
+		}
+	}
+}
+
+/************************************
+ * highest-label push-relabel (sequential)
+ *   with global relabeling and gap heuristics
+************************************/
+#define NIL_ID ((uint32_t)-1)
+struct hlpp_buckets
+{
+	uint32_t * active_heads;	// [num_vertices], singly linked lists of active vertices
+	uint32_t * all_heads;		// [num_vertices], doubly linked lists of all vertices
+	uint32_t * next_active;
+	uint32_t * next_all;
+	uint32_t * prev_all;
+	size_t * current_arcs;
+	int64_t max_active;
+	int64_t max_label;
+};
+
+static inline void bucket_add(struct hlpp_buckets * buckets, uint32_t label, uint32_t v)
+{
+	uint32_t head = buckets->all_heads[label];
+	buckets->next_all[v] = head;
+	buckets->prev_all[v] = NIL_ID;
+	if(head != NIL_ID) buckets->prev_all[head] = v;
+	buckets->all_heads[label] = v;
+	if(label > buckets->max_label) buckets->max_label = label;
+}
+
+static inline void bucket_remove(struct hlpp_buckets * buckets, uint32_t label, uint32_t v)
+{
+	uint32_t next = buckets->next_all[v];
+	uint32_t prev = buckets->prev_all[v];
+	if(prev != NIL_ID) buckets->next_all[prev] = next;
+	else buckets->all_heads[label] = next;
+	if(next != NIL_ID) buckets->prev_all[next] = prev;
+}
+
+static inline void bucket_add_active(struct hlpp_buckets * buckets, uint32_t label, uint32_t v)
+{
+	buckets->next_active[v] = buckets->active_heads[label];
+	buckets->active_heads[label] = v;
+	if(label > buckets->max_active) buckets->max_active = label;
+}
+
+static void hlpp_rebuild_buckets(struct flow_network * network, struct hlpp_buckets * buckets)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		buckets->active_heads[i] = NIL_ID;
+		buckets->all_heads[i] = NIL_ID;
+		buckets->current_arcs[i] = network->first_arcs[i];
+	}
+	buckets->max_active = -1;
+	buckets->max_label = -1;
+
+	for(uint32_t v = 0; v < num_vertices; ++v) {
+		uint32_t label = network->labels[v];
+		if(label >= num_vertices) continue;
+		bucket_add(buckets, label, v);
+		if(network->excess[v] > 0 && v != network->dst_id) bucket_add_active(buckets, label, v);
+	}
+}
+
+/* all vertices above the gap can not reach dst any more */
+static void hlpp_gap(struct flow_network * network, struct hlpp_buckets * buckets, uint32_t gap_label)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	for(int64_t label = gap_label + 1; label <= buckets->max_label; ++label) {
+		for(uint32_t v = buckets->all_heads[label]; v != NIL_ID; v = buckets->next_all[v]) {
+			network->labels[v] = num_vertices;
+		}
+		buckets->all_heads[label] = NIL_ID;
+		buckets->active_heads[label] = NIL_ID;
+	}
+	buckets->max_label = (int64_t)gap_label - 1;
+	if(buckets->max_active > buckets->max_label) buckets->max_active = buckets->max_label;
+}
+
+/**
+ * function hlpp_discharge(): push all the excess of v, relabel v when needed
+ *  @return the amount of work done
+**/
+static size_t hlpp_discharge(struct flow_network * network, struct hlpp_buckets * buckets, uint32_t v)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	uint32_t * labels = network->labels;
+	int64_t * excess = network->excess;
+	size_t work = 0;
+
+	while(excess[v] > 0) {
+		uint32_t label = labels[v];
+		size_t end = network->first_arcs[v + 1];
+
+		// push
+		for(size_t a = buckets->current_arcs[v]; a < end; ++a) {
+			struct flow_arc * arc = &network->arcs[a];
+			if(arc->capacity <= 0 || labels[arc->dst_id] + 1 != label) continue;
+
+			uint32_t w = arc->dst_id;
+			int64_t delta = (excess[v] < arc->capacity)?excess[v]:arc->capacity;
+			if(0 == excess[w] && w != network->dst_id) bucket_add_active(buckets, labels[w], w);
+
+			arc->capacity -= delta;
+			network->arcs[arc->rev].capacity += delta;
+			excess[v] -= delta;
+			excess[w] += delta;
+			if(0 == excess[v]) {
+				buckets->current_arcs[v] = a;
+				return work;
+			}
+		}
+
+		// relabel
+		uint32_t new_label = num_vertices;
+		size_t current_arc = network->first_arcs[v];
+		for(size_t a = network->first_arcs[v]; a < end; ++a) {
+			const struct flow_arc * arc = &network->arcs[a];
+			if(arc->capacity > 0 && labels[arc->dst_id] + 1 < new_label) {
+				new_label = labels[arc->dst_id] + 1;
+				current_arc = a;
+			}
+		}
+		work += 12 + (end - network->first_arcs[v]);
+
+		bucket_remove(buckets, label, v);
+		if(NIL_ID == buckets->all_heads[label]) { // gap
+			labels[v] = num_vertices;
+			hlpp_gap(network, buckets, label);
+			return work;
+		}
+		labels[v] = new_label;
+		if(new_label >= num_vertices) return work;
+
+		buckets->current_arcs[v] = current_arc;
+		bucket_add(buckets, new_label, v);
+	}
+	return work;
+}
+
+static void flow_network_hlpp(struct flow_network * network)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	struct hlpp_buckets buckets[1];
+	memset(buckets, 0, sizeof(buckets));
+	buckets->active_heads = calloc(num_vertices, sizeof(uint32_t));
+	buckets->all_heads = calloc(num_vertices, sizeof(uint32_t));
+	buckets->next_active = calloc(num_vertices, sizeof(uint32_t));
+	buckets->next_all = calloc(num_vertices, sizeof(uint32_t));
+	buckets->prev_all = calloc(num_vertices, sizeof(uint32_t));
+	buckets->current_arcs = calloc(num_vertices, sizeof(size_t));
+	assert(buckets->active_heads && buckets->all_heads && buckets->next_active
+		&& buckets->next_all && buckets->prev_all && buckets->current_arcs);
+
+	const size_t global_relabel_threshold = 6 * (size_t)num_vertices + network->num_arcs / 2;
+	size_t work = 0;
+
+	global_relabel(network);
+	hlpp_rebuild_buckets(network, buckets);
+	while(buckets->max_active >= 0) {
+		uint32_t label = buckets->max_active;
+		uint32_t v = buckets->active_heads[label];
+		if(NIL_ID == v) {
+			--buckets->max_active;
+			continue;
+		}
+		buckets->active_heads[label] = buckets->next_active[v];
+		if(network->labels[v] != label) continue;	// stale
+
+		work += hlpp_discharge(network, buckets, v);
+		if(work > global_relabel_threshold) {
+			work = 0;
+			global_relabel(network);
+			hlpp_rebuild_buckets(network, buckets);
+		}
+	}
+
+	free(buckets->active_heads);
+	free(buckets->all_heads);
+	free(buckets->next_active);
+	free(buckets->next_all);
+	free(buckets->prev_all);
+	free(buckets->current_arcs);
+}
+
+/************************************
+ * synchronous parallel push-relabel
+ *   each round:
+ *     1. every active vertex pushes along its admissible arcs using the labels of the last round,
+ *        v->w and w->v can not be admissible at the same time, so a residual pair is only touched
+ *        by one thread: the label is checked before the capacity is read.
+ *        the received excess is accumulated in added_excess[] atomically.
+ *     2. every active vertex with remaining excess is relabeled (into new_labels[]).
+ *     3. the master applies the new labels / excesses and collects the next active set.
+ *   global relabeling is done by the master when enough relabels have been done.
+************************************/
+struct parallel_push_relabel;
+struct parallel_worker
+{
+	struct parallel_push_relabel * shared;
+	int id;
+	pthread_t th;
+	struct clib_u32_vec touched;	// vertices which (may) become active in the next round
+	size_t num_relabels;
+	size_t num_chunks;	// chunks of the active sets claimed by this worker
+};
+
+struct parallel_push_relabel
+{
+	struct flow_network * network;
+	int num_threads;
+	struct parallel_worker * workers;
+	pthread_barrier_t barrier;
+	int quit;
+
+	struct clib_u32_vec active[1];
+	size_t next_index;	// dynamic scheduling of the active set
+	size_t chunk_size;
+	int64_t * added_excess;
+	uint32_t * new_labels;
+	unsigned char * in_touched;
+	size_t relabels_since_global;
+	size_t max_active;	// the largest active set of all rounds
+};
+
+static void parallel_push_phase(struct parallel_worker * worker)
+{
+	struct parallel_push_relabel * shared = worker->shared;
+	struct flow_network * network = shared->network;
+	const uint32_t * labels = network->labels;
+	const uint32_t * ids = clib_u32_vec_data(shared->active);
+	const size_t length = shared->active->length;
+
+	while(1) {
+		size_t begin = __atomic_fetch_add(&shared->next_index, shared->chunk_size, __ATOMIC_RELAXED);
+		if(begin >= length) break;
+		size_t end = begin + shared->chunk_size;
+		if(end > length) end = length;
+		++worker->num_chunks;
+
+		for(size_t i = begin; i < end; ++i) {
+			uint32_t v = ids[i];
+			uint32_t label = labels[v];
+			int64_t excess = network->excess[v];
+
+			for(size_t a = network->first_arcs[v]; excess > 0 && a < network->first_arcs[v + 1]; ++a) {
+				struct flow_arc * arc = &network->arcs[a];
+				// admissible first: the reverse arc of a non-admissible arc may be written by another thread
+				if(labels[arc->dst_id] + 1 != label || arc->capacity <= 0) continue;
+
+				uint32_t w = arc->dst_id;
+				int64_t delta = (excess < arc->capacity)?excess:arc->capacity;
+				arc->capacity -= delta;
+				network->arcs[arc->rev].capacity += delta;
+				excess -= delta;
+				__atomic_fetch_add(&shared->added_excess[w], delta, __ATOMIC_RELAXED);
+				if(0 == __atomic_exchange_n(&shared->in_touched[w], 1, __ATOMIC_RELAXED)) clib_u32_vec_push(&worker->touched, w);
+			}
+			network->excess[v] = excess;
+			if(excess > 0 && 0 == __atomic_exchange_n(&shared->in_touched[v], 1, __ATOMIC_RELAXED)) {
+				clib_u32_vec_push(&worker->touched, v);
+			}
+		}
+	}
+}
+
+static void parallel_relabel_phase(struct parallel_worker * worker)
+{
+	struct parallel_push_relabel * shared = worker->shared;
+	struct flow_network * network = shared->network;
+	const uint32_t num_vertices = network->num_vertices;
+	const uint32_t * labels = network->labels;
+	const uint32_t * ids = clib_u32_vec_data(shared->active);
+	const size_t length = shared->active->length;
+
+	while(1) {
+		size_t begin = __atomic_fetch_add(&shared->next_index, shared->chunk_size, __ATOMIC_RELAXED);
+		if(begin >= length) break;
+		size_t end = begin + shared->chunk_size;
+		if(end > length) end = length;
+		++worker->num_chunks;
+
+		for(size_t i = begin; i < end; ++i) {
+			uint32_t v = ids[i];
+			if(network->excess[v] <= 0) continue;
+
+			uint32_t new_label = num_vertices;
+			for(size_t a = network->first_arcs[v]; a < network->first_arcs[v + 1]; ++a) {
+				const struct flow_arc * arc = &network->arcs[a];
+				if(arc->capacity > 0 && labels[arc->dst_id] + 1 < new_label) new_label = labels[arc->dst_id] + 1;
+			}
+			shared->new_labels[v] = new_label;
+			++worker->num_relabels;
+		}
+	}
+}
+
+/* master: apply the results of this round and collect the next active set */
+static void parallel_apply_round(struct parallel_push_relabel * shared)
+{
+	struct flow_network * network = shared->network;
+	const uint32_t num_vertices = network->num_vertices;
+
+	for(size_t i = 0; i < shared->active->length; ++i) {
+		uint32_t v = clib_u32_vec_data(shared->active)[i];
+		network->labels[v] = shared->new_labels[v];
+	}
+
+	size_t num_relabels = 0;
+	clib_u32_vec_clear(shared->active);
+	for(int t = 0; t < shared->num_threads; ++t) {
+		struct parallel_worker * worker = &shared->workers[t];
+		for(size_t i = 0; i < worker->touched.length; ++i) {
+			uint32_t v = clib_u32_vec_data(&worker->touched)[i];
+			shared->in_touched[v] = 0;
+			network->excess[v] += shared->added_excess[v];
+			shared->added_excess[v] = 0;
+		}
+		num_relabels += worker->num_relabels;
+		worker->num_relabels = 0;
+	}
+
+	shared->relabels_since_global += num_relabels;
+	if(shared->relabels_since_global > num_vertices / 2) {
+		shared->relabels_since_global = 0;
+		global_relabel(network);
+	}
+
+	for(int t = 0; t < shared->num_threads; ++t) {
+		struct parallel_worker * worker = &shared->workers[t];
+		for(size_t i = 0; i < worker->touched.length; ++i) {
+			uint32_t v = clib_u32_vec_data(&worker->touched)[i];
+			if(v == network->dst_id || v == network->src_id) continue;
+			if(network->excess[v] > 0 && network->labels[v] < num_vertices) {
+				clib_u32_vec_push(shared->active, v);
+				shared->new_labels[v] = network->labels[v];
+			}
+		}
+		clib_u32_vec_clear(&worker->touched);
+	}
+	if(shared->active->length > shared->max_active) shared->max_active = shared->active->length;
+	if(0 == shared->active->length) shared->quit = 1;
+}
+
+static void * parallel_worker_thread(void * user_data)
+{
+	struct parallel_worker * worker = user_data;
+	struct parallel_push_relabel * shared = worker->shared;
+
+	while(1) {
+		pthread_barrier_wait(&shared->barrier);
+		if(shared->quit) break;
+
+		parallel_push_phase(worker);
+		if(PTHREAD_BARRIER_SERIAL_THREAD == pthread_barrier_wait(&shared->barrier)) shared->next_index = 0;
+		pthread_barrier_wait(&shared->barrier);
+
+		parallel_relabel_phase(worker);
+		pthread_barrier_wait(&shared->barrier);
+
+		if(0 == worker->id) {
+			shared->next_index = 0;
+			parallel_apply_round(shared);
+		}
+	}
+	return NULL;
+}
+
+static void flow_network_parallel_push_relabel(struct flow_network * network, int num_threads, size_t chunk_size)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	struct parallel_push_relabel shared[1];
+	memset(shared, 0, sizeof(shared));
+	shared->network = network;
+	shared->num_threads = num_threads;
+	shared->chunk_size = chunk_size?chunk_size:MAX_FLOW_DEFAULT_CHUNK_SIZE;
+	shared->added_excess = calloc(num_vertices, sizeof(*shared->added_excess));
+	shared->new_labels = calloc(num_vertices, sizeof(*shared->new_labels));
+	shared->in_touched = calloc(num_vertices, sizeof(*shared->in_touched));
+	shared->workers = calloc(num_threads, sizeof(*shared->workers));
+	assert(shared->added_excess && shared->new_labels && shared->in_touched && shared->workers);
+
+	global_relabel(network);
+	for(uint32_t v = 0; v < num_vertices; ++v) {
+		if(v == network->dst_id || v == network->src_id) continue;
+		if(network->excess[v] > 0 && network->labels[v] < num_vertices) {
+			clib_u32_vec_push(shared->active, v);
+			shared->new_labels[v] = network->labels[v];
+		}
+	}
+	shared->quit = (0 == shared->active->length);
+	shared->max_active = shared->active->length;
+
+	int rc = pthread_barrier_init(&shared->barrier, NULL, num_threads);
+	assert(0 == rc);
+	for(int t = 0; t < num_threads; ++t) {
+		struct parallel_worker * worker = &shared->workers[t];
+		worker->shared = shared;
+		worker->id = t;
+		if(t == 0) continue; // the calling thread is worker 0
+		rc = pthread_create(&worker->th, NULL, parallel_worker_thread, worker);
+		assert(0 == rc);
+	}
+	parallel_worker_thread(&shared->workers[0]);
+
+	for(int t = 1; t < num_threads; ++t) pthread_join(shared->workers[t].th, NULL);
+	pthread_barrier_destroy(&shared->barrier);
+	debug_printf("parallel push-relabel: max_active=%zu, chunk_size=%zu\n", shared->max_active, shared->chunk_size);
+	for(int t = 0; t < num_threads; ++t) {
+		debug_printf("parallel push-relabel: worker[%d] claimed %zu chunks\n", t, shared->workers[t].num_chunks);
+	}
+
+	for(int t = 0; t < num_threads; ++t) clib_u32_vec_cleanup(&shared->workers[t].touched);
+	free(shared->workers);
+	clib_u32_vec_cleanup(shared->active);
+	free(shared->added_excess);
+	free(shared->new_labels);
+	free(shared->in_touched);
+}
+
+static int64_t max_flow_push_relabel(struct max_flow_context * ctx,
+	uint32_t src_id, uint32_t dst_id,
+	struct max_flow_result * result)
+{
+	assert(ctx && ctx->graph);
+	if(src_id >= ctx->graph->num_vertices || dst_id >= ctx->graph->num_vertices) return -1;
+	if(src_id == dst_id) return -1;
+
+	struct flow_network * network = flow_network_new(ctx, src_id, dst_id);
+	flow_network_init_preflow(network);
+
+	if(ctx->num_threads > 1) flow_network_parallel_push_relabel(network, ctx->num_threads, ctx->chunk_size);
+	else flow_network_hlpp(network);
+
+	int64_t flow = network->excess[dst_id];
+	debug_printf("max_flow(%u -> %u): %ld\n", src_id, dst_id, (long)flow);
+	if(result) {
+		max_flow_result_cleanup(result);
+		result->flow = flow;
+		flow_network_get_min_cut(network, result);
+	}
+	flow_network_free(network);
+	return flow;
+}
+
+void max_flow_result_cleanup(struct max_flow_result * result)
+{
+	if(NULL == result) return;
+	free(result->cut_edges);
+	memset(result, 0, sizeof(*result));
+}
+
+/************************************
+ * max_flow_context
+************************************/
+struct max_flow_context * max_flow_context_init(struct max_flow_context * ctx,
+	const struct dijkstra_graph * graph,
+	void * user_data)
+{
+	assert(graph);
+	assert(graph->num_vertices > 0);
+	assert(graph->edges && graph->edges->is_sparse_matrix);
+
+	if(NULL == ctx) ctx = calloc(1, sizeof(*ctx));
+	else memset(ctx, 0, sizeof(*ctx));
+	assert(ctx);
+
+	ctx->graph = graph;
+	ctx->user_data = user_data;
+	ctx->max_flow = max_flow_push_relabel;
+	ctx->get_capacity = get_default_capacity;
+	return ctx;
+}
+
+/* nothing to release: the graph belongs to the caller, the flow network lives only inside max_flow() */
+void max_flow_context_cleanup(struct max_flow_context * ctx)
+{
+	(void)ctx;
+	return;
+}
+
+
+/****************************************************
+ * TEST_MODULE::max-flow
+ * build:
+ *   tests/make.sh max-flow
+****************************************************/
+#if defined(TEST_MAX_FLOW) && defined(ALGORITHMS_C_STAND_ALONE)
+#include <time.h>
+
+static double get_time_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static int64_t check_cut(const struct max_flow_result * result)
+{
+	int64_t capacity = 0;
+	for(size_t i = 0; i < result->num_cut_edges; ++i) capacity += result->cut_edges[i]->capacity;
+	return capacity;
+}
+
+static void test_small_graph(void)
+{
+	printf("\e[33m===== %s =====\e[39m\n", __FUNCTION__);
+	/* classic CLRS sample, max-flow(0 -> 5) = 23 */
+	static const int64_t capacities[6][6] = {
+		{ 0, 16, 13,  0,  0,  0},
+		{ 0,  0, 10, 12,  0,  0},
+		{ 0,  4,  0,  0, 14,  0},
+		{ 0,  0,  9,  0,  0, 20},
+		{ 0,  0,  0,  7,  0,  4},
+		{ 0,  0,  0,  0,  0,  0},
+	};
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, 6);
+	for(uint32_t i = 0; i < 6; ++i) {
+		for(uint32_t j = 0; j < 6; ++j) {
+			if(capacities[i][j] <= 0) continue;
+			edges->update(edges, i, j, 1);
+			edges->set_capacity(edges, i, j, capacities[i][j], 0, DIJKSTRA_CAPACITY_UNLIMITED);
+		}
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = 6, .edges = edges }};
+	struct max_flow_context ctx[1];
+	max_flow_context_init(ctx, graph, NULL);
+
+	struct max_flow_result result[1];
+	memset(result, 0, sizeof(result));
+	for(int num_threads = 1; num_threads <= 4; num_threads *= 2) {
+		ctx->num_threads = num_threads;
+		int64_t flow = ctx->max_flow(ctx, 0, 5, result);
+		printf("  num_threads=%d, max_flow=%ld, min_cut: ", num_threads, (long)flow);
+		for(size_t i = 0; i < result->num_cut_edges; ++i) {
+			printf("[%u -> %u](%ld) ", result->cut_edges[i]->src_id, result->cut_edges[i]->dst_id, (long)result->cut_edges[i]->capacity);
+		}
+		printf("\n");
+		assert(flow == 23);
+		assert(check_cut(result) == flow);
+	}
+
+	// unlimited capacities on both ends are bounded by the inner edges
+	edges->set_capacity(edges, 0, 1, DIJKSTRA_CAPACITY_UNLIMITED, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->set_capacity(edges, 3, 5, DIJKSTRA_CAPACITY_UNLIMITED, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	ctx->num_threads = 1;
+	int64_t flow = ctx->max_flow(ctx, 0, 5, result);
+	printf("  unlimited: max_flow=%ld\n", (long)flow);
+	assert(flow == 23 && check_cut(result) == flow);
+
+	max_flow_result_cleanup(result);
+	max_flow_context_cleanup(ctx);
+	dijkstra_edges_cleanup(edges);
+}
+
+static void test_random_graph(uint32_t num_vertices, uint32_t degree)
+{
+	printf("\e[33m===== %s(n=%u, degree=%u) =====\e[39m\n", __FUNCTION__, num_vertices, degree);
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, num_vertices);
+	srand(12345);
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		for(uint32_t k = 0; k < degree; ++k) {
+			uint32_t j = rand() % num_vertices;
+			if(j == i) continue;
+			edges->update(edges, i, j, 1);
+			edges->set_capacity(edges, i, j, 1 + rand() % 1000, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+		}
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = num_vertices, .edges = edges }};
+	struct max_flow_context ctx[1];
+	max_flow_context_init(ctx, graph, NULL);
+
+	struct max_flow_result result[1];
+	memset(result, 0, sizeof(result));
+	int64_t seq_flow = -1;
+	for(int num_threads = 1; num_threads <= 4; num_threads *= 2) {
+		// small chunks spread even the small active sets over all the workers
+		static const size_t chunk_sizes[] = { 0, 1, 3 };
+		for(size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i) {
+			if(num_threads == 1 && i > 0) break;
+			ctx->num_threads = num_threads;
+			ctx->chunk_size = chunk_sizes[i];
+			double start = get_time_ms();
+			int64_t flow = ctx->max_flow(ctx, 0, num_vertices - 1, result);
+			printf("  num_threads=%d, chunk_size=%zu, max_flow=%ld, cut_edges=%zu, time=%.3f ms\n",
+				num_threads, ctx->chunk_size, (long)flow, result->num_cut_edges, get_time_ms() - start);
+			assert(check_cut(result) == flow);
+			if(num_threads == 1) seq_flow = flow;
+			assert(flow == seq_flow);
+		}
+	}
+	max_flow_result_cleanup(result);
+	max_flow_context_cleanup(ctx);
+	dijkstra_edges_cleanup(edges);
+}
+
+/*
+ * src -> [layer 0] -> ... -> [layer n-1] -> dst, each layer has `width` vertices:
+ * from the second round on, the active set is a whole layer (width > MAX_FLOW_DEFAULT_CHUNK_SIZE),
+ * so the default chunk size also splits every round over several workers.
+ */
+static void test_layered_graph(uint32_t num_layers, uint32_t width)
+{
+	printf("\e[33m===== %s(layers=%u, width=%u) =====\e[39m\n", __FUNCTION__, num_layers, width);
+	assert(width > MAX_FLOW_DEFAULT_CHUNK_SIZE);
+	const uint32_t num_vertices = num_layers * width + 2;
+	const uint32_t src_id = num_vertices - 2, dst_id = num_vertices - 1;
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, num_vertices);
+	srand(4242);
+	for(uint32_t i = 0; i < width; ++i) {
+		edges->update(edges, src_id, i, 1);
+		edges->set_capacity(edges, src_id, i, 1 + rand() % 1000, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+		edges->update(edges, (num_layers - 1) * width + i, dst_id, 1);
+		edges->set_capacity(edges, (num_layers - 1) * width + i, dst_id, 1 + rand() % 1000, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	}
+	for(uint32_t layer = 0; layer + 1 < num_layers; ++layer) {
+		for(uint32_t i = 0; i < width; ++i) {
+			for(int k = 0; k < 4; ++k) {
+				uint32_t v = layer * width + i, w = (layer + 1) * width + rand() % width;
+				edges->update(edges, v, w, 1);
+				edges->set_capacity(edges, v, w, 1 + rand() % 500, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+			}
+		}
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = num_vertices, .edges = edges }};
+	struct max_flow_context ctx[1];
+	max_flow_context_init(ctx, graph, NULL);
+	
+	struct max_flow_result result[1];
+	memset(result, 0, sizeof(result));
+	int64_t seq_flow = ctx->max_flow(ctx, src_id, dst_id, result);
+	assert(seq_flow > 0 && check_cut(result) == seq_flow);
+	for(int num_threads = 2; num_threads <= 8; num_threads *= 2) {
+		ctx->num_threads = num_threads;
+		ctx->chunk_size = 0;
+		double start = get_time_ms();
+		int64_t flow = ctx->max_flow(ctx, src_id, dst_id, result);
+		printf("  num_threads=%d, max_flow=%ld (sequential: %ld), cut_edges=%zu, time=%.3f ms\n",
+			num_threads, (long)flow, (long)seq_flow, result->num_cut_edges, get_time_ms() - start);
+		assert(flow == seq_flow && check_cut(result) == flow);
+	}
+	max_flow_result_cleanup(result);
+	max_flow_context_cleanup(ctx);
+	dijkstra_edges_cleanup(edges);
+}
+
+int main(int argc, char **argv)
+{
+	test_small_graph();
+	test_random_graph(1000, 8);
+	test_random_graph(20000, 8);
+	test_layered_graph(8, 500);
+	return 0;
+}
+#endif
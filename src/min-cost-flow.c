@@ -0,0 +1,644 @@
+/*
+ * min-cost-flow.c
+ *
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <stdint.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "min-cost-flow.h"
+
+/************************************
+ * residual network
+ *   every segment of an edge becomes a forward arc (capacity, unit_cost)
+ *   and a reverse arc (0, -unit_cost), arcs of a vertex are stored contiguously (CSR).
+************************************/
+struct residual_arc
+{
+	uint32_t dst_id;
+	uint32_t rev;		// index of the reverse arc
+	int64_t capacity;	// residual capacity
+	int64_t cost;		// unit cost
+	int64_t init_capacity; // 0 for reverse arcs
+};
+
+struct residual_network
+{
+	uint32_t num_vertices;
+	size_t num_arcs;
+	size_t * first_arcs;	// [num_vertices + 1]
+	struct residual_arc * arcs;
+
+	// state of the last solve
+	uint32_t src_id;
+	uint32_t dst_id;
+	int64_t flow;
+	int64_t cost;
+
+	// dijkstra buffers
+	int64_t * dist;
+	uint32_t * parent_arcs;
+	unsigned char * settled;
+};
+
+static void residual_network_free(struct residual_network * network)
+{
+	if(NULL == network) return;
+	free(network->first_arcs);
+	free(network->arcs);
+	free(network->dist);
+	free(network->parent_arcs);
+	free(network->settled);
+	free(network);
+}
+
+static int get_default_cost_segments(const struct dijkstra_sparse_edge * edge, void * user_data,
+	struct min_cost_flow_segment segments[MIN_COST_FLOW_MAX_SEGMENTS])
+{
+	segments[0].capacity = edge->capacity;
+	segments[0].unit_cost = edge->weight;
+	return 1;
+}
+
+static struct residual_network * residual_network_new(struct min_cost_flow_context * mcf)
+{
+	const struct dijkstra_graph * graph = mcf->graph;
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)graph->edges;
+	assert(edges && edges->is_sparse_matrix);
+
+	struct residual_network * network = calloc(1, sizeof(*network));
+	assert(network);
+
+	uint32_t num_vertices = graph->num_vertices;
+	network->num_vertices = num_vertices;
+	network->first_arcs = calloc(num_vertices + 1, sizeof(*network->first_arcs));
+	assert(network->first_arcs);
+
+	struct min_cost_flow_segment segments[MIN_COST_FLOW_MAX_SEGMENTS];
+	clib_list_iterator_t iter;
+
+	// step 1. count arcs of each vertex
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		const struct clib_slist * list = NULL;
+		ssize_t count = edges->get_vertex_sparse_edges(edges, i, &list);
+		if(count <= 0) continue;
+
+		memset(&iter, 0, sizeof(iter));
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			assert(edge->dst_id < num_vertices);
+			int num_segments = mcf->get_cost_segments(edge, mcf->user_data, segments);
+			assert(num_segments >= 0 && num_segments <= MIN_COST_FLOW_MAX_SEGMENTS);
+
+			network->first_arcs[i + 1] += num_segments;
+			network->first_arcs[edge->dst_id + 1] += num_segments;
+		}
+	}
+	for(uint32_t i = 0; i < num_vertices; ++i) network->first_arcs[i + 1] += network->first_arcs[i];
+	network->num_arcs = network->first_arcs[num_vertices];
+
+	// step 2. fill arcs
+	network->arcs = calloc(network->num_arcs + 1, sizeof(*network->arcs));
+	size_t * next_arcs = calloc(num_vertices, sizeof(*next_arcs));
+	assert(network->arcs && next_arcs);
+	memcpy(next_arcs, network->first_arcs, num_vertices * sizeof(*next_arcs));
+
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		const struct clib_slist * list = NULL;
+		ssize_t count = edges->get_vertex_sparse_edges(edges, i, &list);
+		if(count <= 0) continue;
+
+		memset(&iter, 0, sizeof(iter));
+		while(clib_slist_iter_next((struct clib_slist *)list, &iter)) {
+			const struct dijkstra_sparse_edge * edge = clib_list_iterator_get_data(iter);
+			int num_segments = mcf->get_cost_segments(edge, mcf->user_data, segments);
+			for(int k = 0; k < num_segments; ++k) {
+				assert(segments[k].unit_cost >= 0);
+				assert(k == 0 || segments[k].unit_cost >= segments[k - 1].unit_cost); // convex
+
+				size_t fwd = next_arcs[i]++;
+				size_t rev = next_arcs[edge->dst_id]++;
+				network->arcs[fwd] = (struct residual_arc){
+					.dst_id = edge->dst_id, .rev = rev,
+					.capacity = segments[k].capacity, .cost = segments[k].unit_cost,
+					.init_capacity = segments[k].capacity,
+				};
+				network->arcs[rev] = (struct residual_arc){
+					.dst_id = i, .rev = fwd,
+					.capacity = 0, .cost = -segments[k].unit_cost,
+					.init_capacity = 0,
+				};
+			}
+		}
+	}
+	free(next_arcs);
+
+	network->dist = calloc(num_vertices, sizeof(*network->dist));
+	network->parent_arcs = calloc(num_vertices, sizeof(*network->parent_arcs));
+	network->settled = calloc(num_vertices, sizeof(*network->settled));
+	assert(network->dist && network->parent_arcs && network->settled);
+	return network;
+}
+
+static void residual_network_reset_flow(struct residual_network * network)
+{
+	for(size_t i = 0; i < network->num_arcs; ++i) {
+		network->arcs[i].capacity = network->arcs[i].init_capacity;
+	}
+	network->flow = 0;
+	network->cost = 0;
+}
+
+/*
+ * check whether the potentials are still valid for the residual network,
+ * i.e. all the reduced costs are non-negative
+ */
+static int residual_network_check_potentials(const struct residual_network * network, const int64_t * potentials)
+{
+	for(uint32_t u = 0; u < network->num_vertices; ++u) {
+		for(size_t a = network->first_arcs[u]; a < network->first_arcs[u + 1]; ++a) {
+			const struct residual_arc * arc = &network->arcs[a];
+			if(arc->capacity <= 0) continue;
+			if(arc->cost + potentials[u] - potentials[arc->dst_id] < 0) return 0;
+		}
+	}
+	return 1;
+}
+
+/************************************
+ * binary heap of (dist, vertex_id), lazy deletion
+************************************/
+struct heap_item
+{
+	int64_t dist;
+	uint32_t id;
+};
+struct binary_heap
+{
+	size_t max_size;
+	size_t length;
+	struct heap_item * items;
+};
+
+static void heap_push(struct binary_heap * heap, int64_t dist, uint32_t id)
+{
+	if(heap->length >= heap->max_size) {
+		size_t new_size = heap->max_size?(heap->max_size * 2):64;
+		heap->items = realloc(heap->items, new_size * sizeof(*heap->items));
+		assert(heap->items);
+		heap->max_size = new_size;
+	}
+	size_t pos = heap->length++;
+	while(pos > 0) {
+		size_t parent = (pos - 1) / 2;
+		if(heap->items[parent].dist <= dist) break;
+		heap->items[pos] = heap->items[parent];
+		pos = parent;
+	}
+	heap->items[pos] = (struct heap_item){dist, id};
+}
+
+static int heap_pop(struct binary_heap * heap, struct heap_item * p_item)
+{
+	if(heap->length == 0) return -1;
+	*p_item = heap->items[0];
+
+	struct heap_item last = heap->items[--heap->length];
+	size_t pos = 0;
+	while(1) {
+		size_t child = pos * 2 + 1;
+		if(child >= heap->length) break;
+		if(child + 1 < heap->length && heap->items[child + 1].dist < heap->items[child].dist) ++child;
+		if(last.dist <= heap->items[child].dist) break;
+		heap->items[pos] = heap->items[child];
+		pos = child;
+	}
+	heap->items[pos] = last;
+	return 0;
+}
+
+/**
+ * function find_augmenting_path(): dijkstra on the reduced costs
+ *   stops as soon as dst is settled, then updates the potentials:
+ *     settled vertices:   pi[v] += dist[v]
+ *     unsettled vertices: pi[v] += dist[dst]
+ *   (which keeps all the reduced costs non-negative)
+ *  @return 0 if dst is reachable, -1 otherwise.
+**/
+static int find_augmenting_path(struct residual_network * network, int64_t * potentials,
+	uint32_t src_id, uint32_t dst_id, struct binary_heap * heap)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	int64_t * dist = network->dist;
+	for(uint32_t i = 0; i < num_vertices; ++i) dist[i] = DIJKSTRA_WEIGHT_UNSET;
+	memset(network->settled, 0, num_vertices);
+
+	heap->length = 0;
+	dist[src_id] = 0;
+	heap_push(heap, 0, src_id);
+
+	struct heap_item item;
+	while(0 == heap_pop(heap, &item)) {
+		uint32_t u = item.id;
+		if(network->settled[u] || item.dist > dist[u]) continue;
+		network->settled[u] = 1;
+		if(u == dst_id) break;
+
+		for(size_t a = network->first_arcs[u]; a < network->first_arcs[u + 1]; ++a) {
+			const struct residual_arc * arc = &network->arcs[a];
+			if(arc->capacity <= 0) continue;
+
+			uint32_t v = arc->dst_id;
+			if(network->settled[v]) continue;
+			int64_t reduced_cost = arc->cost + potentials[u] - potentials[v];
+			assert(reduced_cost >= 0);
+
+			int64_t d = dist[u] + reduced_cost;
+			if(d < dist[v]) {
+				dist[v] = d;
+				network->parent_arcs[v] = a;
+				heap_push(heap, d, v);
+			}
+		}
+	}
+	if(!network->settled[dst_id]) return -1;
+
+	int64_t dst_dist = dist[dst_id];
+	for(uint32_t i = 0; i < num_vertices; ++i) {
+		potentials[i] += network->settled[i]?dist[i]:dst_dist;
+	}
+	return 0;
+}
+
+/**
+ * function decompose_flow(): split the flow on the forward arcs into src->dst paths.
+ *   (zero-cost cycles, if any, are cancelled)
+**/
+static void decompose_flow(struct residual_network * network, uint32_t src_id, uint32_t dst_id,
+	struct min_cost_flow_result * result)
+{
+	const uint32_t num_vertices = network->num_vertices;
+	int64_t * flows = calloc(network->num_arcs + 1, sizeof(*flows));
+	uint32_t * path_arcs = calloc(num_vertices + 1, sizeof(*path_arcs));
+	ssize_t * path_pos = calloc(num_vertices, sizeof(*path_pos)); // position of a vertex on the current path
+	assert(flows && path_arcs && path_pos);
+
+	for(size_t a = 0; a < network->num_arcs; ++a) {
+		const struct residual_arc * arc = &network->arcs[a];
+		if(arc->init_capacity > 0) flows[a] = arc->init_capacity - arc->capacity;
+	}
+	for(uint32_t i = 0; i < num_vertices; ++i) path_pos[i] = -1;
+
+	size_t max_paths = 0;
+	int64_t remaining = network->flow;
+	while(remaining > 0) {
+		size_t length = 0;
+		uint32_t u = src_id;
+		path_pos[u] = 0;
+
+		while(u != dst_id) {
+			size_t a = network->first_arcs[u];
+			for(; a < network->first_arcs[u + 1]; ++a) if(flows[a] > 0) break;
+			assert(a < network->first_arcs[u + 1]); // flow conservation
+
+			uint32_t v = network->arcs[a].dst_id;
+			path_arcs[length++] = a;
+			if(path_pos[v] >= 0) { // cycle: cancel it and continue from v
+				size_t start = path_pos[v];
+				int64_t amount = INT64_MAX;
+				for(size_t i = start; i < length; ++i) if(flows[path_arcs[i]] < amount) amount = flows[path_arcs[i]];
+				for(size_t i = start; i < length; ++i) {
+					flows[path_arcs[i]] -= amount;
+					if(i > start) path_pos[network->arcs[path_arcs[i - 1]].dst_id] = -1;
+				}
+				length = start;
+			}else {
+				path_pos[v] = length;
+			}
+			u = v;
+		}
+
+		int64_t amount = remaining;
+		int64_t unit_cost = 0;
+		for(size_t i = 0; i < length; ++i) {
+			if(flows[path_arcs[i]] < amount) amount = flows[path_arcs[i]];
+			unit_cost += network->arcs[path_arcs[i]].cost;
+		}
+		assert(amount > 0);
+
+		if(result->num_paths >= max_paths) {
+			max_paths = max_paths?(max_paths * 2):8;
+			result->paths = realloc(result->paths, max_paths * sizeof(*result->paths));
+			assert(result->paths);
+		}
+		struct min_cost_flow_path * path = &result->paths[result->num_paths++];
+		path->amount = amount;
+		path->cost = unit_cost * amount;
+		path->num_vertices = length + 1;
+		path->vertices = calloc(length + 1, sizeof(*path->vertices));
+		assert(path->vertices);
+
+		path->vertices[0] = src_id;
+		path_pos[src_id] = -1;
+		for(size_t i = 0; i < length; ++i) {
+			const struct residual_arc * arc = &network->arcs[path_arcs[i]];
+			flows[path_arcs[i]] -= amount;
+			path->vertices[i + 1] = arc->dst_id;
+			path_pos[arc->dst_id] = -1;
+		}
+		remaining -= amount;
+	}
+
+	free(flows);
+	free(path_arcs);
+	free(path_pos);
+}
+
+static int64_t min_cost_flow_solve(struct min_cost_flow_context * mcf,
+	uint32_t src_id, uint32_t dst_id, int64_t amount,
+	struct min_cost_flow_result * result)
+{
+	assert(mcf && mcf->graph);
+	assert(src_id < mcf->graph->num_vertices);
+	assert(dst_id < mcf->graph->num_vertices);
+	assert(src_id != dst_id);
+	assert(amount >= 0);
+
+	struct residual_network * network = mcf->priv;
+	if(NULL == network) {
+		network = residual_network_new(mcf);
+		mcf->priv = network;
+		network->src_id = src_id;
+		network->dst_id = dst_id;
+		
+		// the potentials of a previous network may not fit the new costs, 
+		// zero potentials are feasible on a fresh network (no flow, all the costs are non-negative)
+		free(mcf->potentials);
+		mcf->potentials = NULL;
+	}
+	if(NULL == mcf->potentials) {
+		mcf->potentials = calloc(network->num_vertices, sizeof(*mcf->potentials));
+		assert(mcf->potentials);
+	}
+
+	// warm-start: continue from the previous flow if possible,
+	// otherwise restart from zero flow and keep the potentials while they are still feasible
+	if(network->src_id != src_id || network->dst_id != dst_id || network->flow > amount) {
+		residual_network_reset_flow(network);
+		network->src_id = src_id;
+		network->dst_id = dst_id;
+		if(!residual_network_check_potentials(network, mcf->potentials)) {
+			memset(mcf->potentials, 0, network->num_vertices * sizeof(*mcf->potentials));
+		}
+	}
+
+	struct binary_heap heap[1];
+	memset(heap, 0, sizeof(heap));
+
+	int64_t * potentials = mcf->potentials;
+	while(network->flow < amount) {
+		if(find_augmenting_path(network, potentials, src_id, dst_id, heap)) break;
+
+		// find the bottleneck
+		int64_t delta = amount - network->flow;
+		int64_t unit_cost = 0;
+		int overflow = 0;
+		for(uint32_t v = dst_id; v != src_id; ) {
+			const struct residual_arc * arc = &network->arcs[network->parent_arcs[v]];
+			if(arc->capacity < delta) delta = arc->capacity;
+			overflow |= __builtin_add_overflow(unit_cost, arc->cost, &unit_cost);
+			v = network->arcs[arc->rev].dst_id;
+		}
+		assert(delta > 0);
+		
+		// the total cost must fit in int64
+		int64_t total_cost = 0;
+		overflow |= __builtin_mul_overflow(unit_cost, delta, &total_cost);
+		overflow |= __builtin_add_overflow(network->cost, total_cost, &total_cost);
+		if(overflow) break;
+
+		// augment
+		for(uint32_t v = dst_id; v != src_id; ) {
+			struct residual_arc * arc = &network->arcs[network->parent_arcs[v]];
+			arc->capacity -= delta;
+			network->arcs[arc->rev].capacity += delta;
+			v = network->arcs[arc->rev].dst_id;
+		}
+		network->cost = total_cost;
+		network->flow += delta;
+		debug_printf("  -- augment: delta=%ld, flow=%ld, cost=%ld\n", (long)delta, (long)network->flow, (long)network->cost);
+	}
+	free(heap->items);
+
+	if(result) {
+		min_cost_flow_result_cleanup(result);
+		result->amount = network->flow;
+		result->cost = network->cost;
+		decompose_flow(network, src_id, dst_id, result);
+	}
+
+	return (network->flow == amount)?network->cost:-1;
+}
+
+void min_cost_flow_result_cleanup(struct min_cost_flow_result * result)
+{
+	if(NULL == result) return;
+	for(size_t i = 0; i < result->num_paths; ++i) {
+		free(result->paths[i].vertices);
+	}
+	free(result->paths);
+	memset(result, 0, sizeof(*result));
+}
+
+/************************************
+ * min_cost_flow_context
+************************************/
+struct min_cost_flow_context * min_cost_flow_context_init(struct min_cost_flow_context * mcf,
+	const struct dijkstra_graph * graph,
+	void * user_data)
+{
+	assert(graph);
+	assert(graph->num_vertices > 0);
+	assert(graph->edges && graph->edges->is_sparse_matrix);
+
+	if(NULL == mcf) mcf = calloc(1, sizeof(*mcf));
+	else memset(mcf, 0, sizeof(*mcf));
+	assert(mcf);
+
+	mcf->graph = graph;
+	mcf->user_data = user_data;
+	mcf->solve = min_cost_flow_solve;
+	mcf->get_cost_segments = get_default_cost_segments;
+	return mcf;
+}
+
+void min_cost_flow_context_reset(struct min_cost_flow_context * mcf)
+{
+	if(NULL == mcf) return;
+	residual_network_free(mcf->priv);
+	mcf->priv = NULL;
+	free(mcf->potentials);
+	mcf->potentials = NULL;
+}
+
+void min_cost_flow_context_cleanup(struct min_cost_flow_context * mcf)
+{
+	if(NULL == mcf) return;
+	min_cost_flow_context_reset(mcf);
+	return;
+}
+
+
+/****************************************************
+ * TEST_MODULE::min-cost-flow
+ * build:
+ *   tests/make.sh min-cost-flow
+****************************************************/
+#if defined(TEST_MIN_COST_FLOW) && defined(ALGORITHMS_C_STAND_ALONE)
+
+/*
+ *        (cap=5, cost=1)     (cap=5, cost=1)
+ *     0 -----------------> 1 ----------------> 3
+ *     |                    |(cap=3, cost=1)    ^
+ *     |(cap=10, cost=2)    v                   |(cap=10, cost=2)
+ *     +------------------> 2 ------------------+
+ */
+#define NUM_VERTEXES (4)
+
+static void result_dump(const struct min_cost_flow_result * result)
+{
+	printf("  flow=%ld, cost=%ld, num_paths=%zu\n", (long)result->amount, (long)result->cost, result->num_paths);
+	for(size_t i = 0; i < result->num_paths; ++i) {
+		const struct min_cost_flow_path * path = &result->paths[i];
+		printf("    path[%zu]: amount=%ld, cost=%ld, ", i, (long)path->amount, (long)path->cost);
+		for(size_t k = 0; k < path->num_vertices; ++k) {
+			printf("%s%u", k?" ==> ":"", path->vertices[k]);
+		}
+		printf("\n");
+	}
+}
+
+/* cost grows with the used share of the capacity: [0, cap/2) ==> weight, [cap/2, cap) ==> weight * 4 */
+static int get_convex_cost_segments(const struct dijkstra_sparse_edge * edge, void * user_data,
+	struct min_cost_flow_segment segments[MIN_COST_FLOW_MAX_SEGMENTS])
+{
+	segments[0].capacity = edge->capacity / 2;
+	segments[0].unit_cost = edge->weight;
+	segments[1].capacity = edge->capacity - edge->capacity / 2;
+	segments[1].unit_cost = edge->weight * 4;
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, NUM_VERTEXES);
+
+	edges->update(edges, 0, 1, 1);  edges->set_capacity(edges, 0, 1, 5, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->update(edges, 1, 3, 1);  edges->set_capacity(edges, 1, 3, 5, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->update(edges, 1, 2, 1);  edges->set_capacity(edges, 1, 2, 3, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->update(edges, 0, 2, 2);  edges->set_capacity(edges, 0, 2, 10, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	edges->update(edges, 2, 3, 2);  edges->set_capacity(edges, 2, 3, 10, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+
+	struct dijkstra_graph graph[1] = {{
+		.num_vertices = NUM_VERTEXES,
+		.edges = edges,
+	}};
+
+	struct min_cost_flow_context mcf[1];
+	min_cost_flow_context_init(mcf, graph, NULL);
+
+	struct min_cost_flow_result result[1];
+	memset(result, 0, sizeof(result));
+
+	// 0 -> 1 -> 3 (5 * 2), 0 -> 2 -> 3 (3 * 4)
+	int64_t cost = mcf->solve(mcf, 0, 3, 8, result);
+	printf("solve(amount=8): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == 22 && result->amount == 8);
+
+	// warm-start: continue from the previous flow
+	cost = mcf->solve(mcf, 0, 3, 12, result);
+	printf("solve(amount=12): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == 38 && result->amount == 12);
+
+	// exceeds the max-flow (15)
+	cost = mcf->solve(mcf, 0, 3, 20, result);
+	printf("solve(amount=20): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == -1 && result->amount == 15);
+
+	// restart with a smaller amount
+	cost = mcf->solve(mcf, 0, 3, 4, result);
+	printf("solve(amount=4): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == 8 && result->num_paths == 1);
+
+	// convex costs: 0 -> 1 -> 3 is only cheap for the first half of its capacity
+	min_cost_flow_context_reset(mcf);
+	mcf->get_cost_segments = get_convex_cost_segments;
+	cost = mcf->solve(mcf, 0, 3, 6, result);
+	printf("solve(amount=6, convex): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(result->amount == 6 && result->num_paths == 2);
+
+	int64_t sum = 0;
+	for(size_t i = 0; i < result->num_paths; ++i) sum += result->paths[i].cost;
+	assert(sum == result->cost);
+
+	// the costs change after a solve: the potentials of the old costs must not be reused
+	min_cost_flow_context_reset(mcf);
+	mcf->get_cost_segments = get_default_cost_segments;
+	assert(mcf->solve(mcf, 0, 3, 8, result) == 22);
+	edges->update(edges, 0, 2, 0);
+	edges->update(edges, 2, 3, 0);
+	min_cost_flow_context_reset(mcf);
+	cost = mcf->solve(mcf, 0, 3, 8, result);
+	printf("solve(amount=8, new costs): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == 0 && result->amount == 8 && result->num_paths == 1);
+
+	// the total cost would overflow int64: stop at the flow sent so far
+	edges->update(edges, 0, 2, INT64_MAX / 4);
+	min_cost_flow_context_reset(mcf);
+	cost = mcf->solve(mcf, 0, 3, 12, result);
+	printf("solve(amount=12, huge costs): cost=%ld\n", (long)cost);
+	result_dump(result);
+	assert(cost == -1 && result->amount == 5 && result->cost == 10);
+
+	min_cost_flow_result_cleanup(result);
+	min_cost_flow_context_cleanup(mcf);
+	dijkstra_edges_cleanup(edges);
+	return 0;
+}
+#endif
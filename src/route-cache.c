@@ -0,0 +1,538 @@
+/*
+ * route-cache.c
+ *
+ * Copyright 2022 chehw <hongwei.che@gmail.com>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <stdint.h>
+#include <pthread.h>
+#include "algorithms-c-common.h"
+
+#include "dijkstra.h"
+#include "route-cache.h"
+
+/************************************
+ * route_cache_entry
+************************************/
+struct route_cache_entry
+{
+	uint64_t hash;
+	uint32_t src_id;
+	uint32_t dst_id;
+	int bucket;
+	int referenced;	// CLOCK reference bit
+
+	uint64_t stamp;	// edges->version when the path was found
+	size_t pos;		// index in entries[]
+
+	size_t length;
+	uint32_t vertices[];
+};
+
+static inline size_t route_cache_entry_bytes(size_t length)
+{
+	// entry + path + one pointer in the hash index + one pointer in entries[]
+	return sizeof(struct route_cache_entry) + length * sizeof(uint32_t) + 2 * sizeof(void *);
+}
+
+/************************************
+ * route_cache_index:
+ *   hash index: open addressing (linear probing, backward-shift deletion)
+ *   entries[]:  dense array of all entries, scanned by the CLOCK hand
+************************************/
+struct route_cache_index
+{
+	const struct dijkstra_edges * edges;
+	struct clib_allocator * allocator;
+
+	size_t num_slots;	// power of 2
+	struct route_cache_entry ** slots;
+
+	size_t max_entries;
+	size_t num_entries;
+	struct route_cache_entry ** entries;
+	size_t hand;
+};
+
+static inline uint64_t route_cache_hash(uint32_t src_id, uint32_t dst_id, int bucket)
+{
+	uint64_t h = ((uint64_t)src_id << 32) ^ dst_id ^ ((uint64_t)bucket << 58);
+	// murmur3 finalizer
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+int route_cache_amount_bucket(int64_t amount)
+{
+	if(amount <= 0) return 0;
+	return 64 - __builtin_clzll((uint64_t)amount);
+}
+
+static ssize_t route_cache_index_find(struct route_cache_index * index, uint64_t hash, uint32_t src_id, uint32_t dst_id, int bucket)
+{
+	if(0 == index->num_slots) return -1;
+	size_t mask = index->num_slots - 1;
+	for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+		struct route_cache_entry * entry = index->slots[i];
+		if(NULL == entry) return -1;
+		if(entry->hash == hash && entry->src_id == src_id && entry->dst_id == dst_id && entry->bucket == bucket) return i;
+	}
+	return -1;
+}
+
+static void route_cache_index_insert_slot(struct route_cache_index * index, struct route_cache_entry * entry)
+{
+	size_t mask = index->num_slots - 1;
+	size_t i = entry->hash & mask;
+	while(index->slots[i]) i = (i + 1) & mask;
+	index->slots[i] = entry;
+}
+
+static void route_cache_index_resize(struct route_cache_index * index, size_t num_slots)
+{
+	struct route_cache_entry ** old_slots = index->slots;
+	size_t old_num_slots = index->num_slots;
+
+	index->slots = clib_alloc(index->allocator, num_slots * sizeof(*index->slots));
+	assert(index->slots);
+	index->num_slots = num_slots;
+	for(size_t i = 0; i < old_num_slots; ++i) {
+		if(old_slots[i]) route_cache_index_insert_slot(index, old_slots[i]);
+	}
+	clib_free(index->allocator, old_slots);
+}
+
+static void route_cache_index_add(struct route_cache_index * index, struct route_cache_entry * entry)
+{
+	if((index->num_entries + 1) * 2 > index->num_slots) {
+		route_cache_index_resize(index, index->num_slots?(index->num_slots * 2):64);
+	}
+	route_cache_index_insert_slot(index, entry);
+
+	if(index->num_entries >= index->max_entries) {
+		index->max_entries = index->max_entries?(index->max_entries * 2):64;
+		index->entries = clib_realloc(index->allocator, index->entries, index->max_entries * sizeof(*index->entries));
+		assert(index->entries);
+	}
+	entry->pos = index->num_entries;
+	index->entries[index->num_entries++] = entry;
+}
+
+static void route_cache_index_remove(struct route_cache_index * index, struct route_cache_entry * entry)
+{
+	// remove from the hash index (backward-shift deletion)
+	size_t mask = index->num_slots - 1;
+	size_t i = entry->hash & mask;
+	while(index->slots[i] != entry) {
+		assert(index->slots[i]);
+		i = (i + 1) & mask;
+	}
+	for(size_t j = (i + 1) & mask; index->slots[j]; j = (j + 1) & mask) {
+		size_t home = index->slots[j]->hash & mask;
+		// move slots[j] to i, unless its home is in the cyclic range (i, j]
+		int in_range = (i <= j)?(home > i && home <= j):(home > i || home <= j);
+		if(in_range) continue;
+		index->slots[i] = index->slots[j];
+		i = j;
+	}
+	index->slots[i] = NULL;
+
+	// remove from entries[]
+	assert(entry->pos < index->num_entries && index->entries[entry->pos] == entry);
+	struct route_cache_entry * last = index->entries[--index->num_entries];
+	index->entries[entry->pos] = last;
+	last->pos = entry->pos;
+}
+
+/*
+ * process-wide counters (clib_metrics), the sum of route_cache::stats of all caches
+ */
+static struct
+{
+	int hits;
+	int misses;
+	int inserts;
+	int evictions;
+	int invalidations;
+	int infeasible;
+} s_metrics = { -1, -1, -1, -1, -1, -1 };
+static pthread_once_t s_metrics_once = PTHREAD_ONCE_INIT;
+
+static void register_metrics(void)
+{
+	s_metrics.hits = clib_metrics_register("route_cache_hits_total", "number of valid paths returned from the cache", CLIB_METRICS_COUNTER);
+	s_metrics.misses = clib_metrics_register("route_cache_misses_total", "number of lookups searched with dijkstra", CLIB_METRICS_COUNTER);
+	s_metrics.inserts = clib_metrics_register("route_cache_inserts_total", "number of paths added to the cache", CLIB_METRICS_COUNTER);
+	s_metrics.evictions = clib_metrics_register("route_cache_evictions_total", "number of paths removed to stay within max_bytes", CLIB_METRICS_COUNTER);
+	s_metrics.invalidations = clib_metrics_register("route_cache_invalidations_total", "number of paths removed because of an edge update", CLIB_METRICS_COUNTER);
+	s_metrics.infeasible = clib_metrics_register("route_cache_infeasible_total", "number of paths removed because they can not carry the amount", CLIB_METRICS_COUNTER);
+}
+
+#define route_cache_event(cache, event) do { \
+		++(cache)->stats.event; \
+		if(clib_metrics_register_once(&s_metrics_once, register_metrics)) clib_metrics_count(s_metrics.event, 1); \
+	} while(0)
+
+/************************************
+ * route_cache
+************************************/
+static void route_cache_remove_entry(struct route_cache * cache, struct route_cache_entry * entry)
+{
+	struct route_cache_index * index = cache->priv;
+	route_cache_index_remove(index, entry);
+	cache->used_bytes -= route_cache_entry_bytes(entry->length);
+	clib_free(index->allocator, entry);
+}
+
+static void route_cache_evict(struct route_cache * cache)
+{
+	struct route_cache_index * index = cache->priv;
+	while(index->num_entries > 0) {
+		if(index->hand >= index->num_entries) index->hand = 0;
+		struct route_cache_entry * entry = index->entries[index->hand];
+		if(entry->referenced) { // second chance
+			entry->referenced = 0;
+			++index->hand;
+			continue;
+		}
+		route_cache_remove_entry(cache, entry);
+		route_cache_event(cache, evictions);
+		return;
+	}
+}
+
+static void route_cache_clear(struct route_cache * cache)
+{
+	struct route_cache_index * index = cache->priv;
+	if(NULL == index) return;
+	struct clib_allocator * allocator = index->allocator;
+	for(size_t i = 0; i < index->num_entries; ++i) clib_free(allocator, index->entries[i]);
+	clib_free(allocator, index->entries);
+	clib_free(allocator, index->slots);
+	memset(index, 0, sizeof(*index));
+	index->allocator = allocator;
+	cache->used_bytes = 0;
+}
+
+/*
+ * re-calculate the weight of a cached path for the current amount
+ * @return the weight, or -1 if an edge is missing or can not forward the amount
+ */
+static int64_t route_cache_eval_path(struct dijkstra_context * dijkstra, int reverse,
+	const uint32_t * vertices, size_t length)
+{
+	struct dijkstra_edges * edges = (struct dijkstra_edges *)dijkstra->graph->edges;
+	const int check_capacity = (dijkstra->amount > 0);
+	int64_t amount = dijkstra->amount;
+	int64_t weight = 0;
+
+	for(size_t k = 1; k < length; ++k) {
+		// forward: walk from src, reverse: walk from dst
+		size_t i = reverse?(length - k):k;
+		struct dijkstra_sparse_edge * edge = edges->find(edges, vertices[i - 1], vertices[i]);
+		if(NULL == edge) return -1;
+		if(check_capacity && !dijkstra_sparse_edge_can_forward(edge, amount)) return -1;
+
+		if(dijkstra->calc_weight) weight += dijkstra->calc_weight(amount, edge->user_data);
+		else weight += edge->weight;
+		if(dijkstra->calc_amount) amount = dijkstra->calc_amount(amount, edge->user_data);
+	}
+	return weight;
+}
+
+static int route_cache_path_set(struct route_cache_path * path, int64_t weight, const uint32_t * vertices, size_t length)
+{
+	uint32_t * buffer = realloc(path->vertices, length * sizeof(*buffer));
+	assert(buffer);
+	memcpy(buffer, vertices, length * sizeof(*buffer));
+	path->vertices = buffer;
+	path->length = length;
+	path->weight = weight;
+	return 0;
+}
+
+static int64_t route_cache_shortest_path(struct route_cache * cache, struct dijkstra_context * dijkstra,
+	uint32_t src_id, uint32_t dst_id,
+	struct route_cache_path * path)
+{
+	assert(cache && cache->priv);
+	assert(dijkstra && dijkstra->graph);
+	struct route_cache_index * index = cache->priv;
+	const struct dijkstra_edges * edges = dijkstra->graph->edges;
+	assert(edges->is_sparse_matrix);
+
+	if(index->edges != edges) { // another graph
+		route_cache_clear(cache);
+		index->edges = edges;
+	}
+
+	int bucket = route_cache_amount_bucket(dijkstra->amount);
+	uint64_t hash = route_cache_hash(src_id, dst_id, bucket);
+
+	// step 1. lookup
+	ssize_t slot = route_cache_index_find(index, hash, src_id, dst_id, bucket);
+	if(slot >= 0) {
+		struct route_cache_entry * entry = index->slots[slot];
+		int is_valid = 1;
+		for(size_t i = 0; i + 1 < entry->length; ++i) {
+			if(edges->vertex_versions[entry->vertices[i]] > entry->stamp) {
+				is_valid = 0;
+				break;
+			}
+		}
+		if(!is_valid) {
+			route_cache_remove_entry(cache, entry);
+			route_cache_event(cache, invalidations);
+		}else {
+			int64_t weight = route_cache_eval_path(dijkstra, cache->reverse, entry->vertices, entry->length);
+			if(weight >= 0) {
+				entry->referenced = 1;
+				route_cache_event(cache, hits);
+				if(path) route_cache_path_set(path, weight, entry->vertices, entry->length);
+				return weight;
+			}
+			// the path can not carry this amount, search again and replace it
+			route_cache_remove_entry(cache, entry);
+			route_cache_event(cache, infeasible);
+		}
+	}
+
+	// step 2. search
+	route_cache_event(cache, misses);
+	struct clib_pointer_array candidates[1];
+	memset(candidates, 0, sizeof(candidates));
+
+	int64_t weight = cache->reverse?
+		dijkstra->shortest_path_reverse(dijkstra, src_id, dst_id, candidates):
+		dijkstra->shortest_path(dijkstra, src_id, dst_id, candidates);
+	if(weight < 0 || candidates->length == 0) {
+		clib_pointer_array_cleanup(candidates, NULL);
+		return -1;
+	}
+
+	// step 3. insert
+	size_t length = candidates->length;
+	size_t entry_bytes = route_cache_entry_bytes(length);
+	struct route_cache_entry * entry = clib_alloc(index->allocator, sizeof(*entry) + length * sizeof(uint32_t));
+	assert(entry);
+	entry->hash = hash;
+	entry->src_id = src_id;
+	entry->dst_id = dst_id;
+	entry->bucket = bucket;
+	entry->stamp = edges->version;
+	entry->length = length;
+	for(size_t i = 0; i < length; ++i) {
+		const struct dijkstra_vertex_status * status = candidates->data_ptrs[i];
+		entry->vertices[i] = status->id;
+	}
+	clib_pointer_array_cleanup(candidates, NULL);
+
+	if(path) route_cache_path_set(path, weight, entry->vertices, length);
+	if(entry_bytes > cache->max_bytes) { // too large to be cached
+		clib_free(index->allocator, entry);
+		return weight;
+	}
+
+	while(cache->used_bytes + entry_bytes > cache->max_bytes) route_cache_evict(cache);
+	route_cache_index_add(index, entry);
+	cache->used_bytes += entry_bytes;
+	route_cache_event(cache, inserts);
+	return weight;
+}
+
+void route_cache_path_cleanup(struct route_cache_path * path)
+{
+	if(NULL == path) return;
+	free(path->vertices);
+	memset(path, 0, sizeof(*path));
+}
+
+struct route_cache * route_cache_init(struct route_cache * cache, size_t max_bytes)
+{
+	return route_cache_init_ex(cache, max_bytes, NULL);
+}
+
+struct route_cache * route_cache_init_ex(struct route_cache * cache, size_t max_bytes, struct clib_allocator * allocator)
+{
+	if(NULL == cache) cache = calloc(1, sizeof(*cache));
+	else memset(cache, 0, sizeof(*cache));
+	assert(cache);
+
+	cache->max_bytes = max_bytes;
+	cache->allocator = allocator;
+	struct route_cache_index * index = clib_alloc(allocator, sizeof(*index));
+	assert(index);
+	index->allocator = allocator;
+	cache->priv = index;
+
+	cache->shortest_path = route_cache_shortest_path;
+	cache->clear = route_cache_clear;
+	return cache;
+}
+
+void route_cache_cleanup(struct route_cache * cache)
+{
+	if(NULL == cache) return;
+	route_cache_clear(cache);
+	clib_free(cache->allocator, cache->priv);
+	cache->priv = NULL;
+}
+
+
+/****************************************************
+ * TEST_MODULE::route-cache
+ * build:
+ *   tests/make.sh route-cache
+****************************************************/
+#if defined(TEST_ROUTE_CACHE) && defined(ALGORITHMS_C_STAND_ALONE)
+#define NUM_VERTEXES (9)
+static int64_t s_edges[NUM_VERTEXES][NUM_VERTEXES] = {
+//	  0    1    2    3    4    5    6    7    8
+	{-1,   4,  -1,  -1,  -1,  -1,  -1,   8,  -1},	// 0
+	{ 4,  -1,   8,  -1,  -1,  -1,  -1,  11,  -1},	// 1
+	{-1,   8,  -1,  7,   -1,   4,  -1,  -1,   2},	// 2
+	{-1,  -1,   7,  -1,   9,  14,  -1,  -1,  -1},	// 3
+	{-1,  -1,  -1,   9,  -1,  10,  -1,  -1,  -1},	// 4
+	{-1,  -1,   4,  -1,  10,  -1,   2,  -1,  -1},	// 5
+	{-1,  -1,  -1,  14,  -1,   2,  -1,   1,   6},	// 6
+	{ 8,  11,  -1,  -1,  -1,  -1,   1,  -1,   7},	// 7
+	{-1,  -1,   2,  -1,  -1,  -1,   6,   7,  -1}	// 8
+};
+
+static void stats_dump(const struct route_cache * cache, const char * title)
+{
+	printf("  %-24s hits=%lu, misses=%lu, inserts=%lu, evictions=%lu, invalidations=%lu, infeasible=%lu, used_bytes=%zu\n",
+		title,
+		(unsigned long)cache->stats.hits, (unsigned long)cache->stats.misses,
+		(unsigned long)cache->stats.inserts, (unsigned long)cache->stats.evictions,
+		(unsigned long)cache->stats.invalidations, (unsigned long)cache->stats.infeasible, cache->used_bytes);
+}
+
+static uint64_t s_lookups;
+static int64_t lookup(struct route_cache * cache, struct dijkstra_context * dijkstra, uint32_t src_id, uint32_t dst_id, struct route_cache_path * path)
+{
+	++s_lookups;
+	int64_t weight = cache->shortest_path(cache, dijkstra, src_id, dst_id, path);
+
+	// every lookup is either a hit or a miss, every removed entry is counted once
+	const struct route_cache_stats * stats = &cache->stats;
+	const struct route_cache_index * index = cache->priv;
+	assert(stats->hits + stats->misses == s_lookups);
+	assert(stats->inserts - stats->evictions - stats->invalidations - stats->infeasible == index->num_entries);
+	return weight;
+}
+
+int main(int argc, char **argv)
+{
+	struct dijkstra_edges edges[1];
+	dijkstra_edges_init(edges, 1, NUM_VERTEXES);
+	for(uint32_t i = 0; i < NUM_VERTEXES; ++i) {
+		for(uint32_t j = 0; j < NUM_VERTEXES; ++j) {
+			if(s_edges[i][j] > 0) edges->update(edges, i, j, s_edges[i][j]);
+		}
+	}
+	struct dijkstra_graph graph[1] = {{ .num_vertices = NUM_VERTEXES, .edges = edges }};
+	struct dijkstra_context dijkstra[1];
+	dijkstra_context_init(dijkstra, graph, NULL);
+
+	struct clib_tracking_allocator tracker[1];
+	clib_tracking_allocator_init(tracker, NULL);
+	struct route_cache cache[1];
+	route_cache_init_ex(cache, 4096, tracker->base);
+	struct route_cache_path path[1];
+	memset(path, 0, sizeof(path));
+
+	dijkstra->amount = 1000;
+	int64_t weight = lookup(cache, dijkstra, 0, 4, path);
+	assert(weight == 21 && cache->stats.misses == 1);
+	stats_dump(cache, "first query:");
+
+	// same bucket ==> hit
+	dijkstra->amount = 1020;
+	weight = lookup(cache, dijkstra, 0, 4, path);
+	assert(weight == 21 && cache->stats.hits == 1);
+	stats_dump(cache, "similar amount:");
+
+	// an edge which is not on the path
+	edges->update(edges, 3, 4, 9);
+	weight = lookup(cache, dijkstra, 0, 4, path);
+	assert(weight == 21 && cache->stats.hits == 2);
+	stats_dump(cache, "unrelated update:");
+
+	// an edge on the path [0 -> 7 -> 6 -> 5 -> 4]
+	edges->update(edges, 6, 5, 20);
+	weight = lookup(cache, dijkstra, 0, 4, path);
+	printf("  weight=%ld, path: ", (long)weight);
+	for(size_t i = 0; i < path->length; ++i) printf("%s%u", i?" ==> ":"", path->vertices[i]);
+	printf("\n");
+	assert(cache->stats.invalidations == 1 && cache->stats.misses == 2);
+	stats_dump(cache, "invalidated:");
+
+	// fill the cache to trigger evictions
+	for(uint32_t i = 0; i < NUM_VERTEXES; ++i) {
+		for(uint32_t j = 0; j < NUM_VERTEXES; ++j) {
+			if(i != j) lookup(cache, dijkstra, i, j, path);
+		}
+	}
+	stats_dump(cache, "all pairs:");
+	assert(cache->used_bytes <= cache->max_bytes && cache->stats.evictions > 0);
+
+	// a cached path which can not carry a larger amount of the same bucket: [0 -> 7 -> 6]
+	edges->set_capacity(edges, 7, 6, 1010, 0, DIJKSTRA_CAPACITY_UNLIMITED);
+	dijkstra->amount = 1000;
+	weight = lookup(cache, dijkstra, 0, 6, path);
+	assert(weight == 9 && path->length == 3);
+	dijkstra->amount = 1020;
+	weight = lookup(cache, dijkstra, 0, 6, path);
+	assert(weight > 9 && cache->stats.infeasible == 1);
+	stats_dump(cache, "infeasible:");
+
+	// process-wide counters
+	clib_metrics_enable(1);
+	struct route_cache_stats stats = cache->stats;
+	lookup(cache, dijkstra, 0, 4, path);
+	lookup(cache, dijkstra, 0, 4, path);
+	assert(clib_metrics_counter_value(clib_metrics_find("route_cache_hits_total")) == cache->stats.hits - stats.hits);
+	assert(clib_metrics_counter_value(clib_metrics_find("route_cache_misses_total")) == cache->stats.misses - stats.misses);
+	clib_metrics_dump(stdout, CLIB_METRICS_FORMAT_JSON);
+	clib_metrics_enable(0);
+
+	route_cache_path_cleanup(path);
+	route_cache_cleanup(cache);
+	assert(tracker->live_bytes == 0 && tracker->live_blocks == 0 && tracker->num_allocs > 0);
+	dijkstra_context_cleanup(dijkstra);
+	dijkstra_edges_cleanup(edges);
+	return 0;
+}
+#endif
@@ -14,11 +14,70 @@ LINKER="gcc -std=gnu99 -g ${DEBUG} -Wall -Iinclude -Iutils -Itests -D_DEFAULT_SO
 case "${target}" in 
 	dijkstra-shortest-path|dijkstra)
 		echo "build $target ..."
-		${LINKER} -DTEST_DIJKSTRA_SHORTEST_PATH -DALGORITHMS_C_STAND_ALONE \
+		${LINKER} -DTEST_DIJKSTRA_SHORTEST_PATH -DALGORITHMS_C_STAND_ALONE -DDIJKSTRA_ENABLE_STATS \
 			-o tests/${target} \
 			src/dijkstra-shortest-path.c src/base/*.c \
 			-lm -lpthread
 		;;
+	min-cost-flow)
+		${LINKER} -DTEST_MIN_COST_FLOW -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/min-cost-flow.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm -lpthread
+		;;
+	max-flow)
+		${LINKER} -DTEST_MAX_FLOW -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/max-flow.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm -lpthread
+		;;
+	dijkstra-pareto)
+		${LINKER} -DTEST_DIJKSTRA_PARETO -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/dijkstra-pareto.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm
+		;;
+	route-cache)
+		${LINKER} -DTEST_ROUTE_CACHE -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/route-cache.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm -lpthread
+		;;
+	dijkstra-reorder)
+		${LINKER} -DTEST_DIJKSTRA_REORDER -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/dijkstra-reorder.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm -lpthread
+		;;
+	dijkstra-compressed)
+		${LINKER} -DTEST_DIJKSTRA_COMPRESSED -DALGORITHMS_C_STAND_ALONE \
+			-o tests/${target} \
+			src/dijkstra-compressed.c src/dijkstra-shortest-path.c src/base/*.c \
+			-lm -lpthread
+		;;
+	mpmc-queue|clib-mpmc-queue)
+		${LINKER} -O2 -DTEST_CLIB_MPMC_QUEUE -DALGORITHMS_C_STAND_ALONE \
+			-o tests/mpmc-queue \
+			src/base/*.c \
+			-lpthread
+		;;
+	scheduler|clib-scheduler)
+		${LINKER} -O2 -DTEST_CLIB_SCHEDULER -DALGORITHMS_C_STAND_ALONE \
+			-o tests/scheduler \
+			src/base/*.c \
+			-lpthread -lm
+		;;
+	heap|clib-heap)
+		${LINKER} -O2 -DTEST_CLIB_HEAP -DALGORITHMS_C_STAND_ALONE \
+			-o tests/heap \
+			src/base/*.c
+		;;
+	metrics|clib-metrics)
+		${LINKER} -DTEST_CLIB_METRICS -DALGORITHMS_C_STAND_ALONE \
+			-o tests/metrics \
+			src/base/*.c \
+			-lpthread -lm
+		;;
 	common|clib-stack|clib-slist|clib-*)
 		${LINKER} -DTEST_ALGORITHMS_C_COMMON -DALGORITHMS_C_STAND_ALONE \
 			-o tests/test_common src/common.c src/base/*.c